@@ -4,6 +4,10 @@
 #include "ArticulatedFigure.h"
 #include "Vec3.h"
 #include "Spline.h"
+#include "CompiledSpline.h"
+#include "ArcLengthTable.h"
+#include "PathRegistry.h"
+#include "StreamingPath.h"
 #include <vector>
 
 struct AnimationState
@@ -13,10 +17,14 @@ struct AnimationState
     float walkCycle;      // Phase of walking cycle [0, 2*PI]
     float walkSpeed;      // Speed multiplier
     float animationSpeed; // Overall animation speed multiplier
+    float distance;       // Distance travelled along the path (constant-speed mode)
     
     AnimationState();
 };
 
+// Leg angles of the walking gait at a phase of its cycle
+void applyGaitPhase(ArticulatedFigure &figure, float walkCycle);
+
 // Update the walking animation
 void updateWalkingAnimation(
     ArticulatedFigure &figure,
@@ -26,4 +34,81 @@ void updateWalkingAnimation(
     float deltaTime
 );
 
+// Update the walking animation along a precompiled path
+void updateWalkingAnimation(
+    ArticulatedFigure &figure,
+    AnimationState &state,
+    const CompiledSpline &path,
+    float deltaTime
+);
+
+// Update the walking animation at constant speed along the path.
+// Covers the path in the same time as the parameter-based update, but
+// advances by distance so the figure's speed no longer depends on
+// control-point spacing.
+void updateWalkingAnimation(
+    ArticulatedFigure &figure,
+    AnimationState &state,
+    const CompiledSpline &path,
+    const ArcLengthTable &arcLength,
+    float deltaTime
+);
+
+// Put a walker a fraction phase in [0, 1] of the way along the path (by parameter)
+void placeOnPath(
+    ArticulatedFigure &figure,
+    AnimationState &state,
+    const CompiledSpline &path,
+    float phase
+);
+
+// Put a walker a fraction phase in [0, 1] of the path length from the start
+void placeOnPath(
+    ArticulatedFigure &figure,
+    AnimationState &state,
+    const CompiledSpline &path,
+    const ArcLengthTable &arcLength,
+    float phase
+);
+
+// Update a walker on its shared path: the time step is scaled by the
+// walker's speed, and the figure is kept lateralOffset to the right of the path
+void updateWalkingAnimation(
+    ArticulatedFigure &figure,
+    AnimationState &state,
+    const WalkerPath &walker,
+    const PathRegistry &paths,
+    float deltaTime
+);
+
+// Put a walker a fraction phase in [0, 1] along its shared path (by distance
+// for constant-speed walkers) and take the path's dt
+void placeOnPath(
+    ArticulatedFigure &figure,
+    AnimationState &state,
+    const WalkerPath &walker,
+    const PathRegistry &paths,
+    float phase
+);
+
+// Update a walker on a streaming path. The cursor advances state.dt
+// segments per unit of animation time and waits at the end of the newest
+// segment until the stream delivers the next one.
+void updateWalkingAnimation(
+    ArticulatedFigure &figure,
+    AnimationState &state,
+    const StreamingPath &path,
+    StreamCursor &cursor,
+    float deltaTime
+);
+
+// Put a walker at a cursor on an available segment of a streaming path and
+// take the stream's dt
+void placeOnPath(
+    ArticulatedFigure &figure,
+    AnimationState &state,
+    const StreamingPath &path,
+    const StreamCursor &cursor
+);
+
 #endif // ANIMATION_H
\ No newline at end of file
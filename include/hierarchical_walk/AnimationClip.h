@@ -0,0 +1,119 @@
+#ifndef ANIMATION_CLIP_H
+#define ANIMATION_CLIP_H
+
+#include "Animation.h"
+#include "ArcLengthTable.h"
+#include "ArticulatedFigure.h"
+#include "CompiledSpline.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Pose channels of a clip, one track each
+enum ClipTrack
+{
+    CLIP_POSITION_X,
+    CLIP_POSITION_Y,
+    CLIP_POSITION_Z,
+    CLIP_FORWARD_X,
+    CLIP_FORWARD_Y,
+    CLIP_FORWARD_Z,
+    CLIP_BODY_TILT,
+    CLIP_WALK_CYCLE, // Gait phase in radians, unwrapped
+    CLIP_TRACK_COUNT
+};
+
+const int CLIP_BLOCK_FRAMES = 32;            // Frames per key mask; a block's first frame is always a key
+const uint32_t MAX_CLIP_FRAMES = 1u << 22;   // Longest loop a clip may hold
+
+// Largest difference allowed between the baked and the live pose, per kind of track
+struct ClipTolerance
+{
+    float position;  // World units
+    float direction; // Components of the unit forward vector
+    float angle;     // Degrees, for tilt and joint angles
+
+    ClipTolerance();
+};
+
+// Value range of one track; keys store 16-bit steps of scale above minimum
+struct ClipTrackRange
+{
+    float minimum;
+    float scale;
+
+    ClipTrackRange();
+};
+
+// One loop of the walk along a path, baked from updateWalkingAnimation.
+// Frame 0 is the pose placed at the start of the path and frame i the pose
+// after i fixed steps. The loop ends inside the last step, where the path
+// wraps, so the last frame is the first step of the next loop. The gait is
+// stored as its phase, which grows by the same amount every loop; sample()
+// adds that amount per completed loop and derives the leg angles from the
+// phase, so the legs carry on across the wrap instead of jumping.
+// Only key frames are stored, with all tracks quantized to 16 bits and
+// interleaved; poses between keys are linear. A 32-bit mask per block of
+// frames marks the keys, so the keys around any time are found with a
+// popcount instead of a search and sampling costs the same for any clip.
+class AnimationClip
+{
+public:
+    AnimationClip();
+
+    // Step a walker from the start of the path once around it and compress
+    // the poses. arcLength selects constant-speed walking; nullptr walks by
+    // parameter. Fails if the loop would exceed MAX_CLIP_FRAMES.
+    bool bake(
+        const CompiledSpline &path,
+        const ArcLengthTable *arcLength,
+        const AnimationState &initial,
+        float stepSeconds,
+        const ClipTolerance &tolerance
+    );
+
+    bool isValid() const { return frameCount > 1; }
+
+    // Pose at a time in seconds; loops with the path
+    void sample(double seconds, ArticulatedFigure &figure) const;
+
+    // Length of one loop in seconds
+    double duration() const { return loopSeconds; }
+    uint32_t frames() const { return frameCount; }
+    float stepSeconds() const { return frameSeconds; }
+
+    size_t keyCount() const { return keys.size() / CLIP_TRACK_COUNT; }
+    size_t memoryBytes() const; // Key data held in memory
+
+    // Largest error of a track against the live poses, measured by bake()
+    // from the start of the path until a block of frames past the wrap
+    float maxError(ClipTrack track) const { return errors[track]; }
+
+    // Compact binary clip file
+    bool save(const char *filename) const;
+    bool load(const char *filename);
+
+private:
+    // Key before frame, the frames of it and the next key, and its index
+    void findKeys(uint32_t frame, uint32_t &frame0, uint32_t &frame1, uint32_t &index) const;
+
+    // Decode every track a fraction alpha of the way from key index to index + 1
+    void decode(uint32_t index, float alpha, float *values) const;
+
+    // Tracks at a time in seconds, and the gait phase with the completed loops added
+    double sampleTracks(double seconds, float *values) const;
+
+    void buildKeyOffsets();
+
+    ClipTrackRange ranges[CLIP_TRACK_COUNT];
+    std::vector<uint32_t> keyMasks;   // Bit i: frame block * CLIP_BLOCK_FRAMES + i is a key
+    std::vector<uint32_t> keyOffsets; // Index of each block's first key; rebuilt on load
+    std::vector<uint16_t> keys;       // CLIP_TRACK_COUNT values per key
+    float errors[CLIP_TRACK_COUNT];
+    uint32_t frameCount;
+    float frameSeconds;
+    double loopSeconds;
+    double cyclePerLoop; // Gait phase covered in one loop
+};
+
+#endif // ANIMATION_CLIP_H
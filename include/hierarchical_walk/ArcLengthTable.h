@@ -0,0 +1,57 @@
+#ifndef ARC_LENGTH_TABLE_H
+#define ARC_LENGTH_TABLE_H
+
+#include "CompiledSpline.h"
+#include <cstddef>
+#include <vector>
+
+// Default resolution of the cumulative length table
+const int DEFAULT_ARC_SAMPLES_PER_SEGMENT = 16;
+
+// Arc-length reparameterization of a compiled path.
+// Maps distance travelled along the path to the spline parameter t and back.
+class ArcLengthTable
+{
+public:
+    ArcLengthTable();
+
+    // Integrate |dp/dt| over the whole path; samplesPerSegment sets the table resolution
+    void build(const CompiledSpline &path, int samplesPerSegment = DEFAULT_ARC_SAMPLES_PER_SEGMENT);
+
+    // Rebuild for path after edit, integrating only the recompiled segments
+    // and taking the lengths of the others from previous, the table of the
+    // path before the edit. Falls back to build() if previous does not match.
+    void update(const CompiledSpline &path, const ArcLengthTable &previous, const SplineEdit &edit);
+
+    bool isValid() const { return !distances.empty(); }
+
+    // The table was built from an older version of the path
+    bool isStale(const CompiledSpline &path) const { return path.version() != sourceVersion; }
+
+    float totalLength() const { return length; }
+
+    // Parameter t at distance s from the start: binary search over the cumulative table
+    float parameterAtDistance(float s) const;
+
+    // Parameter t at distance s from the start: constant-time lookup in the uniformly resampled table
+    float parameterAtDistanceUniform(float s) const;
+
+    // Distance from the start to parameter t
+    float distanceAtParameter(float t) const;
+
+    // Heap bytes held by the two tables
+    size_t memoryBytes() const { return (distances.capacity() + uniformParameters.capacity()) * sizeof(float); }
+
+private:
+    void resample();
+
+    // t at distance s, which lies between entries i - 1 and i
+    float parameterInInterval(int i, float s) const;
+
+    std::vector<float> distances;         // Cumulative length at t = i / (distances.size() - 1)
+    std::vector<float> uniformParameters; // t at uniformly spaced distances
+    float length;
+    unsigned sourceVersion;
+};
+
+#endif // ARC_LENGTH_TABLE_H
@@ -1,7 +1,9 @@
 #ifndef ARTICULATED_FIGURE_H
 #define ARTICULATED_FIGURE_H
 
+#include "Skeleton.h"
 #include "Vec3.h"
+#include <vector>
 
 struct ArticulatedFigure
 {
@@ -16,4 +18,49 @@ struct ArticulatedFigure
     ArticulatedFigure();
 };
 
+// Pose between a and b; alpha 0 gives a, 1 gives b
+ArticulatedFigure interpolateFigure(const ArticulatedFigure &a, const ArticulatedFigure &b, float alpha);
+
+// Blend every figure; figures missing from previous are copied from current
+void interpolateFigures(
+    const std::vector<ArticulatedFigure> &previous,
+    const std::vector<ArticulatedFigure> &current,
+    float alpha,
+    std::vector<ArticulatedFigure> &out
+);
+
+// Joints of the figure skeleton, parents first
+enum FigureJoint
+{
+    JOINT_PELVIS, // Torso base; tilts about x
+    JOINT_LEFT_HIP,
+    JOINT_LEFT_KNEE,
+    JOINT_LEFT_ANKLE,
+    JOINT_RIGHT_HIP,
+    JOINT_RIGHT_KNEE,
+    JOINT_RIGHT_ANKLE,
+    FIGURE_JOINT_COUNT
+};
+
+// Shapes the figure's parts are drawn with
+enum FigureShape
+{
+    SHAPE_TORSO,
+    SHAPE_THIGH,
+    SHAPE_KNEE,
+    SHAPE_SHIN,
+    SHAPE_FOOT,
+    FIGURE_SHAPE_COUNT
+};
+
+// Skeleton and parts of the walking figure, built on first use
+const Skeleton &figureSkeleton();
+const std::vector<SkeletonPart> &figureParts();
+
+// Places the skeleton on the path, facing forward
+Mat4 figureRootTransform(const ArticulatedFigure &figure);
+
+// World transform of every joint for a pose (FIGURE_JOINT_COUNT entries)
+void computeFigureJoints(const ArticulatedFigure &figure, Mat4 *world);
+
 #endif // ARTICULATED_FIGURE_H
\ No newline at end of file
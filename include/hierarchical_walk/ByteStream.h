@@ -0,0 +1,85 @@
+#ifndef BYTE_STREAM_H
+#define BYTE_STREAM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Little binary serializers shared by the replay and clip file formats.
+// Values are stored in native (little-endian) byte order, like binary paths.
+struct ByteWriter
+{
+    std::vector<uint8_t> bytes;
+
+    void put(const void *data, size_t size)
+    {
+        const uint8_t *p = (const uint8_t *)data;
+        bytes.insert(bytes.end(), p, p + size);
+    }
+    void putU8(uint8_t value) { bytes.push_back(value); }
+    void putU16(uint16_t value) { put(&value, sizeof(value)); }
+    void putU32(uint32_t value) { put(&value, sizeof(value)); }
+    void putU64(uint64_t value) { put(&value, sizeof(value)); }
+    void putFloat(float value) { put(&value, sizeof(value)); }
+
+    // 7 bits per byte, high bit set on all but the last
+    void putVarint(uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            bytes.push_back((uint8_t)(value | 0x80));
+            value >>= 7;
+        }
+        bytes.push_back((uint8_t)value);
+    }
+};
+
+// Reads fail softly: once past the end, ok stays false and values are zero
+struct ByteReader
+{
+    const uint8_t *p;
+    const uint8_t *end;
+    bool ok;
+
+    ByteReader(const char *data, size_t size)
+        : p((const uint8_t *)data), end((const uint8_t *)data + size), ok(true)
+    {
+    }
+
+    size_t remaining() const { return (size_t)(end - p); }
+
+    bool get(void *data, size_t size)
+    {
+        if (!ok || remaining() < size)
+        {
+            ok = false;
+            memset(data, 0, size);
+            return false;
+        }
+        memcpy(data, p, size);
+        p += size;
+        return true;
+    }
+    uint8_t getU8() { uint8_t v; get(&v, sizeof(v)); return v; }
+    uint16_t getU16() { uint16_t v; get(&v, sizeof(v)); return v; }
+    uint32_t getU32() { uint32_t v; get(&v, sizeof(v)); return v; }
+    uint64_t getU64() { uint64_t v; get(&v, sizeof(v)); return v; }
+    float getFloat() { float v; get(&v, sizeof(v)); return v; }
+
+    uint64_t getVarint()
+    {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            uint8_t byte = getU8();
+            value |= (uint64_t)(byte & 0x7f) << shift;
+            if (!(byte & 0x80))
+                return value;
+        }
+        ok = false;
+        return 0;
+    }
+};
+
+#endif // BYTE_STREAM_H
@@ -0,0 +1,109 @@
+#ifndef COMPILED_SPLINE_H
+#define COMPILED_SPLINE_H
+
+#include "Vec3.h"
+#include "Spline.h"
+#include "SplineEngine.h"
+#include <cstddef>
+#include <vector>
+
+// Coefficients of the segment shaped by p0..p3, in the basis of type
+SplineSegment compileSegment(const Vec3 &p0, const Vec3 &p1, const Vec3 &p2, const Vec3 &p3, SplineType type);
+
+// Position, derivatives and curvature at one path parameter
+struct SplineSample
+{
+    Vec3 position;
+    Vec3 tangent;          // Unit tangent, zero where the curve is stationary
+    Vec3 firstDerivative;  // dp/dt
+    Vec3 secondDerivative; // d2p/dt2
+    float curvature;       // Inverse radius of the osculating circle
+};
+
+// Segments an edit of the control points left alone. The first `front`
+// segments kept their index; the last `back` kept their four points but
+// moved by the change in segment count. The rest were recompiled.
+struct SplineEdit
+{
+    int front;
+    int back;
+    int oldCount; // Segments before the edit
+    int newCount; // Segments after the edit
+
+    SplineEdit();
+
+    int rebuilt() const { return newCount - front - back; }
+
+    // Index before the edit of segment i, or -1 if it was recompiled
+    int previousSegment(int i) const;
+};
+
+// Spline with the polynomial coefficients of every segment precomputed.
+// Every spline type compiles to the same cubic form, so evaluation never
+// depends on the type. Owns a copy of its control points; every change rebuilds the affected
+// segments and assigns a new version() so caches built from the spline
+// can tell they are stale.
+class CompiledSpline
+{
+public:
+    CompiledSpline();
+    CompiledSpline(const std::vector<Vec3> &points, SplineType type);
+
+    // Replace all control points and rebuild every segment
+    void setControlPoints(const std::vector<Vec3> &points, SplineType type);
+    void setControlPoints(const Vec3 *points, size_t count, SplineType type);
+
+    // Move one control point and rebuild only the segments that use it
+    void setControlPoint(size_t index, const Vec3 &point);
+
+    // Replace all control points but recompile only the segments whose four
+    // points changed. Points are compared exactly, so a file saved after
+    // editing a few lines costs only the segments around those lines, even
+    // when points were inserted or removed.
+    SplineEdit updateControlPoints(const Vec3 *points, size_t count, SplineType type);
+
+    // Drop all points and coefficients
+    void clear();
+
+    // At least one segment (four control points) is available
+    bool isValid() const { return !segments.empty(); }
+
+    // Position at global parameter t in [0, 1], same parameterization as evaluateCatmullRom
+    Vec3 evaluate(float t) const;
+
+    // Position at local parameter u in [0, 1] of one segment
+    Vec3 evaluateSegment(int segment, float u) const;
+
+    // Closed-form derivatives with respect to the global parameter t
+    Vec3 derivative(float t) const;
+    Vec3 secondDerivative(float t) const;
+
+    // Position, unit tangent and curvature from a single segment lookup
+    SplineSample sample(float t) const;
+
+    // Derivative with respect to the local parameter u of one segment
+    Vec3 segmentDerivative(int segment, float u) const;
+    Vec3 segmentSecondDerivative(int segment, float u) const;
+
+    // Map global t to a segment index and local parameter
+    void locate(float t, int &segment, float &u) const;
+
+    int segmentCount() const { return (int)segments.size(); }
+    const SplineSegment &segment(int i) const { return segments[i]; }
+    const std::vector<Vec3> &controlPoints() const { return points; }
+    SplineType type() const { return splineType; }
+    unsigned version() const { return buildVersion; }
+
+private:
+    void buildSegment(int i);
+
+    std::vector<Vec3> points;
+    std::vector<SplineSegment> segments;
+    SplineType splineType;
+    unsigned buildVersion;
+};
+
+// Get tangent vector for forward direction
+Vec3 getSplineTangent(const CompiledSpline &spline, float t);
+
+#endif // COMPILED_SPLINE_H
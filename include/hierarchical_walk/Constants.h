@@ -20,6 +20,10 @@ const float DEFAULT_DT = 0.01f;
 const float DEFAULT_WALK_SPEED = 0.3f;
 const float DEFAULT_ANIMATION_SPEED = 0.5f;
 
+// Walking gait
+const float HIP_SWING = 30.0f; // Maximum hip angle in degrees
+const float KNEE_BEND = 20.0f; // Maximum knee bend in degrees
+
 // Camera defaults
 const float DEFAULT_CAMERA_DISTANCE = 8.0f;
 const float DEFAULT_CAMERA_ANGLE_X = 20.0f;
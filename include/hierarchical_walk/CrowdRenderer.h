@@ -0,0 +1,36 @@
+#ifndef CROWD_RENDERER_H
+#define CROWD_RENDERER_H
+
+#include "ArticulatedFigure.h"
+#include <vector>
+
+// World transforms of every body part of a crowd, one column-major
+// 4x4 matrix (16 floats) per instance, grouped by shape. Within a shape,
+// instances follow figure order, then figureParts() order (left before right).
+struct CrowdInstances
+{
+    std::vector<float> shapes[FIGURE_SHAPE_COUNT]; // Indexed by FigureShape
+    int figures = 0;
+
+    int figureCount() const { return figures; }
+};
+
+// Compute the part transforms drawFigure uses, from the figure skeleton.
+// Pure CPU work; needs no GL context.
+void computeCrowdInstances(const std::vector<ArticulatedFigure> &figures, CrowdInstances &instances);
+
+// Compile the instancing shader and create the instance buffer.
+// Returns false when hardware instancing (OpenGL 3.3) is unavailable;
+// drawCrowd then uses the fixed-function fallback.
+bool initCrowdRenderer();
+void releaseCrowdRenderer();
+
+// Hardware instancing is ready for use
+bool crowdInstancingAvailable();
+
+// Draw every figure. With instancing each part mesh is drawn once for the
+// whole crowd; otherwise each part is drawn with its precomputed matrix.
+// Returns the number of draw calls issued.
+int drawCrowd(const std::vector<ArticulatedFigure> &figures, bool useInstancing);
+
+#endif // CROWD_RENDERER_H
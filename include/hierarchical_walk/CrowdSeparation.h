@@ -0,0 +1,61 @@
+#ifndef CROWD_SEPARATION_H
+#define CROWD_SEPARATION_H
+
+#include "JobSystem.h"
+#include "SpatialHash.h"
+#include "Vec3.h"
+#include <vector>
+
+struct SeparationSettings
+{
+    float radius;      // Walkers closer than this on the ground push apart
+    float pushSpeed;   // Offset speed at full overlap, units per second
+    float returnRate;  // Share of the offset given back to the path per second
+    float maxOffset;   // Furthest a walker strays from its path
+    int maxNeighbors;  // Neighbors that push one walker, bounding the cost in dense crowds
+
+    SeparationSettings();
+};
+
+// Local avoidance for walkers that share or cross paths. Each walker carries
+// an offset from its point on the path; every tick the walkers are bucketed
+// in a SpatialHash and each offset is pushed away from neighbors within the
+// radius and eased back towards the path. The gait still runs on the path
+// point, so the offset moves the figure without changing its stride.
+class CrowdSeparation
+{
+public:
+    explicit CrowdSeparation(const SeparationSettings &settings = SeparationSettings());
+
+    // Zero offsets for walkerCount walkers
+    void reset(size_t walkerCount);
+
+    size_t size() const { return offsets.size(); }
+    const Vec3 &offset(size_t walker) const { return offsets[walker]; }
+    const SeparationSettings &settings() const { return config; }
+
+    // pathPositions[i] is walker i's point on its path after this tick's
+    // update. The grid is built over where the walkers stand (path point plus
+    // offset), then every offset moves. Offsets depend only on the inputs,
+    // not on how chunks are spread over threads.
+    void update(
+        const std::vector<Vec3> &pathPositions,
+        float deltaTime,
+        JobSystem *jobs = nullptr,
+        size_t chunkSize = DEFAULT_JOB_CHUNK_SIZE
+    );
+
+private:
+    // Starts on a cache line, so the update's chunks of it never share one
+    typedef std::vector<Vec3, CacheAlignedAllocator<Vec3> > OffsetArray;
+
+    void updateRange(float deltaTime, size_t begin, size_t end);
+
+    SeparationSettings config;
+    SpatialHash grid;
+    std::vector<Vec3> positions; // Where each walker stands this tick
+    OffsetArray offsets;
+    OffsetArray nextOffsets;     // Written by the update, swapped in after
+};
+
+#endif // CROWD_SEPARATION_H
@@ -0,0 +1,81 @@
+#ifndef CROWD_STATE_H
+#define CROWD_STATE_H
+
+#include "ArticulatedFigure.h"
+#include "Animation.h"
+#include "CompiledSpline.h"
+#include "JobSystem.h"
+#include <cstddef>
+#include <vector>
+
+// Per-walker array starting on a cache line, so cache-aligned chunks of
+// walkers updated on different threads never share a line
+typedef std::vector<float, CacheAlignedAllocator<float> > CrowdArray;
+
+// Structure-of-arrays state for many walkers sharing one path.
+// Element i of every array belongs to walker i.
+struct CrowdState
+{
+    // Figure pose
+    CrowdArray positionX, positionY, positionZ;
+    CrowdArray forwardX, forwardY, forwardZ;
+    CrowdArray bodyTilt;
+    CrowdArray leftHipAngle, rightHipAngle;
+    CrowdArray leftKneeAngle, rightKneeAngle;
+
+    // Animation state
+    CrowdArray t;
+    CrowdArray dt;
+    CrowdArray walkCycle;
+    CrowdArray walkSpeed;
+    CrowdArray animationSpeed;
+
+    size_t size() const { return t.size(); }
+    void clear();
+
+    // Append a walker / copy a walker in and out of the arrays
+    void addWalker(const ArticulatedFigure &figure, const AnimationState &state);
+    void setWalker(size_t i, const ArticulatedFigure &figure, const AnimationState &state);
+    ArticulatedFigure getFigure(size_t i) const;
+    AnimationState getAnimationState(size_t i) const;
+};
+
+// Vectorized equivalent of calling updateWalkingAnimation on every walker.
+// Uses AVX or SSE2 when the compiler targets them, scalar code otherwise;
+// every path gives bit-identical results to updateWalkingAnimation as long
+// as multiply-adds are not fused (the build passes -ffp-contract=off).
+void updateCrowdAnimation(
+    CrowdState &crowd,
+    const CompiledSpline &path,
+    float deltaTime
+);
+
+// Same update split into cache-aligned chunks of about chunkSize walkers
+// across the threads of a job system; returns when every chunk is done
+void updateCrowdAnimation(
+    CrowdState &crowd,
+    const CompiledSpline &path,
+    float deltaTime,
+    JobSystem &jobs,
+    size_t chunkSize = DEFAULT_JOB_CHUNK_SIZE
+);
+
+// Reference path: runs updateWalkingAnimation on each walker in turn
+void updateCrowdAnimationScalar(
+    CrowdState &crowd,
+    const CompiledSpline &path,
+    float deltaTime
+);
+
+// Bitwise comparison of walker i against an array-of-structs walker
+bool crowdWalkerMatches(
+    const CrowdState &crowd,
+    size_t i,
+    const ArticulatedFigure &figure,
+    const AnimationState &state
+);
+
+// Name of the instruction set updateCrowdAnimation was compiled for
+const char *crowdKernelName();
+
+#endif // CROWD_STATE_H
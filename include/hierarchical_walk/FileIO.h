@@ -3,14 +3,75 @@
 
 #include "Vec3.h"
 #include "Spline.h"
+#include "CompiledSpline.h"
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 
-// Load control points from file
+// Load control points from a text file. The file is memory-mapped and parsed
+// in place; quiet skips the per-point log lines.
 bool loadControlPoints(
     const char *filename,
     std::vector<Vec3> &controlPoints,
     SplineType &splineType,
-    float &dt
+    float &dt,
+    bool quiet = false
 );
 
-#endif // FILEIO_H
\ No newline at end of file
+// Binary path file: a BinaryPathHeader followed by pointCount packed Vec3
+// values in native (little-endian) byte order
+const char BINARY_PATH_MAGIC[4] = {'H', 'W', 'P', 'B'};
+const uint32_t BINARY_PATH_VERSION = 1;
+
+struct BinaryPathHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t splineType;
+    float dt;
+    uint64_t pointCount;
+};
+
+// Write control points in the binary path format
+bool saveBinaryPath(
+    const char *filename,
+    const std::vector<Vec3> &controlPoints,
+    SplineType splineType,
+    float dt
+);
+
+// Read-only memory mapping of a whole file
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    bool open(const char *filename);
+    void close();
+
+    bool isOpen() const { return opened; }
+    const char *data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    const char *bytes;
+    size_t length;
+    bool opened;
+#ifdef _WIN32
+    void *fileHandle;
+    void *mappingHandle;
+#endif
+};
+
+// Load a text or binary path file (detected by its magic) straight into a
+// compiled spline. Binary files are read without an intermediate copy.
+bool loadPath(const char *filename, CompiledSpline &path, float &dt, bool quiet = false);
+
+// Load a path file again into the spline holding its previous version.
+// Only segments whose control points changed are recompiled; edit says which.
+bool reloadPath(const char *filename, CompiledSpline &path, float &dt, SplineEdit &edit, bool quiet = true);
+
+#endif // FILEIO_H
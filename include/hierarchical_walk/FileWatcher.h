@@ -0,0 +1,39 @@
+#ifndef FILE_WATCHER_H
+#define FILE_WATCHER_H
+
+#include <cstdint>
+#include <string>
+
+// Reports changes to one file. On Linux it watches the file's directory with
+// inotify, so editors that save by renaming a new file over the old one are
+// seen too; elsewhere it polls the modification time and size.
+class FileWatcher
+{
+public:
+    FileWatcher();
+    ~FileWatcher();
+    FileWatcher(const FileWatcher &) = delete;
+    FileWatcher &operator=(const FileWatcher &) = delete;
+
+    bool watch(const std::string &filename);
+    void close();
+    bool isWatching() const { return watching; }
+
+    // Wait up to timeoutMs for the file to be written or replaced; true if it was
+    bool wait(int timeoutMs);
+
+    const std::string &filename() const { return path; }
+
+private:
+    std::string path;
+    std::string name; // Last path component, matched against directory events
+    bool watching;
+#ifdef __linux__
+    int notifyFd;
+#else
+    int64_t modified; // Modification time and size at the last check
+    int64_t size;
+#endif
+};
+
+#endif // FILE_WATCHER_H
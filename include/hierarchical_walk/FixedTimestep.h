@@ -0,0 +1,38 @@
+#ifndef FIXED_TIMESTEP_H
+#define FIXED_TIMESTEP_H
+
+const double DEFAULT_TICK_RATE = 120.0; // Simulation steps per second
+const int DEFAULT_MAX_SUBSTEPS = 5;     // Steps run for one frame before time is dropped
+
+// Turns variable frame times into a whole number of fixed-size steps.
+// Elapsed time collects in an accumulator and is paid out one step at a
+// time; at most maxSubsteps steps are paid per call so a long stall cannot
+// trigger an ever-growing catch-up.
+class FixedTimestep
+{
+public:
+    FixedTimestep(double stepSeconds = 1.0 / DEFAULT_TICK_RATE, int maxSubsteps = DEFAULT_MAX_SUBSTEPS);
+
+    // Add elapsed wall-clock time and return the number of steps to run now
+    int advance(double elapsedSeconds);
+
+    // Time left over in the accumulator as a fraction of a step, in [0, 1)
+    float alpha() const { return (float)(accumulator / step); }
+
+    // Time left over in the accumulator in seconds
+    double remainder() const { return accumulator; }
+
+    // Step size to pass to the simulation; the same value for every step
+    float stepSeconds() const { return (float)step; }
+
+    // Whole steps discarded because of the substep cap
+    long long droppedSteps() const { return dropped; }
+
+private:
+    double step;
+    int maxSubsteps;
+    double accumulator;
+    long long dropped;
+};
+
+#endif // FIXED_TIMESTEP_H
@@ -0,0 +1,60 @@
+#ifndef FOOT_PLANTING_H
+#define FOOT_PLANTING_H
+
+#include "Animation.h"
+#include "ArticulatedFigure.h"
+#include "Vec3.h"
+
+enum FootSide
+{
+    FOOT_LEFT,
+    FOOT_RIGHT,
+    FOOT_COUNT
+};
+
+// Phase of the walk cycle, in radians, over which a foot leaving the ground
+// blends from its planted pose back to the procedural swing
+const float FOOT_RELEASE_PHASE = 0.5f;
+
+enum FootPhase
+{
+    FOOT_SWING,     // Procedural gait pose
+    FOOT_PLANTED,   // Ankle locked to its contact point
+    FOOT_RELEASING  // Just lifted; blending from the planted pose to the gait
+};
+
+// Where one foot touches the ground
+struct FootContact
+{
+    Vec3 point;      // Locked ankle position in world space while planted
+    float hipAngle;  // Last planted angles, blended out after lift-off
+    float kneeAngle;
+    FootPhase phase;
+
+    FootContact();
+};
+
+// Per-walker state of the foot-planting pass
+struct FootPlanting
+{
+    FootContact feet[FOOT_COUNT];
+    float slip; // Distance planted feet were dragged because the stride outran the leg
+
+    FootPlanting();
+};
+
+// Closed-form two-bone solve in the leg's plane. (forward, down) is the
+// target ankle position relative to the hip, thigh and shin are the bone
+// lengths. Angles are in degrees with the skeleton's conventions: hip 0 hangs
+// straight down, positive swings the foot back, knee 0 is straight and
+// positive bends it. Returns false, with the leg fully stretched towards the
+// target, when the target is out of reach.
+bool solveTwoBoneLeg(float forward, float down, float thigh, float shin, float &hipAngle, float &kneeAngle);
+
+// Run after updateWalkingAnimation. A foot entering stance (moving backwards
+// in the walk cycle) is locked where the gait put it; while it stays in
+// stance the hip and knee angles are re-solved so the ankle stays on that
+// point. No iteration and no allocation.
+void applyFootPlanting(ArticulatedFigure &figure, const AnimationState &state, FootPlanting &planting);
+
+#endif // FOOT_PLANTING_H
@@ -0,0 +1,96 @@
+#ifndef FRAME_EXPORTER_H
+#define FRAME_EXPORTER_H
+
+#include <GL/glew.h>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Pixel layouts an exported frame can be written in
+enum FrameFormat
+{
+    FRAME_RAW, // Packed RGB24, top row first, no header
+    FRAME_PPM, // Binary PPM (P6) per frame
+    FRAME_Y4M  // YUV4MPEG2 stream, 4:4:4 BT.601
+};
+
+const int FRAME_READBACK_BUFFERS = 3; // Frames in flight between draw and write
+const int FRAME_WRITE_QUEUE = 4;      // Frames waiting for the writer thread
+
+// Parse "raw", "ppm" or "y4m"
+bool parseFrameFormat(const char *name, FrameFormat &format);
+
+// Renders frames into an offscreen framebuffer and streams them out.
+// Each frame is read back into one of a ring of pixel buffer objects, so the
+// copy of frame N runs on the GPU while frame N+1 is drawn; a frame is only
+// mapped once newer ones have been queued behind it. Conversion and file
+// writes happen on a separate writer thread.
+class FrameExporter
+{
+public:
+    FrameExporter();
+    ~FrameExporter();
+    FrameExporter(const FrameExporter &) = delete;
+    FrameExporter &operator=(const FrameExporter &) = delete;
+
+    // output is a file, a printf pattern with one integer field (one file per
+    // frame), "-" for stdout, or "|command" to pipe into a program.
+    // Needs a current GL context with framebuffer object support.
+    bool open(const char *output, FrameFormat format, int width, int height, int fps);
+
+    // Bind the offscreen framebuffer and viewport; draw the frame after this
+    void beginFrame();
+
+    // Queue readback of the frame just drawn
+    void endFrame();
+
+    // Write every queued frame and release everything; false if a write failed
+    bool close();
+
+    int framesQueued() const { return frameCount; }
+
+private:
+    void collectFrame(int slot);
+    std::vector<uint8_t> *acquireBuffer();
+    void writerLoop();
+    bool writeFrame(const std::vector<uint8_t> &rgba, int index);
+    bool writeToStream(FILE *stream, const std::vector<uint8_t> &rgba);
+
+    int width;
+    int height;
+    int fps;
+    FrameFormat format;
+    int frameCount;
+    bool usePixelBuffers;
+
+    GLuint framebuffer;
+    GLuint colorBuffer;
+    GLuint depthBuffer;
+    GLuint pixelBuffers[FRAME_READBACK_BUFFERS];
+    std::deque<int> inFlight; // Ring slots with a readback pending, oldest first
+
+    // Output
+    std::string outputPattern; // Set when writing one file per frame
+    FILE *stream;
+    bool streamIsPipe;
+    bool streamIsStdout;
+    bool headerWritten;
+    std::vector<uint8_t> converted; // Writer-thread scratch for the output layout
+
+    // Writer thread and the buffers shared with it
+    std::thread writer;
+    std::mutex queueMutex;
+    std::condition_variable queueCondition;
+    std::deque<std::pair<std::vector<uint8_t> *, int> > writeQueue;
+    std::vector<std::vector<uint8_t> *> freeBuffers;
+    std::vector<std::vector<uint8_t> > bufferStorage;
+    bool writerStopping;
+    bool writeFailed;
+};
+
+#endif // FRAME_EXPORTER_H
@@ -0,0 +1,74 @@
+#ifndef GPU_TIMER_H
+#define GPU_TIMER_H
+
+#include "Profiler.h"
+#include <GL/glew.h>
+#include <cstdint>
+
+const int GPU_TIMER_FRAMES = 4; // Frames of queries in flight before their results are read
+const int GPU_TIMER_SCOPES = 8; // Timed scopes per frame; later ones are skipped
+
+// GPU time of GL command ranges, from GL_TIME_ELAPSED queries. Each frame
+// uses its own set of queries, and results are read GPU_TIMER_FRAMES - 1
+// frames later, when the GPU has long finished, so reading never stalls.
+// Durations go to the profiler's GPU lane at the CPU time the range began.
+class GpuTimer
+{
+public:
+    GpuTimer();
+    ~GpuTimer();
+    GpuTimer(const GpuTimer &) = delete;
+    GpuTimer &operator=(const GpuTimer &) = delete;
+
+    // Needs a current context with timer queries (OpenGL 3.3 or
+    // ARB_timer_query); returns false and times nothing without them
+    bool init();
+    void release();
+    bool isAvailable() const { return available; }
+
+    // Hand the oldest frame's results to the profiler and start a new frame
+    void beginFrame();
+
+    // Time the GL commands issued until end(). Ranges must not nest;
+    // begin returns false when the range is not timed.
+    bool begin(const char *name);
+    void end();
+
+private:
+    GLuint queries[GPU_TIMER_FRAMES][GPU_TIMER_SCOPES];
+    const char *names[GPU_TIMER_FRAMES][GPU_TIMER_SCOPES];
+    uint64_t cpuStart[GPU_TIMER_FRAMES][GPU_TIMER_SCOPES];
+    int used[GPU_TIMER_FRAMES];
+    int frame;
+    bool active;
+    bool available;
+};
+
+// Times the GL commands of its lifetime; use through PROFILE_GPU_SCOPE
+class GpuTimerScope
+{
+public:
+    GpuTimerScope(GpuTimer &timer, const char *name)
+        : gpuTimer(timer), started(timer.begin(name))
+    {
+    }
+    ~GpuTimerScope()
+    {
+        if (started)
+            gpuTimer.end();
+    }
+    GpuTimerScope(const GpuTimerScope &) = delete;
+    GpuTimerScope &operator=(const GpuTimerScope &) = delete;
+
+private:
+    GpuTimer &gpuTimer;
+    bool started;
+};
+
+#ifdef ENABLE_PROFILING
+#define PROFILE_GPU_SCOPE(timer, name) GpuTimerScope PROFILE_CONCAT(gpuScope, __LINE__)(timer, name)
+#else
+#define PROFILE_GPU_SCOPE(timer, name) do {} while (0)
+#endif
+
+#endif // GPU_TIMER_H
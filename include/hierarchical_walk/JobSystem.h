@@ -0,0 +1,99 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+const size_t CACHE_LINE_SIZE = 64;
+const size_t DEFAULT_JOB_CHUNK_SIZE = 256; // Walkers per chunk
+
+// Round a chunk of elements up so it covers whole cache lines; chunks of an
+// array that starts on a cache line then never share a line
+size_t cacheAlignedChunkSize(size_t chunkSize, size_t elementSize);
+
+// Allocator for arrays that start on a cache line
+template <typename T>
+struct CacheAlignedAllocator
+{
+    typedef T value_type;
+
+    CacheAlignedAllocator() {}
+    template <typename U>
+    CacheAlignedAllocator(const CacheAlignedAllocator<U> &) {}
+
+    T *allocate(size_t n)
+    {
+        return (T *)::operator new(n * sizeof(T), std::align_val_t(CACHE_LINE_SIZE));
+    }
+    void deallocate(T *p, size_t)
+    {
+        ::operator delete(p, std::align_val_t(CACHE_LINE_SIZE));
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const CacheAlignedAllocator<T> &, const CacheAlignedAllocator<U> &) { return true; }
+template <typename T, typename U>
+bool operator!=(const CacheAlignedAllocator<T> &, const CacheAlignedAllocator<U> &) { return false; }
+
+// Fixed pool of worker threads running parallel loops with work stealing.
+// parallelFor deals the chunks of a loop out to per-thread queues in
+// contiguous runs; a thread that empties its own queue steals half of the
+// remaining run of another. The calling thread works as thread 0.
+class JobSystem
+{
+public:
+    // threadCount 0 uses every hardware thread
+    explicit JobSystem(int threadCount = 0);
+    ~JobSystem();
+    JobSystem(const JobSystem &) = delete;
+    JobSystem &operator=(const JobSystem &) = delete;
+
+    // Call body(begin, end) for consecutive chunks of [0, count) and return
+    // once every chunk has finished and every worker has stopped looking for
+    // more, so it doubles as a barrier
+    void parallelFor(size_t count, size_t chunkSize, const std::function<void(size_t, size_t)> &body);
+
+    int threadCount() const { return (int)queues.size(); }
+
+private:
+    // Unclaimed chunk indices [begin, end) packed into one word so the owner
+    // and thieves can claim with a single compare-and-swap
+    struct alignas(CACHE_LINE_SIZE) ChunkQueue
+    {
+        std::atomic<uint64_t> range;
+    };
+
+    void workerLoop(int index);
+    void runChunks(int index);
+    bool popChunk(int index, uint32_t &chunk);
+    bool stealChunks(int thief, uint32_t &chunk);
+    void runChunk(uint32_t chunk);
+
+    std::vector<std::thread> workers;
+    std::vector<ChunkQueue> queues;
+
+    // Current loop; written before the queues are filled
+    const std::function<void(size_t, size_t)> *jobBody;
+    size_t jobCount;
+    size_t jobChunkSize;
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> pendingChunks;
+    // Workers not yet done with the current loop. A worker may still be
+    // stealing after the last chunk finishes, so parallelFor waits for this
+    // too; otherwise the next loop's queues could be overwritten under it.
+    std::atomic<int> busyWorkers;
+
+    std::mutex wakeMutex;
+    std::condition_variable wakeCondition;
+    uint64_t generation; // Bumped for every parallelFor; guarded by wakeMutex
+    bool stopping;
+};
+
+#endif // JOB_SYSTEM_H
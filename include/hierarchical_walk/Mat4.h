@@ -0,0 +1,142 @@
+#ifndef MAT4_H
+#define MAT4_H
+
+#include "Constants.h"
+#include "Vec3.h"
+#include <cmath>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// Column-major 4x4 matrix, same layout as OpenGL. Columns are 16-byte aligned
+// so the SSE paths below load them directly.
+struct alignas(16) Mat4
+{
+    float m[16];
+
+    static constexpr Mat4 identity()
+    {
+        return Mat4{{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1}};
+    }
+
+    static constexpr Mat4 translation(const Vec3 &t)
+    {
+        return Mat4{{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, t.x, t.y, t.z, 1}};
+    }
+
+    // Rotation in degrees about a unit axis, as glRotatef
+    static Mat4 rotation(float degrees, const Vec3 &axis)
+    {
+        float c = std::cos(degrees * PI / 180.0f);
+        float s = std::sin(degrees * PI / 180.0f);
+        float t = 1.0f - c;
+        float x = axis.x, y = axis.y, z = axis.z;
+        return Mat4{{x * x * t + c, y * x * t + z * s, x * z * t - y * s, 0,
+                     x * y * t - z * s, y * y * t + c, y * z * t + x * s, 0,
+                     x * z * t + y * s, y * z * t - x * s, z * z * t + c, 0,
+                     0, 0, 0, 1}};
+    }
+
+    constexpr Vec3 translationPart() const { return Vec3(m[12], m[13], m[14]); }
+
+    const float *data() const { return m; }
+};
+
+// a applied after b, as glMultMatrix(a) followed by glMultMatrix(b). Usable
+// in constant expressions; operator* is the same product, vectorized.
+constexpr Mat4 multiply(const Mat4 &a, const Mat4 &b)
+{
+    Mat4 r = {};
+    for (int col = 0; col < 4; col++)
+    {
+        for (int row = 0; row < 4; row++)
+        {
+            r.m[col * 4 + row] = a.m[row] * b.m[col * 4] +
+                                 a.m[4 + row] * b.m[col * 4 + 1] +
+                                 a.m[8 + row] * b.m[col * 4 + 2] +
+                                 a.m[12 + row] * b.m[col * 4 + 3];
+        }
+    }
+    return r;
+}
+
+// Each result column is a combination of a's columns, summed in the same order
+// as multiply() so both give bit-identical results
+inline Mat4 operator*(const Mat4 &a, const Mat4 &b)
+{
+#if defined(__SSE2__)
+    Mat4 r;
+    __m128 a0 = _mm_load_ps(a.m);
+    __m128 a1 = _mm_load_ps(a.m + 4);
+    __m128 a2 = _mm_load_ps(a.m + 8);
+    __m128 a3 = _mm_load_ps(a.m + 12);
+    for (int col = 0; col < 4; col++)
+    {
+        const float *c = b.m + col * 4;
+        __m128 sum = _mm_mul_ps(a0, _mm_set1_ps(c[0]));
+        sum = _mm_add_ps(sum, _mm_mul_ps(a1, _mm_set1_ps(c[1])));
+        sum = _mm_add_ps(sum, _mm_mul_ps(a2, _mm_set1_ps(c[2])));
+        sum = _mm_add_ps(sum, _mm_mul_ps(a3, _mm_set1_ps(c[3])));
+        _mm_store_ps(r.m + col * 4, sum);
+    }
+    return r;
+#else
+    return multiply(a, b);
+#endif
+}
+
+inline Vec3 transformPoint(const Mat4 &a, const Vec3 &p)
+{
+    return Vec3(a.m[0] * p.x + a.m[4] * p.y + a.m[8] * p.z + a.m[12],
+                a.m[1] * p.x + a.m[5] * p.y + a.m[9] * p.z + a.m[13],
+                a.m[2] * p.x + a.m[6] * p.y + a.m[10] * p.z + a.m[14]);
+}
+
+inline Vec3 transformDirection(const Mat4 &a, const Vec3 &d)
+{
+    return Vec3(a.m[0] * d.x + a.m[4] * d.y + a.m[8] * d.z,
+                a.m[1] * d.x + a.m[5] * d.y + a.m[9] * d.z,
+                a.m[2] * d.x + a.m[6] * d.y + a.m[10] * d.z);
+}
+
+// Inverse of a rotation plus translation: transpose the rotation and rotate
+// the negated translation back. Only valid when the upper 3x3 is orthonormal,
+// which holds for every joint transform.
+inline Mat4 inverseRigid(const Mat4 &a)
+{
+    Mat4 r;
+#if defined(__SSE2__)
+    __m128 c0 = _mm_load_ps(a.m);
+    __m128 c1 = _mm_load_ps(a.m + 4);
+    __m128 c2 = _mm_load_ps(a.m + 8);
+    __m128 c3 = _mm_setzero_ps();
+    _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+    // c0..c2 now hold the columns of the transposed rotation, all with w = 0
+    __m128 t = _mm_mul_ps(c0, _mm_set1_ps(a.m[12]));
+    t = _mm_add_ps(t, _mm_mul_ps(c1, _mm_set1_ps(a.m[13])));
+    t = _mm_add_ps(t, _mm_mul_ps(c2, _mm_set1_ps(a.m[14])));
+    t = _mm_sub_ps(_mm_set_ps(1, 0, 0, 0), t);
+
+    _mm_store_ps(r.m, c0);
+    _mm_store_ps(r.m + 4, c1);
+    _mm_store_ps(r.m + 8, c2);
+    _mm_store_ps(r.m + 12, t);
+#else
+    for (int col = 0; col < 3; col++)
+    {
+        for (int row = 0; row < 3; row++)
+            r.m[col * 4 + row] = a.m[row * 4 + col];
+        r.m[col * 4 + 3] = 0;
+    }
+    Vec3 t = transformDirection(r, a.translationPart());
+    r.m[12] = -t.x;
+    r.m[13] = -t.y;
+    r.m[14] = -t.z;
+    r.m[15] = 1;
+#endif
+    return r;
+}
+
+#endif // MAT4_H
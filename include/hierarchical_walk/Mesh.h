@@ -0,0 +1,61 @@
+#ifndef MESH_H
+#define MESH_H
+
+#include "Vec3.h"
+#include <vector>
+
+enum MeshPrimitive
+{
+    MESH_TRIANGLES,
+    MESH_LINES,
+    MESH_LINE_STRIP,
+    MESH_POINTS
+};
+
+// Interleaved vertex: position followed by normal
+struct MeshVertex
+{
+    float px, py, pz;
+    float nx, ny, nz;
+};
+
+// Geometry built on the CPU, ready to be uploaded
+struct MeshData
+{
+    std::vector<MeshVertex> vertices;
+    std::vector<unsigned int> indices;
+    MeshPrimitive primitive;
+
+    MeshData();
+};
+
+// Geometry generators. Each matches the layout of the immediate-mode
+// primitive it replaces so the retained meshes draw in the same place.
+MeshData buildBoxMesh(float width, float height, float depth);              // drawBox: base at y = 0
+MeshData buildCylinderMesh(float radius, float height, int slices);         // gluCylinder: along +z from z = 0
+MeshData buildSphereMesh(float radius, int slices, int stacks);             // gluSphere: centered
+MeshData buildGridMesh(int halfExtent);                                     // drawGround: lines on y = 0
+MeshData buildPointMesh(const std::vector<Vec3> &points, MeshPrimitive primitive); // Unlit strip or points
+void transformMesh(MeshData &mesh, float tx, float ty, float tz, float sx, float sy, float sz);
+
+// Mesh stored in GPU buffers
+struct Mesh
+{
+    unsigned int vertexArray;  // 0 when vertex array objects are unavailable
+    unsigned int vertexBuffer;
+    unsigned int indexBuffer;
+    MeshPrimitive primitive;
+    int indexCount;
+
+    Mesh();
+};
+
+// GL primitive mode (GLenum) for a mesh primitive
+unsigned int meshPrimitiveMode(MeshPrimitive primitive);
+
+// Upload / release / draw. Require a current GL context.
+Mesh uploadMesh(const MeshData &data);
+void destroyMesh(Mesh &mesh);
+void drawMesh(const Mesh &mesh);
+
+#endif // MESH_H
@@ -0,0 +1,11 @@
+#ifndef OFFSCREEN_CONTEXT_H
+#define OFFSCREEN_CONTEXT_H
+
+// OpenGL context with no window or display server, for offline rendering on
+// machines where GLFW cannot open a window. Uses a surfaceless EGL context,
+// so it is only available in builds with EGL (HAVE_EGL); elsewhere creation
+// always fails. Draw into a framebuffer object; there is no default one.
+bool createOffscreenContext();
+void destroyOffscreenContext();
+
+#endif // OFFSCREEN_CONTEXT_H
@@ -0,0 +1,87 @@
+#ifndef PATH_REGISTRY_H
+#define PATH_REGISTRY_H
+
+#include "ArcLengthTable.h"
+#include "CompiledSpline.h"
+#include "Spline.h"
+#include "Vec3.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// A path and the tables derived from it. Built once when registered and
+// never modified afterwards, so any number of walkers and threads read the
+// same instance without locks.
+struct PathData
+{
+    std::string name;         // File it was loaded from, or the name it was added under
+    CompiledSpline spline;
+    ArcLengthTable arcLength; // Always built, so walkers can switch to constant speed
+    float dt;                 // Parameter step from the path file
+
+    PathData();
+
+    // Heap bytes held by the spline and its tables
+    size_t memoryBytes() const;
+};
+
+typedef std::shared_ptr<const PathData> SharedPath;
+
+// Index of a path in a PathRegistry
+typedef uint32_t PathHandle;
+const PathHandle INVALID_PATH = 0xffffffffu;
+
+// Which shared path a walker follows and how. A walker keeps these 16 bytes
+// instead of its own copy of the spline and arc-length table.
+struct WalkerPath
+{
+    PathHandle path;
+    float speedScale;    // Multiplies the walker's time step
+    float lateralOffset; // Distance to the right of the path, across the heading
+    bool constantSpeed;  // Advance by distance instead of by parameter
+
+    WalkerPath();
+    explicit WalkerPath(PathHandle handle);
+};
+
+// Loads each path once and hands out handles to it. Paths are reference
+// counted, so a path taken with share() stays alive even after clear().
+class PathRegistry
+{
+public:
+    // Load a text or binary path file. A file already loaded returns its
+    // existing handle without being read again; INVALID_PATH on failure.
+    PathHandle load(const std::string &filename, bool quiet = false);
+
+    // Register control points under a name; a name already in use returns
+    // its existing handle. INVALID_PATH if the points make no segment.
+    PathHandle add(const std::string &name, const std::vector<Vec3> &points, SplineType type, float dt);
+
+    // Handle of a registered name, or INVALID_PATH
+    PathHandle find(const std::string &name) const;
+
+    const PathData &operator[](PathHandle handle) const { return *paths[handle]; }
+    SharedPath share(PathHandle handle) const { return paths[handle]; }
+    bool contains(PathHandle handle) const { return handle < paths.size(); }
+    size_t size() const { return paths.size(); }
+
+    // Point a handle at a rebuilt version of its path. Not synchronized:
+    // call it only where nothing else reads the registry, and readers that
+    // still hold the old version through share() keep it.
+    void replace(PathHandle handle, const SharedPath &path) { paths[handle] = path; }
+
+    // Heap bytes of every registered path
+    size_t memoryBytes() const;
+
+    // Forget every path; data still shared elsewhere lives on
+    void clear() { paths.clear(); }
+
+private:
+    PathHandle insert(const std::shared_ptr<PathData> &data);
+
+    std::vector<SharedPath> paths;
+};
+
+#endif // PATH_REGISTRY_H
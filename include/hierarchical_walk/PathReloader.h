@@ -0,0 +1,68 @@
+#ifndef PATH_RELOADER_H
+#define PATH_RELOADER_H
+
+#include "CompiledSpline.h"
+#include "FileWatcher.h"
+#include "PathRegistry.h"
+#include "PathTessellation.h"
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+// Quiet time after a change before the file is read, so the several writes
+// of one save are picked up together
+const int RELOAD_SETTLE_MS = 50;
+
+// A path rebuilt after its file changed
+struct PathReload
+{
+    SharedPath path;                // nullptr if the file could not be loaded
+    PathTessellation tessellation;  // Display polyline of path
+    SplineEdit edit;                // Segments that were recompiled
+    double seconds;                 // Time spent loading and rebuilding
+
+    PathReload();
+};
+
+// Reloads a path file on a background thread whenever it changes. The new
+// path is built from the previous one: only segments whose four control
+// points changed are recompiled, measured and tessellated, the rest are
+// copied. The render loop picks finished paths up with take() and swaps
+// them in between frames, so a long path never stalls a frame.
+class PathReloader
+{
+public:
+    PathReloader();
+    ~PathReloader();
+    PathReloader(const PathReloader &) = delete;
+    PathReloader &operator=(const PathReloader &) = delete;
+
+    // Watch the file current was loaded from; tolerance is that of the
+    // display polyline handed out with each reload
+    bool start(const SharedPath &current, float tolerance);
+    void stop();
+
+    // Move out the newest finished reload; false if none finished since the last call
+    bool take(PathReload &out);
+
+    const std::string &filename() const { return watcher.filename(); }
+
+private:
+    void run();
+    void reload();
+
+    FileWatcher watcher;
+    std::thread thread;
+    std::atomic<bool> running;
+
+    // Base of the next rebuild, used only on the reload thread
+    SharedPath current;
+    PathTessellation tessellation;
+    float displayTolerance;
+
+    std::mutex readyMutex;
+    PathReload ready;
+    bool hasReady;
+};
+
+#endif // PATH_RELOADER_H
@@ -0,0 +1,50 @@
+#ifndef PATH_TESSELLATION_H
+#define PATH_TESSELLATION_H
+
+#include "CompiledSpline.h"
+#include <vector>
+
+// Default maximum distance between the drawn polyline and the true curve (world units)
+const float DEFAULT_PATH_TOLERANCE = 0.005f;
+
+// Polyline approximation of a compiled path. Each segment is subdivided
+// until the chord error bound h^2/8 * max|p''| is below the tolerance, so
+// straight stretches use few vertices and tight bends use many.
+class PathTessellation
+{
+public:
+    PathTessellation();
+
+    // Tessellate every segment of the path
+    void build(const CompiledSpline &path, float tolerance = DEFAULT_PATH_TOLERANCE);
+
+    // Re-tessellate segments [first, last] only, e.g. after one control point moved
+    void rebuildSegments(const CompiledSpline &path, int first, int last);
+
+    // Follow an edit of the path: segments the edit left alone keep their
+    // vertices, even if they moved, and only recompiled ones are tessellated
+    void update(const CompiledSpline &path, const SplineEdit &edit);
+
+    bool isValid() const { return !segmentVertices.empty(); }
+
+    // Built from an older version of the path
+    bool isStale(const CompiledSpline &path) const { return path.version() != sourceVersion; }
+
+    // The whole polyline, in order from t = 0 to t = 1
+    const std::vector<Vec3> &vertices() const { return polyline; }
+
+    float tolerance() const { return errorTolerance; }
+
+private:
+    void tessellateSegment(const CompiledSpline &path, int segment, std::vector<Vec3> &out) const;
+    void flatten();
+
+    // Vertices of each segment, from u = 0 up to but excluding u = 1
+    std::vector<std::vector<Vec3>> segmentVertices;
+    std::vector<Vec3> polyline;
+    Vec3 endPoint;
+    float errorTolerance;
+    unsigned sourceVersion;
+};
+
+#endif // PATH_TESSELLATION_H
@@ -0,0 +1,192 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+// Scoped CPU timers. PROFILE_SCOPE("name") times the rest of the enclosing
+// block; the name must be a string literal. Without ENABLE_PROFILING the
+// macros expand to nothing, so instrumented code costs nothing.
+#ifdef ENABLE_PROFILING
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_THREAD_NAME(name) profiler().setThreadName(name)
+const bool PROFILING_ENABLED = true;
+#else
+#define PROFILE_SCOPE(name) do {} while (0)
+#define PROFILE_THREAD_NAME(name) do {} while (0)
+const bool PROFILING_ENABLED = false;
+#endif
+
+const size_t PROFILE_RING_CAPACITY = 8192; // Events a thread can record between collections (power of 2)
+const int PROFILE_HISTORY = 256;           // Latest durations kept per scope for percentiles
+const int PROFILE_MAX_THREADS = 64;        // Threads past this many record nothing
+
+struct ProfileEvent
+{
+    const char *name;
+    uint64_t start;    // Nanoseconds since the profiler started
+    uint64_t duration; // Nanoseconds
+    int thread;        // Index of the ring that recorded it
+
+    ProfileEvent();
+};
+
+// Events recorded by one thread. Only the owning thread writes, and writing
+// never waits. The collector reads behind the writer and drops events the
+// writer overwrote while they were being copied.
+class ProfileRing
+{
+public:
+    ProfileRing(int index, const char *name);
+
+    void push(const char *name, uint64_t start, uint64_t duration)
+    {
+        uint64_t index = written.load(std::memory_order_relaxed);
+        Slot &slot = slots[index & (PROFILE_RING_CAPACITY - 1)];
+        slot.name.store(name, std::memory_order_relaxed);
+        slot.start.store(start, std::memory_order_relaxed);
+        slot.duration.store(duration, std::memory_order_relaxed);
+        written.store(index + 1, std::memory_order_release);
+    }
+
+    // Append events written since readIndex to out and advance readIndex;
+    // returns the number of events lost to overwriting
+    uint64_t drain(uint64_t &readIndex, std::vector<ProfileEvent> &out) const;
+
+    int index() const { return ringIndex; }
+    const char *name() const { return threadName.load(std::memory_order_relaxed); }
+    void setName(const char *name) { threadName.store(name, std::memory_order_relaxed); }
+
+private:
+    struct Slot
+    {
+        std::atomic<const char *> name;
+        std::atomic<uint64_t> start;
+        std::atomic<uint64_t> duration;
+    };
+
+    std::atomic<uint64_t> written;
+    std::atomic<const char *> threadName;
+    int ringIndex;
+    std::unique_ptr<Slot[]> slots;
+};
+
+// Rolling durations of one named scope
+struct ProfileStat
+{
+    const char *name;
+    float milliseconds[PROFILE_HISTORY]; // Ring of the latest durations
+    int count;                           // Valid entries, up to PROFILE_HISTORY
+    int next;                            // Slot the next duration goes to
+    uint64_t total;                      // Durations recorded since start
+
+    ProfileStat();
+
+    void add(float ms);
+
+    // p in [0, 1] over the kept durations, 0 when there are none
+    float percentile(float p) const;
+
+    // Kept durations, oldest first
+    void history(std::vector<float> &out) const;
+};
+
+// Owns every thread's ring and turns their events into per-scope statistics
+// and, while tracing, a Chrome trace. collect() runs on one thread (the
+// render loop) once per frame; recording happens on any thread.
+class Profiler
+{
+public:
+    Profiler();
+
+    // Nanoseconds since the profiler started, on the steady clock
+    uint64_t now() const;
+
+    // Record a finished scope on the calling thread's ring
+    void record(const char *name, uint64_t start, uint64_t duration)
+    {
+        if (ProfileRing *ring = threadRing())
+            ring->push(name, start, duration);
+    }
+
+    // GPU durations go to their own ring, written only by the collecting thread
+    void recordGpu(const char *name, uint64_t start, uint64_t duration);
+
+    // Name the calling thread in traces and summaries
+    void setThreadName(const char *name);
+
+    // Drain every ring into the statistics (and the trace, if tracing)
+    void collect();
+
+    // Statistics of a scope, or nullptr if it never ran
+    const ProfileStat *stat(const char *name) const;
+    const std::vector<ProfileStat> &stats() const { return scopeStats; }
+    uint64_t droppedEvents() const { return dropped; }
+
+    // Keep collected events for writeTrace from now on
+    void startTrace() { tracing = true; }
+    bool isTracing() const { return tracing; }
+
+    // Chrome trace-event JSON, for chrome://tracing or Perfetto
+    bool writeTrace(const char *filename) const;
+
+    // Table of p50/p99 per scope
+    void printSummary(std::ostream &out) const;
+
+private:
+    // The calling thread's ring, created on first use; nullptr once
+    // PROFILE_MAX_THREADS rings exist
+    ProfileRing *threadRing();
+    ProfileRing *addRing(const char *name);
+
+    std::chrono::steady_clock::time_point epoch;
+    std::mutex ringMutex; // Guards adding rings, not recording
+
+    // Rings never move or go away, so the collector reads the first
+    // ringCount entries while other threads add more
+    std::unique_ptr<ProfileRing> rings[PROFILE_MAX_THREADS];
+    std::atomic<int> ringCount;
+    ProfileRing *gpuRing;
+
+    // Collector state
+    std::vector<uint64_t> readIndex;
+    std::vector<ProfileEvent> drained;
+    std::vector<ProfileStat> scopeStats;
+    std::vector<ProfileEvent> traceEvents;
+    uint64_t dropped;
+    bool tracing;
+};
+
+// The process-wide profiler
+Profiler &profiler();
+
+// Times its own lifetime; use through PROFILE_SCOPE
+class ProfileScope
+{
+public:
+    explicit ProfileScope(const char *name)
+        : scopeName(name), start(profiler().now())
+    {
+    }
+    ~ProfileScope()
+    {
+        Profiler &p = profiler();
+        p.record(scopeName, start, p.now() - start);
+    }
+    ProfileScope(const ProfileScope &) = delete;
+    ProfileScope &operator=(const ProfileScope &) = delete;
+
+private:
+    const char *scopeName;
+    uint64_t start;
+};
+
+#endif // PROFILER_H
@@ -0,0 +1,38 @@
+#ifndef QUAT_H
+#define QUAT_H
+
+#include "Constants.h"
+#include "Mat4.h"
+#include "Vec3.h"
+#include <cmath>
+
+// Unit quaternion rotation; (x, y, z) is the vector part, w the scalar part
+struct Quat
+{
+    float x, y, z, w;
+
+    constexpr Quat(float _x = 0, float _y = 0, float _z = 0, float _w = 1) : x(_x), y(_y), z(_z), w(_w) {}
+
+    // Rotation in degrees about a unit axis, same sense as Mat4::rotation
+    static Quat fromAxisAngle(const Vec3 &axis, float degrees)
+    {
+        float half = degrees * PI / 360.0f;
+        float s = std::sin(half);
+        return Quat(axis.x * s, axis.y * s, axis.z * s, std::cos(half));
+    }
+};
+
+// Rotate by r, then translate by t: translation(t) * rotation(r) without the
+// matrix product
+constexpr Mat4 rigidTransform(const Quat &r, const Vec3 &t)
+{
+    float xx = r.x * r.x, yy = r.y * r.y, zz = r.z * r.z;
+    float xy = r.x * r.y, xz = r.x * r.z, yz = r.y * r.z;
+    float wx = r.w * r.x, wy = r.w * r.y, wz = r.w * r.z;
+    return Mat4{{1 - 2 * (yy + zz), 2 * (xy + wz), 2 * (xz - wy), 0,
+                 2 * (xy - wz), 1 - 2 * (xx + zz), 2 * (yz + wx), 0,
+                 2 * (xz + wy), 2 * (yz - wx), 1 - 2 * (xx + yy), 0,
+                 t.x, t.y, t.z, 1}};
+}
+
+#endif // QUAT_H
@@ -4,6 +4,9 @@
 #include "Vec3.h"
 #include "ArticulatedFigure.h"
 #include "Spline.h"
+#include "CompiledSpline.h"
+#include "Mesh.h"
+#include "PathTessellation.h"
 #include <vector>
 
 // Primitive drawing functions
@@ -12,12 +15,38 @@ void drawBox(float width, float height, float depth);
 void drawSphere(float radius);
 
 // Complex drawing functions
-void drawLeg(float hipAngle, float kneeAngle);
-void drawFigure(const ArticulatedFigure &figure);
+void drawFigure(const ArticulatedFigure &figure); // Each part placed by its skeleton joint
 void drawSpline(const std::vector<Vec3> &controlPoints, SplineType type);
+void drawSpline(const CompiledSpline &path, int slot = 0); // Cached per slot, rebuilt when the path changes
+void setPathTolerance(float tolerance);      // Max polyline-to-curve distance for drawSpline
+void setPathTessellation(int slot, PathTessellation &tessellation); // Take a polyline built elsewhere
+void drawPolyline(const std::vector<Vec3> &vertices); // A path curve that changes too often to cache
 void drawGround();
 
-// OpenGL initialization
+// Bar graph of recent frame times (oldest first) in the bottom-left corner,
+// with lines at p50, p99 and the 60 Hz budget
+void drawFrameTimeGraph(const std::vector<float> &frameMs, float p50, float p99, int windowWidth, int windowHeight);
+
+// OpenGL initialization; also builds the mesh cache
 void initGL(int windowWidth, int windowHeight);
 
+// Retained vertex buffers for the figure parts and ground grid.
+// Drawing falls back to immediate mode while the cache is not built.
+void buildMeshCache();
+void releaseMeshCache();
+
+// Retained geometry for the figure parts and ground
+struct SceneMeshes
+{
+    Mesh shapes[FIGURE_SHAPE_COUNT]; // Indexed by FigureShape
+    Mesh ground;
+    bool ready = false;
+};
+
+// RGB color of a figure shape
+const float *figureShapeColor(int shape);
+
+// The mesh cache, or nullptr while it is not built
+const SceneMeshes *sceneMeshes();
+
 #endif // RENDERER_H
\ No newline at end of file
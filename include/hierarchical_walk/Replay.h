@@ -0,0 +1,67 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "Animation.h"
+#include "ArticulatedFigure.h"
+#include "Spline.h"
+#include "Vec3.h"
+#include <cstdint>
+#include <vector>
+
+// Inputs that change the simulation
+enum ReplayEventType
+{
+    REPLAY_ANIMATION_SPEED, // value: new animationSpeed of every walker
+    REPLAY_WALK_SPEED,      // value: new walkSpeed of every walker
+    REPLAY_RESET,           // Walkers back to their starting positions
+    REPLAY_CONSTANT_SPEED   // value: 1 to walk by distance, 0 by parameter
+};
+
+// One input, applied before simulation tick `tick` runs
+struct ReplayEvent
+{
+    uint64_t tick;
+    ReplayEventType type;
+    float value;
+};
+
+// Starting conditions, inputs and outcome of a fixed-step session. Feeding
+// the same events to the same starting state at the same ticks reproduces
+// every walker bit for bit, which stateHash confirms, in any build that
+// does not fuse multiply-adds (see -ffp-contract=off in CMakeLists.txt).
+struct ReplayLog
+{
+    // Starting conditions
+    std::vector<Vec3> controlPoints;
+    SplineType splineType;
+    float pathDt;         // dt from the control points file
+    float stepSeconds;    // Fixed simulation step
+    uint32_t walkerCount;
+    bool constantSpeed;
+    bool footPlanting;    // Walkers ran applyFootPlanting after each update
+    bool separation;      // Walkers were pushed apart by CrowdSeparation
+    float animationSpeed;
+    float walkSpeed;
+    float lateralSpread;  // Band walkers were spread over across the path
+    float speedSpread;    // Fraction walker speeds varied by either way
+
+    // Inputs in tick order
+    std::vector<ReplayEvent> events;
+
+    // Outcome
+    uint64_t tickCount;   // Ticks simulated
+    uint64_t stateHash;   // hashWalkers() after the last tick and event
+
+    ReplayLog();
+
+    void record(uint64_t tick, ReplayEventType type, float value);
+
+    // Compact binary file: fixed header, then events with varint tick deltas
+    bool save(const char *filename) const;
+    bool load(const char *filename);
+};
+
+// 64-bit FNV-1a hash over the exact bits of every pose and animation state
+uint64_t hashWalkers(const std::vector<ArticulatedFigure> &figures, const std::vector<AnimationState> &states);
+
+#endif // REPLAY_H
@@ -0,0 +1,100 @@
+#ifndef SIMD_LANES_H
+#define SIMD_LANES_H
+
+#include <cmath>
+
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// A lane type is a pack of floats with the few operations the SIMD kernels
+// need. Every operation is a single IEEE float operation per lane, so a
+// kernel that applies them in the order of the scalar code reproduces it bit
+// for bit. SimdLanes is the widest pack the compiler targets; ScalarLanes
+// handles the remainder of a batch.
+
+struct ScalarLanes
+{
+    static const int width = 1;
+    float v;
+
+    static ScalarLanes load(const float *p) { return {p[0]}; }
+    static ScalarLanes set(float s) { return {s}; }
+    void store(float *p) const { p[0] = v; }
+};
+
+inline ScalarLanes operator+(ScalarLanes a, ScalarLanes b) { return {a.v + b.v}; }
+inline ScalarLanes operator-(ScalarLanes a, ScalarLanes b) { return {a.v - b.v}; }
+inline ScalarLanes operator*(ScalarLanes a, ScalarLanes b) { return {a.v * b.v}; }
+inline ScalarLanes operator/(ScalarLanes a, ScalarLanes b) { return {a.v / b.v}; }
+inline ScalarLanes sqrtLanes(ScalarLanes a) { return {std::sqrt(a.v)}; }
+inline ScalarLanes truncateLanes(ScalarLanes a) { return {(float)(int)a.v}; }
+
+// (a > b) ? ifTrue : ifFalse
+inline ScalarLanes selectGreater(ScalarLanes a, ScalarLanes b, ScalarLanes ifTrue, ScalarLanes ifFalse)
+{
+    return (a.v > b.v) ? ifTrue : ifFalse;
+}
+
+#if defined(__AVX__)
+
+struct SimdLanes
+{
+    static const int width = 8;
+    __m256 v;
+
+    static SimdLanes load(const float *p) { return {_mm256_loadu_ps(p)}; }
+    static SimdLanes set(float s) { return {_mm256_set1_ps(s)}; }
+    void store(float *p) const { _mm256_storeu_ps(p, v); }
+};
+
+inline SimdLanes operator+(SimdLanes a, SimdLanes b) { return {_mm256_add_ps(a.v, b.v)}; }
+inline SimdLanes operator-(SimdLanes a, SimdLanes b) { return {_mm256_sub_ps(a.v, b.v)}; }
+inline SimdLanes operator*(SimdLanes a, SimdLanes b) { return {_mm256_mul_ps(a.v, b.v)}; }
+inline SimdLanes operator/(SimdLanes a, SimdLanes b) { return {_mm256_div_ps(a.v, b.v)}; }
+inline SimdLanes sqrtLanes(SimdLanes a) { return {_mm256_sqrt_ps(a.v)}; }
+inline SimdLanes truncateLanes(SimdLanes a) { return {_mm256_cvtepi32_ps(_mm256_cvttps_epi32(a.v))}; }
+
+inline SimdLanes selectGreater(SimdLanes a, SimdLanes b, SimdLanes ifTrue, SimdLanes ifFalse)
+{
+    __m256 mask = _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ);
+    return {_mm256_blendv_ps(ifFalse.v, ifTrue.v, mask)};
+}
+
+#define SIMD_LANES_NAME "AVX"
+
+#elif defined(__SSE2__)
+
+struct SimdLanes
+{
+    static const int width = 4;
+    __m128 v;
+
+    static SimdLanes load(const float *p) { return {_mm_loadu_ps(p)}; }
+    static SimdLanes set(float s) { return {_mm_set1_ps(s)}; }
+    void store(float *p) const { _mm_storeu_ps(p, v); }
+};
+
+inline SimdLanes operator+(SimdLanes a, SimdLanes b) { return {_mm_add_ps(a.v, b.v)}; }
+inline SimdLanes operator-(SimdLanes a, SimdLanes b) { return {_mm_sub_ps(a.v, b.v)}; }
+inline SimdLanes operator*(SimdLanes a, SimdLanes b) { return {_mm_mul_ps(a.v, b.v)}; }
+inline SimdLanes operator/(SimdLanes a, SimdLanes b) { return {_mm_div_ps(a.v, b.v)}; }
+inline SimdLanes sqrtLanes(SimdLanes a) { return {_mm_sqrt_ps(a.v)}; }
+inline SimdLanes truncateLanes(SimdLanes a) { return {_mm_cvtepi32_ps(_mm_cvttps_epi32(a.v))}; }
+
+inline SimdLanes selectGreater(SimdLanes a, SimdLanes b, SimdLanes ifTrue, SimdLanes ifFalse)
+{
+    __m128 mask = _mm_cmpgt_ps(a.v, b.v);
+    return {_mm_or_ps(_mm_and_ps(mask, ifTrue.v), _mm_andnot_ps(mask, ifFalse.v))};
+}
+
+#define SIMD_LANES_NAME "SSE2"
+
+#else
+
+typedef ScalarLanes SimdLanes;
+#define SIMD_LANES_NAME "scalar"
+
+#endif
+
+#endif // SIMD_LANES_H
@@ -0,0 +1,90 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include "ArticulatedFigure.h"
+#include "Animation.h"
+#include "CompiledSpline.h"
+#include "CrowdSeparation.h"
+#include "FootPlanting.h"
+#include "JobSystem.h"
+#include "PathRegistry.h"
+#include <vector>
+
+// A single simulated walker: pose, animation state and a handle to the
+// shared path it follows. Cache-line aligned so walkers updated on
+// different threads never share a line.
+struct alignas(CACHE_LINE_SIZE) Walker
+{
+    ArticulatedFigure figure;
+    AnimationState state;
+    WalkerPath path;
+    FootPlanting feet; // Contacts of the foot-planting pass
+};
+
+// Timing results of a batch run
+struct SimulationStats
+{
+    int walkerCount;
+    int stepCount;
+    double totalSeconds;   // Wall-clock time spent inside step()
+    double minStepSeconds; // Fastest single step
+    double maxStepSeconds; // Slowest single step
+
+    SimulationStats();
+
+    // Add the duration of one step
+    void recordStep(double seconds);
+
+    double stepsPerSecond() const;
+    double walkerUpdatesPerSecond() const;
+};
+
+// Steps many walkers with a fixed time step, without a window or GL context.
+// Walkers follow paths of a registry that must outlive the simulation.
+class HeadlessSimulation
+{
+public:
+    explicit HeadlessSimulation(const PathRegistry &paths);
+
+    // Spread step() over the threads of a job system in chunks of chunkSize
+    // walkers; nullptr steps on the calling thread
+    void setJobSystem(JobSystem *jobs, size_t chunkSize = DEFAULT_JOB_CHUNK_SIZE);
+
+    // Run applyFootPlanting on every walker after its update (off by default)
+    void setFootPlanting(bool enabled) { footPlanting = enabled; }
+
+    // Push walkers apart with a CrowdSeparation pass each step (off by default)
+    void setSeparation(bool enabled) { separating = enabled; }
+    const CrowdSeparation &separation() const { return crowdSeparation; }
+
+    // Add a walker on a registered path; phase in [0, 1] offsets its start
+    // along the path (a fraction of its length for constant-speed walkers)
+    void addWalker(const WalkerPath &path, float phase);
+
+    // Advance every walker by one fixed time step
+    void step(float fixedDeltaTime);
+
+    // Run a number of fixed steps and measure throughput
+    SimulationStats run(int steps, float fixedDeltaTime);
+
+    const std::vector<Walker> &walkers() const { return walkerList; }
+
+    // Sum of FootPlanting::slip over all walkers
+    double footSlip() const;
+
+private:
+    void forEachChunk(const std::function<void(size_t, size_t)> &body);
+    void stepRange(float fixedDeltaTime, size_t begin, size_t end);
+    void placeRange(size_t begin, size_t end);
+
+    const PathRegistry &pathRegistry;
+    std::vector<Walker> walkerList;
+    JobSystem *jobSystem;
+    size_t jobChunkSize;
+    bool footPlanting;
+    bool separating;
+    CrowdSeparation crowdSeparation;
+    std::vector<Vec3> pathPositions; // Gathered for the separation pass
+};
+
+#endif // SIMULATION_H
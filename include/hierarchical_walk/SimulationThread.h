@@ -0,0 +1,73 @@
+#ifndef SIMULATION_THREAD_H
+#define SIMULATION_THREAD_H
+
+#include "ArticulatedFigure.h"
+#include "FixedTimestep.h"
+#include "TripleBuffer.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Poses of the last two ticks, published together so the renderer can blend them
+struct PoseSnapshot
+{
+    std::vector<ArticulatedFigure> previous;
+    std::vector<ArticulatedFigure> current;
+    uint64_t tick;      // Number of ticks run so far
+    double tickTime;    // Time the current tick stands for, in seconds
+
+    PoseSnapshot();
+};
+
+// Runs the walker simulation on its own thread in fixed steps paid out by a
+// FixedTimestep, so vsync and slow frames never change the step size. Each
+// tick publishes the poses through a triple buffer; the render thread reads
+// the newest pair without blocking and interpolates between them.
+class SimulationThread
+{
+public:
+    typedef std::function<void(float)> StepFunction;
+    typedef std::function<void(std::vector<ArticulatedFigure> &)> CaptureFunction;
+
+    SimulationThread();
+    ~SimulationThread();
+    SimulationThread(const SimulationThread &) = delete;
+    SimulationThread &operator=(const SimulationThread &) = delete;
+
+    // step advances the simulation by one tick; capture copies out the poses.
+    // Both run only on the simulation thread until stop() returns.
+    void start(double tickRate, int maxSubsteps, StepFunction step, CaptureFunction capture);
+    void stop();
+    bool isRunning() const { return running.load(std::memory_order_acquire); }
+
+    // Queue a change to the simulation; it runs on the simulation thread
+    // before the next tick
+    void post(std::function<void()> command);
+
+    // Poses blended for the current time between the last two ticks, one tick
+    // behind real time. Returns false and leaves poses alone before the first tick.
+    bool interpolatedPoses(std::vector<ArticulatedFigure> &poses);
+
+    double tickSeconds() const { return tickInterval; }
+
+private:
+    void run();
+    void runCommands();
+
+    std::thread thread;
+    std::atomic<bool> running;
+    double tickInterval;
+    int substepLimit;
+    StepFunction stepFunction;
+    CaptureFunction captureFunction;
+
+    std::mutex commandMutex;
+    std::vector<std::function<void()> > commands;
+
+    TripleBuffer<PoseSnapshot> snapshots;
+};
+
+#endif // SIMULATION_THREAD_H
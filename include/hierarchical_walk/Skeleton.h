@@ -0,0 +1,52 @@
+#ifndef SKELETON_H
+#define SKELETON_H
+
+#include "Mat4.h"
+#include "Vec3.h"
+#include <string>
+#include <vector>
+
+// Joint hierarchy kept in flat arrays, every parent before its children.
+// Each joint sits at a fixed offset in its parent's frame and rotates about
+// one axis; a pose is one angle per joint. Because of the ordering, world
+// transforms come from a single forward pass with no recursion.
+class Skeleton
+{
+public:
+    // Append a joint. parent is an earlier joint, or -1 for a root; axis must
+    // be unit length. Returns the new joint's index, or -1 if parent is invalid.
+    int addJoint(const std::string &name, int parent, const Vec3 &offset, const Vec3 &axis);
+
+    int jointCount() const { return (int)parents.size(); }
+    int parent(int joint) const { return parents[joint]; }
+    const Vec3 &offset(int joint) const { return offsets[joint]; }
+    const Vec3 &axis(int joint) const { return axes[joint]; }
+    const std::string &name(int joint) const { return names[joint]; }
+
+    // Index of the joint with this name, or -1
+    int findJoint(const std::string &name) const;
+
+    // local[i] = translation(offset i) * rotation(angles[i] degrees, axis i)
+    void computeLocalTransforms(const float *angles, Mat4 *local) const;
+
+    // world[i] = world[parent i] * local[i], with root in place of the parent of roots
+    void computeWorldTransforms(const Mat4 &root, const Mat4 *local, Mat4 *world) const;
+
+private:
+    std::vector<int> parents;
+    std::vector<Vec3> offsets;
+    std::vector<Vec3> axes;
+    std::vector<std::string> names;
+};
+
+// A rigid shape carried by a joint
+struct SkeletonPart
+{
+    int joint;
+    int shape;           // Which shape to draw; its meaning is up to the renderer
+    Mat4 placement;      // Shape relative to the joint's frame
+
+    SkeletonPart(int joint, int shape, const Mat4 &placement);
+};
+
+#endif // SKELETON_H
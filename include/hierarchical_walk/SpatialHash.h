@@ -0,0 +1,110 @@
+#ifndef SPATIAL_HASH_H
+#define SPATIAL_HASH_H
+
+#include "Vec3.h"
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Uniform grid over the ground plane (x, z) with cells hashed into a table
+// of slots. build() buckets every point with a counting sort, so rebuilding
+// each tick is linear in the number of points, and a radius query only scans
+// the slots of the cells the radius overlaps.
+class SpatialHash
+{
+public:
+    SpatialHash();
+
+    // Bucket points by cell; cellSize should be about the usual query radius
+    void build(const std::vector<Vec3> &points, float cellSize);
+
+    size_t size() const { return sorted.size(); }
+    float cellSize() const { return cell; }
+
+    // Call visit(index, point) for every point within radius of center on
+    // the ground plane. visit returns false to stop the query early. The
+    // center cell is scanned first; within and after it points come in
+    // build order, not by distance. The order is fixed for a given build,
+    // so results are reproducible.
+    template <typename Visit>
+    void forEachNear(const Vec3 &center, float radius, Visit visit) const;
+
+private:
+    struct Entry
+    {
+        Vec3 point;
+        int cellX, cellZ;
+        uint32_t index;
+    };
+
+    // Visit the points of one cell; false once visit asked to stop
+    template <typename Visit>
+    bool scanCell(int cellX, int cellZ, const Vec3 &center, float radiusSquared, Visit &visit) const;
+
+    int cellCoordinate(float value) const { return (int)std::floor(value * inverseCell); }
+    size_t slotOf(int cellX, int cellZ) const
+    {
+        // Large odd multipliers spread neighboring cells over the table
+        return ((uint32_t)cellX * 73856093u ^ (uint32_t)cellZ * 19349663u) & slotMask;
+    }
+
+    float cell;
+    float inverseCell;
+    size_t slotMask;
+    std::vector<uint32_t> slotStart; // Slot s holds sorted entries [slotStart[s], slotStart[s + 1])
+    std::vector<Entry> sorted;       // Points in slot order, scanned by queries
+
+    // Scratch kept between builds so a rebuild does not allocate
+    std::vector<std::pair<int, int> > pointCell;
+    std::vector<uint32_t> pointSlot;
+    std::vector<uint32_t> slotFill;
+};
+
+template <typename Visit>
+bool SpatialHash::scanCell(int cellX, int cellZ, const Vec3 &center, float radiusSquared, Visit &visit) const
+{
+    size_t slot = slotOf(cellX, cellZ);
+    for (uint32_t k = slotStart[slot]; k < slotStart[slot + 1]; k++)
+    {
+        const Entry &entry = sorted[k];
+
+        // Other cells can share the slot; skip them so no point is visited twice
+        if (entry.cellX != cellX || entry.cellZ != cellZ)
+            continue;
+
+        float dx = entry.point.x - center.x;
+        float dz = entry.point.z - center.z;
+        if (dx * dx + dz * dz <= radiusSquared && !visit(entry.index, entry.point))
+            return false;
+    }
+    return true;
+}
+
+template <typename Visit>
+void SpatialHash::forEachNear(const Vec3 &center, float radius, Visit visit) const
+{
+    if (sorted.empty())
+        return;
+
+    float radiusSquared = radius * radius;
+    int centerX = cellCoordinate(center.x), centerZ = cellCoordinate(center.z);
+    if (!scanCell(centerX, centerZ, center, radiusSquared, visit))
+        return;
+
+    int minX = cellCoordinate(center.x - radius), maxX = cellCoordinate(center.x + radius);
+    int minZ = cellCoordinate(center.z - radius), maxZ = cellCoordinate(center.z + radius);
+    for (int cellZ = minZ; cellZ <= maxZ; cellZ++)
+    {
+        for (int cellX = minX; cellX <= maxX; cellX++)
+        {
+            if (cellX == centerX && cellZ == centerZ)
+                continue;
+            if (!scanCell(cellX, cellZ, center, radiusSquared, visit))
+                return;
+        }
+    }
+}
+
+#endif // SPATIAL_HASH_H
@@ -4,19 +4,39 @@
 #include "Vec3.h"
 #include <vector>
 
+// Stored by value in binary path files and replay logs
 enum SplineType
 {
-    CATMULL_ROM,
-    BSPLINE
+    CATMULL_ROM,             // Uniform knots
+    BSPLINE,
+    CENTRIPETAL_CATMULL_ROM, // Knots spaced by the square root of point distance
+    CHORDAL_CATMULL_ROM      // Knots spaced by point distance
 };
 
+const unsigned SPLINE_TYPE_COUNT = 4;
+
+// Type named in the first line of a path file, or false if none is
+bool parseSplineType(const char *begin, const char *end, SplineType &type);
+
+// Readable name, e.g. "centripetal Catmull-Rom spline"
+const char *splineTypeName(SplineType type);
+
+// Position of any spline type; see SplineEngine for loops over one type
+Vec3 evaluateSpline(const std::vector<Vec3> &points, float t, SplineType type);
+
 // Catmull-Rom spline evaluation
 Vec3 evaluateCatmullRom(const std::vector<Vec3> &points, float t);
 
 // B-Spline evaluation
 Vec3 evaluateBSpline(const std::vector<Vec3> &points, float t);
 
+// First derivative dp/dt, evaluated in closed form
+Vec3 evaluateSplineDerivative(const std::vector<Vec3> &points, float t, SplineType type);
+
+// Second derivative d2p/dt2, evaluated in closed form
+Vec3 evaluateSplineSecondDerivative(const std::vector<Vec3> &points, float t, SplineType type);
+
 // Get tangent vector for forward direction
 Vec3 getSplineTangent(const std::vector<Vec3> &points, float t, SplineType type);
 
-#endif // SPLINE_H
\ No newline at end of file
+#endif // SPLINE_H
@@ -0,0 +1,101 @@
+#ifndef SPLINE_BATCH_H
+#define SPLINE_BATCH_H
+
+#include "CompiledSpline.h"
+#include "SimdLanes.h"
+#include "Vec3.h"
+#include <cstddef>
+
+// Positions and unit tangents of a path at count global parameters t, sorted
+// or not. Either output may be null. When there are at least SimdLanes::width
+// parameters per segment, they are bucketed by segment with a counting sort,
+// each bucket is evaluated with its segment's coefficients in every lane and
+// the results go back to the parameters' places. Sparser batches are taken
+// in order, Lanes::width at a time, gathering the coefficients per lane when
+// a block spans several segments. Results match evaluate(t) and
+// getSplineTangent(path, t) bit for bit when multiply-adds are not fused,
+// which the build ensures with -ffp-contract=off.
+void evaluateSplineBatch(const CompiledSpline &path, const float *t, size_t count, Vec3 *positions, Vec3 *tangents);
+
+// Positions at count local parameters u of one segment
+void evaluateSegmentBatch(const CompiledSpline &path, int segment, const float *u, size_t count, Vec3 *positions);
+
+// Horner's rule across lanes; same arithmetic as evaluatePolynomial and
+// polynomialDerivative. derivative may be null.
+template <typename Lanes>
+void evaluatePolynomialLanes(const Lanes coefficients[4][3], Lanes u, Lanes *position, Lanes *derivative)
+{
+    const Lanes two = Lanes::set(2.0f);
+    const Lanes three = Lanes::set(3.0f);
+
+    for (int axis = 0; axis < 3; axis++)
+    {
+        Lanes a = coefficients[0][axis];
+        Lanes b = coefficients[1][axis];
+        Lanes c = coefficients[2][axis];
+        Lanes d = coefficients[3][axis];
+        position[axis] = ((a * u + b) * u + c) * u + d;
+        if (derivative)
+            derivative[axis] = (a * three * u + b * two) * u + c;
+    }
+}
+
+// The coefficients of one segment in every lane
+template <typename Lanes>
+void broadcastSegment(const SplineSegment &s, Lanes coefficients[4][3])
+{
+    const Vec3 *terms[4] = {&s.a, &s.b, &s.c, &s.d};
+    for (int k = 0; k < 4; k++)
+    {
+        coefficients[k][0] = Lanes::set(terms[k]->x);
+        coefficients[k][1] = Lanes::set(terms[k]->y);
+        coefficients[k][2] = Lanes::set(terms[k]->z);
+    }
+}
+
+// Position and local derivative of the path at Lanes::width parameters
+template <typename Lanes>
+void evaluateSplineLanes(const CompiledSpline &path, const float *t, Lanes *position, Lanes *derivative)
+{
+    const int W = Lanes::width;
+    float segmentTs[W];
+    int segments[W];
+    bool shared = true;
+
+    // Segment lookup is per lane; the polynomial is evaluated across lanes
+    for (int j = 0; j < W; j++)
+    {
+        path.locate(t[j], segments[j], segmentTs[j]);
+        shared = shared && segments[j] == segments[0];
+    }
+
+    Lanes coefficients[4][3];
+    if (shared)
+    {
+        broadcastSegment(path.segment(segments[0]), coefficients);
+    }
+    else
+    {
+        float gathered[4][3][W];
+        for (int j = 0; j < W; j++)
+        {
+            const SplineSegment &s = path.segment(segments[j]);
+            const Vec3 *terms[4] = {&s.a, &s.b, &s.c, &s.d};
+            for (int k = 0; k < 4; k++)
+            {
+                gathered[k][0][j] = terms[k]->x;
+                gathered[k][1][j] = terms[k]->y;
+                gathered[k][2][j] = terms[k]->z;
+            }
+        }
+        for (int k = 0; k < 4; k++)
+        {
+            for (int axis = 0; axis < 3; axis++)
+                coefficients[k][axis] = Lanes::load(gathered[k][axis]);
+        }
+    }
+
+    evaluatePolynomialLanes(coefficients, Lanes::load(segmentTs), position, derivative);
+}
+
+#endif // SPLINE_BATCH_H
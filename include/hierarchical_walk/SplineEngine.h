@@ -0,0 +1,335 @@
+#ifndef SPLINE_ENGINE_H
+#define SPLINE_ENGINE_H
+
+#include "Spline.h"
+#include "Vec3.h"
+#include "Vec4.h"
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+// Cubic polynomial of one spline segment: p(u) = ((a*u + b)*u + c)*u + d, u in [0, 1]
+struct SplineSegment
+{
+    Vec3 a, b, c, d;
+};
+
+// The same in homogeneous coordinates; the point is xyz / w
+struct RationalSegment
+{
+    Vec4 a, b, c, d;
+};
+
+// Map global t in [0, 1] to one of count segments and the local parameter
+// in it. Every evaluator splits t this way.
+inline void locateSegment(int count, float t, int &segment, float &u)
+{
+    float segmentT = t * count;
+    segment = (int)segmentT;
+
+    if (segment >= count)
+    {
+        segment = count - 1;
+        u = 1.0f;
+    }
+    else if (segment < 0)
+    {
+        segment = 0;
+        u = 0.0f;
+    }
+    else
+    {
+        u = segmentT - segment;
+    }
+}
+
+// Position and derivatives of a segment with respect to u
+inline Vec3 evaluatePolynomial(const SplineSegment &s, float u)
+{
+    return Vec3(((s.a.x * u + s.b.x) * u + s.c.x) * u + s.d.x,
+                ((s.a.y * u + s.b.y) * u + s.c.y) * u + s.d.y,
+                ((s.a.z * u + s.b.z) * u + s.c.z) * u + s.d.z);
+}
+
+inline Vec3 polynomialDerivative(const SplineSegment &s, float u)
+{
+    return Vec3((s.a.x * 3.0f * u + s.b.x * 2.0f) * u + s.c.x,
+                (s.a.y * 3.0f * u + s.b.y * 2.0f) * u + s.c.y,
+                (s.a.z * 3.0f * u + s.b.z * 2.0f) * u + s.c.z);
+}
+
+inline Vec3 polynomialSecondDerivative(const SplineSegment &s, float u)
+{
+    return Vec3(s.a.x * 6.0f * u + s.b.x * 2.0f,
+                s.a.y * 6.0f * u + s.b.y * 2.0f,
+                s.a.z * 6.0f * u + s.b.z * 2.0f);
+}
+
+// A rational segment is h(u) / w(u); the derivatives follow from the quotient rule
+inline Vec3 evaluatePolynomial(const RationalSegment &s, float u)
+{
+    Vec4 h = ((s.a * u + s.b) * u + s.c) * u + s.d;
+    return h.xyz() * (1.0f / h.w);
+}
+
+inline Vec3 polynomialDerivative(const RationalSegment &s, float u)
+{
+    Vec4 h = ((s.a * u + s.b) * u + s.c) * u + s.d;
+    Vec4 h1 = (s.a * (3.0f * u) + s.b * 2.0f) * u + s.c;
+    Vec3 p = h.xyz() * (1.0f / h.w);
+    return (h1.xyz() - p * h1.w) * (1.0f / h.w);
+}
+
+inline Vec3 polynomialSecondDerivative(const RationalSegment &s, float u)
+{
+    Vec4 h = ((s.a * u + s.b) * u + s.c) * u + s.d;
+    Vec4 h1 = (s.a * (3.0f * u) + s.b * 2.0f) * u + s.c;
+    Vec4 h2 = s.a * (6.0f * u) + s.b * 2.0f;
+    float inverseW = 1.0f / h.w;
+    Vec3 p = h.xyz() * inverseW;
+    Vec3 p1 = (h1.xyz() - p * h1.w) * inverseW;
+    return (h2.xyz() - p1 * (2.0f * h1.w) - p * h2.w) * inverseW;
+}
+
+// ============================================================================
+// BASIS POLICIES
+// ============================================================================
+
+// Each basis turns the four control points around a segment into that
+// segment's polynomial. Segment i runs from p[1] to p[2] for interpolating
+// bases and near them for approximating ones.
+
+// Uniform Catmull-Rom: passes through every point, but overshoots and can
+// form cusps where the spacing of the points varies
+struct UniformCatmullRom
+{
+    typedef Vec3 Point;
+    typedef SplineSegment Segment;
+
+    static Segment compile(const Point *p)
+    {
+        // Catmull-Rom basis, scaled by 1/2
+        Segment s;
+        s.a = (p[0] * -1.0f + p[1] * 3.0f - p[2] * 3.0f + p[3]) * 0.5f;
+        s.b = (p[0] * 2.0f - p[1] * 5.0f + p[2] * 4.0f - p[3]) * 0.5f;
+        s.c = (p[2] - p[0]) * 0.5f;
+        s.d = p[1];
+        return s;
+    }
+};
+
+// Knot spacings of non-uniform Catmull-Rom, |p1 - p0|^alpha
+struct CentripetalKnots
+{
+    // alpha = 1/2: no cusps or self-intersections within a segment
+    static float interval(const Vec3 &p0, const Vec3 &p1) { return std::sqrt((p1 - p0).length()); }
+};
+
+struct ChordalKnots
+{
+    // alpha = 1: follows the points most tightly, with the widest bends
+    static float interval(const Vec3 &p0, const Vec3 &p1) { return (p1 - p0).length(); }
+};
+
+// Catmull-Rom with knots spaced by Knots. The tangents at p[1] and p[2] are
+// those of the Barry-Goldman pyramid, scaled to the segment, so the segment
+// is still a cubic in u and is evaluated like any other.
+template <class Knots>
+struct NonUniformCatmullRom
+{
+    typedef Vec3 Point;
+    typedef SplineSegment Segment;
+
+    static Segment compile(const Point *p)
+    {
+        // Repeated points have no spacing; borrow the middle interval
+        const float MIN_INTERVAL = 1e-6f;
+        float d0 = Knots::interval(p[0], p[1]);
+        float d1 = Knots::interval(p[1], p[2]);
+        float d2 = Knots::interval(p[2], p[3]);
+        if (d1 < MIN_INTERVAL)
+            d1 = 1.0f;
+        if (d0 < MIN_INTERVAL)
+            d0 = d1;
+        if (d2 < MIN_INTERVAL)
+            d2 = d1;
+
+        Vec3 m1 = ((p[1] - p[0]) * (1.0f / d0) - (p[2] - p[0]) * (1.0f / (d0 + d1)) + (p[2] - p[1]) * (1.0f / d1)) * d1;
+        Vec3 m2 = ((p[2] - p[1]) * (1.0f / d1) - (p[3] - p[1]) * (1.0f / (d1 + d2)) + (p[3] - p[2]) * (1.0f / d2)) * d1;
+
+        // Cubic Hermite from p[1] to p[2]
+        Segment s;
+        s.a = (p[1] - p[2]) * 2.0f + m1 + m2;
+        s.b = (p[2] - p[1]) * 3.0f - m1 * 2.0f - m2;
+        s.c = m1;
+        s.d = p[1];
+        return s;
+    }
+};
+
+typedef NonUniformCatmullRom<CentripetalKnots> CentripetalCatmullRom;
+typedef NonUniformCatmullRom<ChordalKnots> ChordalCatmullRom;
+
+// Uniform cubic B-spline: C2, does not pass through the points
+struct UniformBSpline
+{
+    typedef Vec3 Point;
+    typedef SplineSegment Segment;
+
+    static Segment compile(const Point *p)
+    {
+        // Uniform cubic B-spline basis, scaled by 1/6
+        Segment s;
+        s.a = (p[0] * -1.0f + p[1] * 3.0f - p[2] * 3.0f + p[3]) * (1.0f / 6.0f);
+        s.b = (p[0] * 3.0f - p[1] * 6.0f + p[2] * 3.0f) * (1.0f / 6.0f);
+        s.c = (p[2] - p[0]) * 0.5f;
+        s.d = (p[0] + p[1] * 4.0f + p[2]) * (1.0f / 6.0f);
+        return s;
+    }
+};
+
+// Cubic NURBS on uniform knots. Each point carries a positive weight in w
+// that pulls the curve towards it; equal weights give UniformBSpline.
+struct RationalBSpline
+{
+    typedef Vec4 Point;
+    typedef RationalSegment Segment;
+
+    static Segment compile(const Point *p)
+    {
+        // The B-spline basis applied to (x w, y w, z w, w)
+        Vec4 h[4];
+        for (int i = 0; i < 4; i++)
+            h[i] = Vec4(p[i].x * p[i].w, p[i].y * p[i].w, p[i].z * p[i].w, p[i].w);
+
+        Segment s;
+        s.a = (h[0] * -1.0f + h[1] * 3.0f - h[2] * 3.0f + h[3]) * (1.0f / 6.0f);
+        s.b = (h[0] * 3.0f - h[1] * 6.0f + h[2] * 3.0f) * (1.0f / 6.0f);
+        s.c = (h[2] - h[0]) * 0.5f;
+        s.d = (h[0] + h[1] * 4.0f + h[2]) * (1.0f / 6.0f);
+        return s;
+    }
+};
+
+// ============================================================================
+// ENGINE
+// ============================================================================
+
+// Spline over a run of control points with its basis fixed at compile time.
+// Segment i is shaped by points i..i+3 and global t spans the segments
+// evenly, as in evaluateCatmullRom. Nothing is cached: each call compiles
+// the one segment it needs, so a loop over t runs code specialized for the
+// basis. CompiledSpline keeps every segment instead.
+template <class Basis>
+class SplineEngine
+{
+public:
+    typedef typename Basis::Point Point;
+    typedef typename Basis::Segment Segment;
+
+    SplineEngine(const Point *points, size_t count)
+        : points(points), count(count)
+    {
+    }
+
+    explicit SplineEngine(const std::vector<Point> &points)
+        : points(points.data()), count(points.size())
+    {
+    }
+
+    bool isValid() const { return count >= 4; }
+    int segmentCount() const { return count >= 4 ? (int)count - 3 : 0; }
+
+    Segment segment(int i) const { return Basis::compile(points + i); }
+
+    // Position at global parameter t in [0, 1]
+    Vec3 evaluate(float t) const
+    {
+        if (!isValid())
+            return Vec3(0, 0, 0);
+
+        int i;
+        float u;
+        locateSegment(segmentCount(), t, i, u);
+        return evaluatePolynomial(segment(i), u);
+    }
+
+    // Closed-form derivatives with respect to t; du/dt is the segment count
+    Vec3 derivative(float t) const
+    {
+        if (!isValid())
+            return Vec3(0, 0, 0);
+
+        int i;
+        float u;
+        locateSegment(segmentCount(), t, i, u);
+        return polynomialDerivative(segment(i), u) * (float)segmentCount();
+    }
+
+    Vec3 secondDerivative(float t) const
+    {
+        if (!isValid())
+            return Vec3(0, 0, 0);
+
+        int i;
+        float u;
+        locateSegment(segmentCount(), t, i, u);
+        float n = (float)segmentCount();
+        return polynomialSecondDerivative(segment(i), u) * (n * n);
+    }
+
+    // Positions and unit tangents at count parameters, as evaluate(t) and
+    // derivative(t).normalize(); either output may be null. A segment is
+    // compiled once for each run of parameters inside it, so sorted
+    // parameters compile every segment at most once.
+    void evaluate(const float *t, size_t count, Vec3 *positions, Vec3 *tangents) const
+    {
+        int current = -1;
+        Segment s;
+        for (size_t k = 0; k < count; k++)
+        {
+            Vec3 position(0, 0, 0), derivative(0, 0, 0);
+            if (isValid())
+            {
+                int i;
+                float u;
+                locateSegment(segmentCount(), t[k], i, u);
+                if (i != current)
+                {
+                    s = segment(i);
+                    current = i;
+                }
+                position = evaluatePolynomial(s, u);
+                derivative = polynomialDerivative(s, u) * (float)segmentCount();
+            }
+            if (positions)
+                positions[k] = position;
+            if (tangents)
+                tangents[k] = derivative.normalize();
+        }
+    }
+
+private:
+    const Point *points;
+    size_t count;
+};
+
+// Call f with the basis of a runtime spline type, as f(Basis()). The switch
+// is taken once; whatever f does inside is specialized for the basis.
+template <class Function>
+auto visitSplineBasis(SplineType type, Function &&f) -> decltype(f(UniformCatmullRom()))
+{
+    switch (type)
+    {
+    case CENTRIPETAL_CATMULL_ROM:
+        return f(CentripetalCatmullRom());
+    case CHORDAL_CATMULL_ROM:
+        return f(ChordalCatmullRom());
+    case BSPLINE:
+        return f(UniformBSpline());
+    default:
+        return f(UniformCatmullRom());
+    }
+}
+
+#endif // SPLINE_ENGINE_H
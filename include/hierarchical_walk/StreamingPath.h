@@ -0,0 +1,114 @@
+#ifndef STREAMING_PATH_H
+#define STREAMING_PATH_H
+
+#include "CompiledSpline.h"
+#include "Spline.h"
+#include "Vec3.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+const size_t DEFAULT_STREAM_WINDOW = 4096;    // Segments kept in memory
+const size_t STREAM_CHUNK_BYTES = 64 * 1024;  // Bytes read from the source at a time
+const float STREAM_WALKER_SPACING = 0.25f;    // Segments between walkers lined up on a stream
+const int STREAM_DRAW_SAMPLES = 8;            // Polyline points per drawn segment
+
+// Position of a walker on a streaming path
+struct StreamCursor
+{
+    uint64_t segment; // Absolute index, counted from the first segment of the stream
+    float u;          // Local parameter in [0, 1]
+
+    StreamCursor();
+};
+
+// Path read from a file or pipe while it is being walked. The source uses
+// the text path format (spline type, dt, then points), but it never has to
+// end. A reader thread parses it in chunks and compiles each segment as its
+// fourth point arrives, into a ring of a fixed number of segments. Walkers
+// address segments by absolute index and release the ones they have passed,
+// which frees their slots for new segments. When the ring is full the reader
+// waits, so memory stays the same however long the path gets.
+//
+// One thread evaluates and releases; the reader thread only fills slots
+// that are not yet available, so evaluation takes no locks.
+class StreamingPath
+{
+public:
+    explicit StreamingPath(size_t windowSegments = DEFAULT_STREAM_WINDOW);
+    ~StreamingPath();
+    StreamingPath(const StreamingPath &) = delete;
+    StreamingPath &operator=(const StreamingPath &) = delete;
+
+    // Start reading a file, or standard input for "-"
+    bool open(const char *source);
+    void close();
+
+    // Segments [first(), available()) can be evaluated
+    uint64_t first() const { return released.load(std::memory_order_relaxed); }
+    uint64_t available() const { return produced.load(std::memory_order_acquire); }
+
+    // The source ended; available() will not grow any more
+    bool finished() const { return ended.load(std::memory_order_acquire); }
+
+    // Block until count segments are available or the source ends
+    void waitFor(uint64_t count);
+
+    // Position at local parameter u of an available segment
+    Vec3 evaluate(uint64_t segment, float u) const;
+
+    // Position, unit tangent and curvature; derivatives are with respect to u
+    SplineSample sample(uint64_t segment, float u) const;
+
+    // Segments before segment are no longer needed
+    void release(uint64_t segment);
+
+    // Header of the source, valid once a segment is available
+    SplineType type() const { return splineType; }
+    float dt() const { return pathDt; }
+
+    size_t windowSegments() const { return ring.size(); }
+    uint64_t pointsRead() const { return pointCount.load(std::memory_order_relaxed); }
+
+    // Heap bytes of the segment ring and the read chunk
+    size_t memoryBytes() const;
+
+private:
+    void readLoop();
+
+    // Parse whole points from the front of pending; false to stop reading
+    bool parsePending(bool atEnd);
+    bool addPoint(const Vec3 &point);
+
+    const SplineSegment &slot(uint64_t segment) const { return ring[segment & mask]; }
+
+    std::vector<SplineSegment> ring; // Segment i lives in slot i & mask
+    uint64_t mask;
+    std::atomic<uint64_t> produced;  // Segments compiled so far
+    std::atomic<uint64_t> released;  // Segments given up by the walkers
+    std::atomic<uint64_t> pointCount;
+    std::atomic<bool> ended;
+    std::atomic<bool> stopping;
+
+    // Reader state
+    FILE *file;
+    bool ownsFile;
+    std::thread reader;
+    std::string pending;  // Text read but not parsed yet
+    int headerLines;      // Header lines consumed so far (type, then dt)
+    Vec3 history[3];      // Last three points, the start of the next segment
+    SplineType splineType;
+    float pathDt;
+
+    // Wakes the reader when slots free up and waiters when segments arrive
+    std::mutex waitMutex;
+    std::condition_variable changed;
+};
+
+#endif // STREAMING_PATH_H
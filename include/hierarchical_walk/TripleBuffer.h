@@ -0,0 +1,46 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+
+// Lock-free hand-off of a value from one writer thread to one reader thread.
+// The writer fills back() and publish() swaps it with the shared middle slot;
+// the reader's acquire() swaps the middle slot into front() if it is newer.
+// Neither side ever waits, and the reader always sees a complete value.
+template <typename T>
+class TripleBuffer
+{
+public:
+    TripleBuffer()
+        : frontIndex(0), middle(1), backIndex(2)
+    {
+    }
+
+    // Writer side
+    T &back() { return slots[backIndex]; }
+    void publish()
+    {
+        backIndex = middle.exchange(backIndex | FRESH, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+
+    // Reader side; returns true if a newer value was published since the last call
+    bool acquire()
+    {
+        if (!(middle.load(std::memory_order_relaxed) & FRESH))
+            return false;
+        frontIndex = middle.exchange(frontIndex, std::memory_order_acq_rel) & INDEX_MASK;
+        return true;
+    }
+    const T &front() const { return slots[frontIndex]; }
+
+private:
+    static const unsigned INDEX_MASK = 3;
+    static const unsigned FRESH = 4; // Middle slot holds a value the reader has not taken
+
+    T slots[3];
+    unsigned frontIndex;          // Owned by the reader
+    std::atomic<unsigned> middle; // Slot index plus FRESH flag
+    unsigned backIndex;           // Owned by the writer
+};
+
+#endif // TRIPLE_BUFFER_H
@@ -3,18 +3,43 @@
 
 #include <cmath>
 
+// Three packed floats; binary path and replay files store it as is
 struct Vec3
 {
     float x, y, z;
-    
-    Vec3(float _x = 0, float _y = 0, float _z = 0);
-    
-    Vec3 operator+(const Vec3 &v) const;
-    Vec3 operator-(const Vec3 &v) const;
-    Vec3 operator*(float s) const;
-    
-    float length() const;
-    Vec3 normalize() const;
+
+    constexpr Vec3(float _x = 0, float _y = 0, float _z = 0) : x(_x), y(_y), z(_z) {}
+
+    constexpr Vec3 operator+(const Vec3 &v) const { return Vec3(x + v.x, y + v.y, z + v.z); }
+    constexpr Vec3 operator-(const Vec3 &v) const { return Vec3(x - v.x, y - v.y, z - v.z); }
+    constexpr Vec3 operator-() const { return Vec3(-x, -y, -z); }
+    constexpr Vec3 operator*(float s) const { return Vec3(x * s, y * s, z * s); }
+
+    Vec3 &operator+=(const Vec3 &v)
+    {
+        x += v.x;
+        y += v.y;
+        z += v.z;
+        return *this;
+    }
+
+    float length() const { return std::sqrt(x * x + y * y + z * z); }
+
+    Vec3 normalize() const
+    {
+        float len = length();
+        return len > 0 ? Vec3(x / len, y / len, z / len) : Vec3(0, 0, 0);
+    }
 };
 
-#endif // VEC3_H
\ No newline at end of file
+constexpr float dot(const Vec3 &a, const Vec3 &b)
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+constexpr Vec3 cross(const Vec3 &a, const Vec3 &b)
+{
+    return Vec3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+}
+
+#endif // VEC3_H
@@ -0,0 +1,26 @@
+#ifndef VEC4_H
+#define VEC4_H
+
+#include "Vec3.h"
+
+// Homogeneous point (w = 1) or direction (w = 0); one column of a Mat4
+struct alignas(16) Vec4
+{
+    float x, y, z, w;
+
+    constexpr Vec4(float _x = 0, float _y = 0, float _z = 0, float _w = 0) : x(_x), y(_y), z(_z), w(_w) {}
+    constexpr Vec4(const Vec3 &v, float _w) : x(v.x), y(v.y), z(v.z), w(_w) {}
+
+    constexpr Vec4 operator+(const Vec4 &v) const { return Vec4(x + v.x, y + v.y, z + v.z, w + v.w); }
+    constexpr Vec4 operator-(const Vec4 &v) const { return Vec4(x - v.x, y - v.y, z - v.z, w - v.w); }
+    constexpr Vec4 operator*(float s) const { return Vec4(x * s, y * s, z * s, w * s); }
+
+    constexpr Vec3 xyz() const { return Vec3(x, y, z); }
+};
+
+constexpr float dot(const Vec4 &a, const Vec4 &b)
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+}
+
+#endif // VEC4_H
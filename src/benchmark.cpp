@@ -0,0 +1,625 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <random>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include "hierarchical_walk/Animation.h"
+#include "hierarchical_walk/ArticulatedFigure.h"
+#include "hierarchical_walk/CompiledSpline.h"
+#include "hierarchical_walk/Constants.h"
+#include "hierarchical_walk/FileIO.h"
+#include "hierarchical_walk/Spline.h"
+#include "hierarchical_walk/SplineBatch.h"
+#include "hierarchical_walk/SplineEngine.h"
+#include "hierarchical_walk/Vec3.h"
+
+// Micro-benchmarks for the spline, animation and path-loading hot paths.
+// Each benchmark reports time per operation, throughput and heap allocations
+// per operation, and --json writes the results one per line so two runs can
+// be diffed or compared with --baseline.
+
+// ============================================================================
+// ALLOCATION COUNTING
+// ============================================================================
+
+// Every operator new in the process goes through these, so a benchmark can
+// count the allocations its operations make
+static std::atomic<uint64_t> allocationCount(0);
+static std::atomic<uint64_t> allocatedBytes(0);
+
+static void *countedAllocate(size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    void *memory = malloc(size ? size : 1);
+    if (!memory)
+        throw std::bad_alloc();
+    return memory;
+}
+
+static void *countedAllocateAligned(size_t size, std::align_val_t alignment)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    size_t align = (size_t)alignment;
+#ifdef _WIN32
+    void *memory = _aligned_malloc(size ? size : 1, align);
+#else
+    // aligned_alloc wants the size to be a multiple of the alignment
+    void *memory = aligned_alloc(align, (std::max(size, (size_t)1) + align - 1) / align * align);
+#endif
+    if (!memory)
+        throw std::bad_alloc();
+    return memory;
+}
+
+static void releaseAligned(void *memory)
+{
+#ifdef _WIN32
+    _aligned_free(memory);
+#else
+    free(memory);
+#endif
+}
+
+void *operator new(size_t size) { return countedAllocate(size); }
+void *operator new[](size_t size) { return countedAllocate(size); }
+void *operator new(size_t size, std::align_val_t alignment) { return countedAllocateAligned(size, alignment); }
+void *operator new[](size_t size, std::align_val_t alignment) { return countedAllocateAligned(size, alignment); }
+void operator delete(void *memory) noexcept { free(memory); }
+void operator delete[](void *memory) noexcept { free(memory); }
+void operator delete(void *memory, size_t) noexcept { free(memory); }
+void operator delete[](void *memory, size_t) noexcept { free(memory); }
+void operator delete(void *memory, std::align_val_t) noexcept { releaseAligned(memory); }
+void operator delete[](void *memory, std::align_val_t) noexcept { releaseAligned(memory); }
+void operator delete(void *memory, size_t, std::align_val_t) noexcept { releaseAligned(memory); }
+void operator delete[](void *memory, size_t, std::align_val_t) noexcept { releaseAligned(memory); }
+
+// ============================================================================
+// BENCHMARK RUNNER
+// ============================================================================
+
+struct BenchmarkOptions
+{
+    const char *filter = nullptr;   // Only run benchmarks whose name contains this
+    double minSeconds = 0.25;       // Time each benchmark for at least this long
+    int maxWalkers = 1000000;       // Largest crowd for the animation benchmarks
+    int maxFilePoints = 1000000;    // Largest generated path file
+    const char *jsonFile = nullptr; // Write results as JSON here, - for stdout
+    const char *baselineFile = nullptr; // Compare against an earlier JSON run
+    double threshold = 10.0;        // Percent slower than the baseline that counts as a regression
+    bool list = false;              // Print the benchmark names and exit
+};
+
+struct BenchmarkResult
+{
+    std::string name;
+    const char *unit;        // What one operation is
+    uint64_t operations;     // Operations timed
+    double nsPerOp;          // Mean over all timed batches
+    double minNsPerOp;       // Fastest batch; steadier between runs than the mean
+    double opsPerSecond;
+    double allocationsPerOp; // Heap allocations per operation while timed
+    double bytesPerOp;       // Heap bytes requested per operation while timed
+
+    BenchmarkResult();
+};
+
+BenchmarkResult::BenchmarkResult()
+    : unit(""),
+      operations(0),
+      nsPerOp(0.0),
+      minNsPerOp(0.0),
+      opsPerSecond(0.0),
+      allocationsPerOp(0.0),
+      bytesPerOp(0.0)
+{
+}
+
+// Results land here so the compiler cannot drop the work being timed
+static volatile float benchmarkSink = 0.0f;
+
+static void consume(const Vec3 &v)
+{
+    benchmarkSink = benchmarkSink + v.x + v.y + v.z;
+}
+
+class BenchmarkRunner
+{
+public:
+    explicit BenchmarkRunner(const BenchmarkOptions &options) : config(options) {}
+
+    bool selected(const std::string &name) const
+    {
+        return !config.filter || name.find(config.filter) != std::string::npos;
+    }
+
+    // batch runs opsPerBatch operations of the named benchmark. It runs once
+    // untimed to warm caches, then repeatedly until minSeconds have passed.
+    void run(const std::string &name, const char *unit, uint64_t opsPerBatch, const std::function<void()> &batch)
+    {
+        if (!selected(name))
+            return;
+        if (config.list)
+        {
+            std::cout << name << std::endl;
+            return;
+        }
+
+        typedef std::chrono::steady_clock Clock;
+        batch();
+
+        uint64_t batches = 0;
+        double totalSeconds = 0.0;
+        double fastestBatch = 1e30;
+        uint64_t allocationsBefore = allocationCount.load();
+        uint64_t bytesBefore = allocatedBytes.load();
+        while (totalSeconds < config.minSeconds || batches < 3)
+        {
+            Clock::time_point start = Clock::now();
+            batch();
+            double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+            totalSeconds += seconds;
+            fastestBatch = std::min(fastestBatch, seconds);
+            batches++;
+        }
+        uint64_t allocations = allocationCount.load() - allocationsBefore;
+        uint64_t bytes = allocatedBytes.load() - bytesBefore;
+
+        BenchmarkResult result;
+        result.name = name;
+        result.unit = unit;
+        result.operations = batches * opsPerBatch;
+        result.nsPerOp = totalSeconds * 1e9 / result.operations;
+        result.minNsPerOp = fastestBatch * 1e9 / opsPerBatch;
+        result.opsPerSecond = result.operations / totalSeconds;
+        result.allocationsPerOp = (double)allocations / result.operations;
+        result.bytesPerOp = (double)bytes / result.operations;
+        results.push_back(result);
+        printResult(result);
+    }
+
+    const std::vector<BenchmarkResult> &all() const { return results; }
+    const BenchmarkOptions &options() const { return config; }
+
+private:
+    static void printResult(const BenchmarkResult &result)
+    {
+        char line[256];
+        snprintf(line, sizeof(line), "%-48s %12.2f ns/op %12.2f min %14.4g %s/s %10.3g allocs/op %12.4g B/op",
+                 result.name.c_str(), result.nsPerOp, result.minNsPerOp, result.opsPerSecond, result.unit,
+                 result.allocationsPerOp, result.bytesPerOp);
+        std::cout << line << std::endl;
+    }
+
+    BenchmarkOptions config;
+    std::vector<BenchmarkResult> results;
+};
+
+// ============================================================================
+// WORKLOADS
+// ============================================================================
+
+// Closed loop of count points on a wobbly circle, with the first three
+// repeated at the end so the spline closes like the default path
+static std::vector<Vec3> makeLoop(int count)
+{
+    std::vector<Vec3> points;
+    points.reserve(count + 3);
+    for (int i = 0; i < count; i++)
+    {
+        float angle = i * 2 * PI / count;
+        float radius = 3.0f + 0.5f * sin(angle * 7.0f);
+        points.push_back(Vec3(radius * cos(angle), 0, radius * sin(angle)));
+    }
+    for (int i = 0; i < 3; i++)
+        points.push_back(points[i]);
+    return points;
+}
+
+// Evaluations per batch; t sweeps [0, 1] so every segment is visited
+const int SPLINE_SAMPLES = 4096;
+
+static void benchmarkSplines(BenchmarkRunner &runner)
+{
+    const int sizes[] = {8, 64, 1024, 65536};
+    for (int size : sizes)
+    {
+        std::vector<Vec3> points = makeLoop(size);
+        std::string suffix = "/points:" + std::to_string(size);
+
+        runner.run("spline/catmull_rom" + suffix, "evaluations", SPLINE_SAMPLES, [&]()
+        {
+            Vec3 sum(0, 0, 0);
+            for (int i = 0; i < SPLINE_SAMPLES; i++)
+                sum += evaluateCatmullRom(points, (i + 0.5f) / SPLINE_SAMPLES);
+            consume(sum);
+        });
+        runner.run("spline/bspline" + suffix, "evaluations", SPLINE_SAMPLES, [&]()
+        {
+            Vec3 sum(0, 0, 0);
+            for (int i = 0; i < SPLINE_SAMPLES; i++)
+                sum += evaluateBSpline(points, (i + 0.5f) / SPLINE_SAMPLES);
+            consume(sum);
+        });
+        runner.run("spline/tangent_catmull_rom" + suffix, "evaluations", SPLINE_SAMPLES, [&]()
+        {
+            Vec3 sum(0, 0, 0);
+            for (int i = 0; i < SPLINE_SAMPLES; i++)
+                sum += getSplineTangent(points, (i + 0.5f) / SPLINE_SAMPLES, CATMULL_ROM);
+            consume(sum);
+        });
+        runner.run("spline/tangent_bspline" + suffix, "evaluations", SPLINE_SAMPLES, [&]()
+        {
+            Vec3 sum(0, 0, 0);
+            for (int i = 0; i < SPLINE_SAMPLES; i++)
+                sum += getSplineTangent(points, (i + 0.5f) / SPLINE_SAMPLES, BSPLINE);
+            consume(sum);
+        });
+        runner.run("spline/centripetal" + suffix, "evaluations", SPLINE_SAMPLES, [&]()
+        {
+            SplineEngine<CentripetalCatmullRom> spline(points);
+            Vec3 sum(0, 0, 0);
+            for (int i = 0; i < SPLINE_SAMPLES; i++)
+                sum += spline.evaluate((i + 0.5f) / SPLINE_SAMPLES);
+            consume(sum);
+        });
+        runner.run("spline/chordal" + suffix, "evaluations", SPLINE_SAMPLES, [&]()
+        {
+            SplineEngine<ChordalCatmullRom> spline(points);
+            Vec3 sum(0, 0, 0);
+            for (int i = 0; i < SPLINE_SAMPLES; i++)
+                sum += spline.evaluate((i + 0.5f) / SPLINE_SAMPLES);
+            consume(sum);
+        });
+
+        std::vector<Vec4> weighted;
+        for (size_t i = 0; i < points.size(); i++)
+            weighted.push_back(Vec4(points[i], i % 2 ? 2.0f : 1.0f));
+        runner.run("spline/nurbs" + suffix, "evaluations", SPLINE_SAMPLES, [&]()
+        {
+            SplineEngine<RationalBSpline> spline(weighted);
+            Vec3 sum(0, 0, 0);
+            for (int i = 0; i < SPLINE_SAMPLES; i++)
+                sum += spline.evaluate((i + 0.5f) / SPLINE_SAMPLES);
+            consume(sum);
+        });
+
+        // Positions and tangents of a compiled path, one call per parameter
+        // and then in batches, with the parameters in order and shuffled.
+        // Up to 1024 points a batch has a SIMD block of parameters per
+        // segment and is bucketed by segment; at 65536 it is taken in order.
+        CompiledSpline path(points, CATMULL_ROM);
+        std::vector<float> sorted(SPLINE_SAMPLES);
+        for (int i = 0; i < SPLINE_SAMPLES; i++)
+            sorted[i] = (i + 0.5f) / SPLINE_SAMPLES;
+        std::vector<float> shuffled = sorted;
+        std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(1));
+        std::vector<Vec3> positions(SPLINE_SAMPLES), tangents(SPLINE_SAMPLES);
+
+        runner.run("spline/compiled_scalar" + suffix, "evaluations", SPLINE_SAMPLES, [&]()
+        {
+            for (int i = 0; i < SPLINE_SAMPLES; i++)
+            {
+                positions[i] = path.evaluate(sorted[i]);
+                tangents[i] = getSplineTangent(path, sorted[i]);
+            }
+            consume(positions[SPLINE_SAMPLES - 1] + tangents[SPLINE_SAMPLES - 1]);
+        });
+        runner.run("spline/batch_sorted" + suffix, "evaluations", SPLINE_SAMPLES, [&]()
+        {
+            evaluateSplineBatch(path, sorted.data(), SPLINE_SAMPLES, positions.data(), tangents.data());
+            consume(positions[SPLINE_SAMPLES - 1] + tangents[SPLINE_SAMPLES - 1]);
+        });
+        runner.run("spline/batch_unsorted" + suffix, "evaluations", SPLINE_SAMPLES, [&]()
+        {
+            evaluateSplineBatch(path, shuffled.data(), SPLINE_SAMPLES, positions.data(), tangents.data());
+            consume(positions[SPLINE_SAMPLES - 1] + tangents[SPLINE_SAMPLES - 1]);
+        });
+    }
+}
+
+static void benchmarkAnimation(BenchmarkRunner &runner)
+{
+    CompiledSpline path;
+    path.setControlPoints(makeLoop(8), CATMULL_ROM);
+
+    for (int walkers = 1; walkers <= runner.options().maxWalkers; walkers *= 10)
+    {
+        std::string name = "animation/update_walking/walkers:" + std::to_string(walkers);
+        if (!runner.selected(name))
+            continue;
+
+        // Walkers spread along the path, as in headless mode
+        std::vector<ArticulatedFigure> figures(walkers);
+        std::vector<AnimationState> states(walkers);
+        for (int i = 0; i < walkers; i++)
+            placeOnPath(figures[i], states[i], path, (float)i / walkers);
+
+        // Small crowds take several steps per batch so the clock is not the cost
+        int steps = std::max(1, 4096 / walkers);
+        runner.run(name, "updates", (uint64_t)walkers * steps, [&]()
+        {
+            for (int step = 0; step < steps; step++)
+            {
+                for (int i = 0; i < walkers; i++)
+                    updateWalkingAnimation(figures[i], states[i], path, 1.0f / 60.0f);
+            }
+            consume(figures[walkers - 1].position);
+        });
+    }
+}
+
+// Discards everything written to it
+class NullBuffer : public std::streambuf
+{
+protected:
+    int overflow(int c) override { return c; }
+    std::streamsize xsputn(const char *, std::streamsize count) override { return count; }
+};
+
+static bool writePathFile(const std::string &filename, int count)
+{
+    FILE *file = fopen(filename.c_str(), "w");
+    if (!file)
+        return false;
+    fprintf(file, "CATMULL_ROM\n0.01\n");
+    for (const Vec3 &point : makeLoop(count))
+        fprintf(file, "%.6f %.6f %.6f\n", point.x, point.y, point.z);
+    return fclose(file) == 0;
+}
+
+static void benchmarkLoader(BenchmarkRunner &runner)
+{
+    for (int count = 100; count <= runner.options().maxFilePoints; count *= 100)
+    {
+        std::string name = "io/load_control_points/points:" + std::to_string(count);
+        if (!runner.selected(name))
+            continue;
+
+        std::string filename = "benchmark_path_" + std::to_string(count) + ".txt";
+        if (!writePathFile(filename, count))
+        {
+            std::cerr << "Could not write " << filename << std::endl;
+            continue;
+        }
+
+        // The loader logs a summary line per file; keep it off the terminal
+        NullBuffer nullBuffer;
+        std::streambuf *console = std::cout.rdbuf(&nullBuffer);
+        SplineType type;
+        float dt;
+        bool loaded = true;
+        std::function<void()> load = [&]()
+        {
+            // A fresh vector each time, so every load pays for its own storage
+            std::vector<Vec3> points;
+            loaded = loadControlPoints(filename.c_str(), points, type, dt, true) && loaded;
+            consume(points.empty() ? Vec3(0, 0, 0) : points.back());
+        };
+        load();
+        std::cout.rdbuf(console);
+
+        // Results print between batches, so cout is swapped per batch
+        runner.run(name, "files", 1, [&]()
+        {
+            std::cout.rdbuf(&nullBuffer);
+            load();
+            std::cout.rdbuf(console);
+        });
+        remove(filename.c_str());
+        if (!loaded)
+            std::cerr << "Failed to load " << filename << std::endl;
+    }
+}
+
+// ============================================================================
+// OUTPUT
+// ============================================================================
+
+static void writeJson(std::ostream &out, const BenchmarkRunner &runner)
+{
+    // One benchmark per line with a fixed key order, so runs diff line by line
+    out << "{\n";
+    out << "  \"version\": 1,\n";
+    out << "  \"min_seconds\": " << runner.options().minSeconds << ",\n";
+    out << "  \"benchmarks\": [\n";
+    const std::vector<BenchmarkResult> &results = runner.all();
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const BenchmarkResult &r = results[i];
+        char line[512];
+        snprintf(line, sizeof(line),
+                 "    {\"name\": \"%s\", \"unit\": \"%s\", \"ns_per_op\": %.3f, \"min_ns_per_op\": %.3f, "
+                 "\"ops_per_second\": %.6g, \"allocs_per_op\": %.6g, \"bytes_per_op\": %.6g, \"operations\": %llu}%s",
+                 r.name.c_str(), r.unit, r.nsPerOp, r.minNsPerOp, r.opsPerSecond, r.allocationsPerOp, r.bytesPerOp,
+                 (unsigned long long)r.operations, i + 1 < results.size() ? "," : "");
+        out << line << "\n";
+    }
+    out << "  ]\n";
+    out << "}\n";
+}
+
+// Value of "key": in a line written by writeJson
+static bool findJsonNumber(const std::string &line, const char *key, double &value)
+{
+    std::string pattern = std::string("\"") + key + "\": ";
+    size_t at = line.find(pattern);
+    if (at == std::string::npos)
+        return false;
+    value = strtod(line.c_str() + at + pattern.size(), nullptr);
+    return true;
+}
+
+static bool findJsonString(const std::string &line, const char *key, std::string &value)
+{
+    std::string pattern = std::string("\"") + key + "\": \"";
+    size_t at = line.find(pattern);
+    if (at == std::string::npos)
+        return false;
+    at += pattern.size();
+    size_t close = line.find('"', at);
+    if (close == std::string::npos)
+        return false;
+    value = line.substr(at, close - at);
+    return true;
+}
+
+// Compare fastest-batch times and allocation counts with an earlier run;
+// returns the number of regressions
+static int compareWithBaseline(const BenchmarkRunner &runner)
+{
+    std::ifstream in(runner.options().baselineFile);
+    if (!in)
+    {
+        std::cerr << "Could not open baseline " << runner.options().baselineFile << std::endl;
+        return 1;
+    }
+
+    std::cout << std::endl << "=== Compared with " << runner.options().baselineFile << " ===" << std::endl;
+    int regressions = 0;
+    std::string line;
+    while (std::getline(in, line))
+    {
+        std::string name;
+        double baseNs, baseAllocations;
+        if (!findJsonString(line, "name", name) || !findJsonNumber(line, "min_ns_per_op", baseNs) ||
+            !findJsonNumber(line, "allocs_per_op", baseAllocations))
+            continue;
+
+        for (const BenchmarkResult &result : runner.all())
+        {
+            if (result.name != name)
+                continue;
+
+            double change = baseNs > 0.0 ? (result.minNsPerOp / baseNs - 1.0) * 100.0 : 0.0;
+            bool slower = change > runner.options().threshold;
+            bool allocates = result.allocationsPerOp > baseAllocations + 1e-3;
+            char text[256];
+            snprintf(text, sizeof(text), "%-48s %12.2f -> %12.2f ns/op %+7.1f%%%s%s", name.c_str(), baseNs,
+                     result.minNsPerOp, change, slower ? "  SLOWER" : "", allocates ? "  MORE ALLOCATIONS" : "");
+            std::cout << text << std::endl;
+            if (slower || allocates)
+                regressions++;
+        }
+    }
+    std::cout << regressions << " regression(s) over " << runner.options().threshold << "%" << std::endl;
+    return regressions;
+}
+
+// ============================================================================
+// MAIN
+// ============================================================================
+
+void printUsage(const char *program)
+{
+    std::cout << "Usage: " << program << " [options]" << std::endl;
+    std::cout << "  --filter TEXT      Only run benchmarks whose name contains TEXT" << std::endl;
+    std::cout << "  --min-time SECONDS Time each benchmark for at least this long (default 0.25)" << std::endl;
+    std::cout << "  --max-walkers N    Largest crowd for the animation benchmarks (default 1000000)" << std::endl;
+    std::cout << "  --max-points N     Largest generated path file (default 1000000)" << std::endl;
+    std::cout << "  --quick            Shorter runs and smaller sizes, for a fast check" << std::endl;
+    std::cout << "  --json FILE        Write the results as JSON, - for stdout" << std::endl;
+    std::cout << "  --baseline FILE    Compare with an earlier --json run; exit 1 on regressions" << std::endl;
+    std::cout << "  --threshold PCT    Slowdown that counts as a regression (default 10)" << std::endl;
+    std::cout << "  --list             Print the benchmark names and exit" << std::endl;
+}
+
+bool parseCommandLine(int argc, char **argv, BenchmarkOptions &options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (strcmp(arg, "--filter") == 0 && hasValue)
+            options.filter = argv[++i];
+        else if (strcmp(arg, "--min-time") == 0 && hasValue)
+            options.minSeconds = atof(argv[++i]);
+        else if (strcmp(arg, "--max-walkers") == 0 && hasValue)
+            options.maxWalkers = atoi(argv[++i]);
+        else if (strcmp(arg, "--max-points") == 0 && hasValue)
+            options.maxFilePoints = atoi(argv[++i]);
+        else if (strcmp(arg, "--quick") == 0)
+        {
+            options.minSeconds = 0.05;
+            options.maxWalkers = 10000;
+            options.maxFilePoints = 10000;
+        }
+        else if (strcmp(arg, "--json") == 0 && hasValue)
+            options.jsonFile = argv[++i];
+        else if (strcmp(arg, "--baseline") == 0 && hasValue)
+            options.baselineFile = argv[++i];
+        else if (strcmp(arg, "--threshold") == 0 && hasValue)
+            options.threshold = atof(argv[++i]);
+        else if (strcmp(arg, "--list") == 0)
+            options.list = true;
+        else
+        {
+            if (strcmp(arg, "--help") != 0 && strcmp(arg, "-h") != 0)
+                std::cerr << "Unknown or incomplete option: " << arg << std::endl;
+            return false;
+        }
+    }
+
+    if (options.minSeconds < 0.0 || options.maxWalkers < 1 || options.maxFilePoints < 1 || options.threshold < 0.0)
+    {
+        std::cerr << "Times, sizes and the threshold must not be negative" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    BenchmarkOptions options;
+    if (!parseCommandLine(argc, argv, options))
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    // With JSON on stdout the table goes to stderr instead
+    bool jsonToStdout = options.jsonFile && strcmp(options.jsonFile, "-") == 0;
+    std::streambuf *console = std::cout.rdbuf();
+    if (jsonToStdout)
+        std::cout.rdbuf(std::cerr.rdbuf());
+
+    BenchmarkRunner runner(options);
+    benchmarkSplines(runner);
+    benchmarkAnimation(runner);
+    benchmarkLoader(runner);
+
+    int regressions = 0;
+    if (options.baselineFile && !options.list)
+        regressions = compareWithBaseline(runner);
+
+    std::cout.rdbuf(console);
+    if (options.jsonFile && !options.list)
+    {
+        if (jsonToStdout)
+            writeJson(std::cout, runner);
+        else
+        {
+            std::ofstream out(options.jsonFile);
+            if (!out)
+            {
+                std::cerr << "Could not write " << options.jsonFile << std::endl;
+                return 1;
+            }
+            writeJson(out, runner);
+        }
+    }
+    return regressions == 0 ? 0 : 1;
+}
@@ -7,40 +7,25 @@ AnimationState::AnimationState()
       dt(DEFAULT_DT),
       walkCycle(0.0f),
       walkSpeed(DEFAULT_WALK_SPEED),
-      animationSpeed(DEFAULT_ANIMATION_SPEED)
+      animationSpeed(DEFAULT_ANIMATION_SPEED),
+      distance(0.0f)
 {
 }
 
-void updateWalkingAnimation(
+// Move the figure to its new path position and derive the walking pose from the distance covered
+static void applyWalkingPose(
     ArticulatedFigure &figure,
     AnimationState &state,
-    const std::vector<Vec3> &controlPoints,
-    SplineType splineType,
-    float deltaTime)
+    const Vec3 &newPos,
+    const Vec3 &forward)
 {
-    if (controlPoints.size() < 4)
-        return;
-
-    // Apply animation speed multiplier AND the dt value from file
-    deltaTime *= state.animationSpeed * state.dt;
-
-    // Update time parameter
-    state.t += deltaTime;
-    if (state.t > 1.0f)
-        state.t = 0.0f; // Loop animation
-
-    // Get current position and forward direction from spline
-    Vec3 newPos = (splineType == CATMULL_ROM) 
-        ? evaluateCatmullRom(controlPoints, state.t) 
-        : evaluateBSpline(controlPoints, state.t);
-
     // Calculate velocity for walk speed synchronization
     Vec3 velocity = newPos - figure.position;
     float speed = velocity.length();
     figure.position = newPos;
 
     // Update forward direction
-    figure.forward = getSplineTangent(controlPoints, state.t, splineType);
+    figure.forward = forward;
 
     // Calculate body tilt based on speed (lean forward when moving faster)
     figure.bodyTilt = speed * 5.0f;
@@ -52,14 +37,204 @@ void updateWalkingAnimation(
     if (state.walkCycle > 2 * PI)
         state.walkCycle -= 2 * PI;
 
+    applyGaitPhase(figure, state.walkCycle);
+}
+
+void applyGaitPhase(ArticulatedFigure &figure, float walkCycle)
+{
     // Calculate leg angles using sinusoidal motion
     // Hip angles: opposite phases for left and right legs
-    float hipSwing = 30.0f; // Maximum hip angle in degrees
-    figure.leftHipAngle = sin(state.walkCycle) * hipSwing;
-    figure.rightHipAngle = sin(state.walkCycle + PI) * hipSwing;
+    figure.leftHipAngle = sin(walkCycle) * HIP_SWING;
+    figure.rightHipAngle = sin(walkCycle + PI) * HIP_SWING;
 
     // Knee angles: bend when leg is forward
-    float kneeBend = 20.0f;
-    figure.leftKneeAngle = (sin(state.walkCycle) < 0) ? -sin(state.walkCycle) * kneeBend : 0;
-    figure.rightKneeAngle = (sin(state.walkCycle + PI) < 0) ? -sin(state.walkCycle + PI) * kneeBend : 0;
-}
\ No newline at end of file
+    figure.leftKneeAngle = (sin(walkCycle) < 0) ? -sin(walkCycle) * KNEE_BEND : 0;
+    figure.rightKneeAngle = (sin(walkCycle + PI) < 0) ? -sin(walkCycle + PI) * KNEE_BEND : 0;
+}
+
+// Advance the path parameter, looping at the end of the path
+static void advancePathParameter(AnimationState &state, float deltaTime)
+{
+    // Apply animation speed multiplier AND the dt value from file
+    deltaTime *= state.animationSpeed * state.dt;
+
+    // Update time parameter; past the end, loop and keep the overshoot
+    state.t += deltaTime;
+    if (state.t > 1.0f)
+        state.t -= (float)(int)state.t;
+}
+
+void updateWalkingAnimation(
+    ArticulatedFigure &figure,
+    AnimationState &state,
+    const std::vector<Vec3> &controlPoints,
+    SplineType splineType,
+    float deltaTime)
+{
+    if (controlPoints.size() < 4)
+        return;
+
+    advancePathParameter(state, deltaTime);
+
+    // Get current position and forward direction from spline
+    Vec3 newPos = evaluateSpline(controlPoints, state.t, splineType);
+
+    applyWalkingPose(figure, state, newPos, getSplineTangent(controlPoints, state.t, splineType));
+}
+
+void updateWalkingAnimation(
+    ArticulatedFigure &figure,
+    AnimationState &state,
+    const CompiledSpline &path,
+    float deltaTime)
+{
+    if (!path.isValid())
+        return;
+
+    advancePathParameter(state, deltaTime);
+
+    // Position and forward direction from a single segment lookup
+    SplineSample sample = path.sample(state.t);
+    applyWalkingPose(figure, state, sample.position, sample.tangent);
+}
+
+void updateWalkingAnimation(
+    ArticulatedFigure &figure,
+    AnimationState &state,
+    const CompiledSpline &path,
+    const ArcLengthTable &arcLength,
+    float deltaTime)
+{
+    if (!path.isValid() || !arcLength.isValid())
+        return;
+
+    // Same scaling as the parameter step, converted to distance
+    float length = arcLength.totalLength();
+    state.distance += deltaTime * state.animationSpeed * state.dt * length;
+    if (state.distance > length)
+        state.distance = fmod(state.distance, length); // Loop, keeping the overshoot
+
+    state.t = arcLength.parameterAtDistanceUniform(state.distance);
+
+    SplineSample sample = path.sample(state.t);
+    applyWalkingPose(figure, state, sample.position, sample.tangent);
+}
+
+void placeOnPath(
+    ArticulatedFigure &figure,
+    AnimationState &state,
+    const CompiledSpline &path,
+    float phase)
+{
+    state.t = phase;
+    state.walkCycle = 0.0f;
+
+    // Start on the path so the first update does not see a jump from the origin
+    if (path.isValid())
+    {
+        SplineSample sample = path.sample(phase);
+        figure.position = sample.position;
+        figure.forward = sample.tangent;
+    }
+}
+
+void placeOnPath(
+    ArticulatedFigure &figure,
+    AnimationState &state,
+    const CompiledSpline &path,
+    const ArcLengthTable &arcLength,
+    float phase)
+{
+    state.distance = phase * arcLength.totalLength();
+    placeOnPath(figure, state, path, arcLength.parameterAtDistanceUniform(state.distance));
+}
+
+// Offset to the right of a heading, on the ground plane
+static Vec3 lateralVector(const Vec3 &forward, float offset)
+{
+    float length = std::sqrt(forward.x * forward.x + forward.z * forward.z);
+    if (length == 0.0f)
+        return Vec3(0.0f, 0.0f, 0.0f);
+    return Vec3(forward.z, 0.0f, -forward.x) * (offset / length);
+}
+
+void updateWalkingAnimation(
+    ArticulatedFigure &figure,
+    AnimationState &state,
+    const WalkerPath &walker,
+    const PathRegistry &paths,
+    float deltaTime)
+{
+    const PathData &path = paths[walker.path];
+
+    // The gait runs on the path itself; the offset comes off along the old
+    // heading and goes back on along the new one
+    bool lateral = walker.lateralOffset != 0.0f;
+    if (lateral)
+        figure.position = figure.position - lateralVector(figure.forward, walker.lateralOffset);
+
+    float step = deltaTime * walker.speedScale;
+    if (walker.constantSpeed)
+        updateWalkingAnimation(figure, state, path.spline, path.arcLength, step);
+    else
+        updateWalkingAnimation(figure, state, path.spline, step);
+
+    if (lateral)
+        figure.position += lateralVector(figure.forward, walker.lateralOffset);
+}
+
+void placeOnPath(
+    ArticulatedFigure &figure,
+    AnimationState &state,
+    const WalkerPath &walker,
+    const PathRegistry &paths,
+    float phase)
+{
+    const PathData &path = paths[walker.path];
+    state.dt = path.dt;
+    if (walker.constantSpeed)
+        placeOnPath(figure, state, path.spline, path.arcLength, phase);
+    else
+        placeOnPath(figure, state, path.spline, phase);
+    figure.position += lateralVector(figure.forward, walker.lateralOffset);
+}
+
+void updateWalkingAnimation(
+    ArticulatedFigure &figure,
+    AnimationState &state,
+    const StreamingPath &path,
+    StreamCursor &cursor,
+    float deltaTime)
+{
+    uint64_t available = path.available();
+    if (cursor.segment >= available)
+        return;
+
+    cursor.u += deltaTime * state.animationSpeed * state.dt;
+    while (cursor.u >= 1.0f && cursor.segment + 1 < available)
+    {
+        cursor.u -= 1.0f;
+        cursor.segment++;
+    }
+    if (cursor.u > 1.0f)
+        cursor.u = 1.0f; // Out of path: stand still until more arrives
+
+    SplineSample sample = path.sample(cursor.segment, cursor.u);
+    applyWalkingPose(figure, state, sample.position, sample.tangent);
+}
+
+void placeOnPath(
+    ArticulatedFigure &figure,
+    AnimationState &state,
+    const StreamingPath &path,
+    const StreamCursor &cursor)
+{
+    state.dt = path.dt();
+    state.walkCycle = 0.0f;
+    if (cursor.segment < path.available())
+    {
+        SplineSample sample = path.sample(cursor.segment, cursor.u);
+        figure.position = sample.position;
+        figure.forward = sample.tangent;
+    }
+}
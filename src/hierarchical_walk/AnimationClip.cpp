@@ -0,0 +1,482 @@
+#include "hierarchical_walk/AnimationClip.h"
+#include "hierarchical_walk/ByteStream.h"
+#include "hierarchical_walk/Constants.h"
+#include "hierarchical_walk/FileIO.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+
+static const char CLIP_MAGIC[4] = {'H', 'W', 'A', 'C'};
+static const uint32_t CLIP_VERSION = 2;
+
+namespace
+{
+
+// ============================================================================
+// BIT HELPERS
+// ============================================================================
+
+// Branch-free popcount; the compiler builtin is a library call unless the
+// build targets a CPU with a popcount instruction
+int bitCount(uint32_t x)
+{
+    x = x - ((x >> 1) & 0x55555555u);
+    x = (x & 0x33333333u) + ((x >> 2) & 0x33333333u);
+    x = (x + (x >> 4)) & 0x0f0f0f0fu;
+    return (int)((x * 0x01010101u) >> 24);
+}
+
+// Index of the lowest and highest set bit; x must not be zero
+int lowestBit(uint32_t x)
+{
+    return bitCount((x & (0u - x)) - 1);
+}
+
+int highestBit(uint32_t x)
+{
+    x |= x >> 1;
+    x |= x >> 2;
+    x |= x >> 4;
+    x |= x >> 8;
+    x |= x >> 16;
+    return bitCount(x) - 1;
+}
+
+uint32_t blockCount(uint32_t frameCount)
+{
+    return (frameCount + CLIP_BLOCK_FRAMES - 1) / CLIP_BLOCK_FRAMES;
+}
+
+// ============================================================================
+// BAKING
+// ============================================================================
+
+// Pose tracks of a figure; the gait phase is kept by the caller
+void poseValues(const ArticulatedFigure &figure, float *values)
+{
+    values[CLIP_POSITION_X] = figure.position.x;
+    values[CLIP_POSITION_Y] = figure.position.y;
+    values[CLIP_POSITION_Z] = figure.position.z;
+    values[CLIP_FORWARD_X] = figure.forward.x;
+    values[CLIP_FORWARD_Y] = figure.forward.y;
+    values[CLIP_FORWARD_Z] = figure.forward.z;
+    values[CLIP_BODY_TILT] = figure.bodyTilt;
+}
+
+// Phase gained in one step; the live walk cycle wraps at 2 * PI
+double phaseStep(float before, float after)
+{
+    double step = (double)after - before;
+    return step < 0.0 ? step + 2.0 * PI : step;
+}
+
+// One live update, adding the phase gained to an unwrapped total
+void stepWalk(
+    ArticulatedFigure &figure,
+    AnimationState &state,
+    const CompiledSpline &path,
+    const ArcLengthTable *arcLength,
+    float stepSeconds,
+    double &phase)
+{
+    float before = state.walkCycle;
+    if (arcLength)
+        updateWalkingAnimation(figure, state, path, *arcLength, stepSeconds);
+    else
+        updateWalkingAnimation(figure, state, path, stepSeconds);
+    phase += phaseStep(before, state.walkCycle);
+}
+
+float trackTolerance(const ClipTolerance &tolerance, int track)
+{
+    if (track <= CLIP_POSITION_Z)
+        return tolerance.position;
+    if (track <= CLIP_FORWARD_Z)
+        return tolerance.direction;
+    // A hip angle changes by at most HIP_SWING degrees per radian of phase
+    if (track == CLIP_WALK_CYCLE)
+        return tolerance.angle / HIP_SWING;
+    return tolerance.angle;
+}
+
+// Every frame between keys a and b lies within tolerance of the line through
+// them, on every track. values holds CLIP_TRACK_COUNT floats per frame.
+bool spanFits(const std::vector<float> &values, uint32_t a, uint32_t b, const float *tolerances)
+{
+    for (int track = 0; track < CLIP_TRACK_COUNT; track++)
+    {
+        float va = values[(size_t)a * CLIP_TRACK_COUNT + track];
+        float slope = (values[(size_t)b * CLIP_TRACK_COUNT + track] - va) / (float)(b - a);
+        for (uint32_t m = a + 1; m < b; m++)
+        {
+            if (fabs(va + slope * (m - a) - values[(size_t)m * CLIP_TRACK_COUNT + track]) > tolerances[track])
+                return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+// ============================================================================
+// CLIP
+// ============================================================================
+
+ClipTolerance::ClipTolerance()
+    : position(0.001f),
+      direction(0.001f),
+      angle(0.1f)
+{
+}
+
+ClipTrackRange::ClipTrackRange()
+    : minimum(0.0f),
+      scale(0.0f)
+{
+}
+
+AnimationClip::AnimationClip()
+    : frameCount(0),
+      frameSeconds(0.0f),
+      loopSeconds(0.0),
+      cyclePerLoop(0.0)
+{
+    for (int i = 0; i < CLIP_TRACK_COUNT; i++)
+        errors[i] = 0.0f;
+}
+
+bool AnimationClip::bake(
+    const CompiledSpline &path,
+    const ArcLengthTable *arcLength,
+    const AnimationState &initial,
+    float stepSeconds,
+    const ClipTolerance &tolerance)
+{
+    frameCount = 0;
+    if (!path.isValid() || (arcLength && !arcLength->isValid()) || stepSeconds <= 0.0f)
+        return false;
+
+    // Both walking modes cover the path once in 1 / (animationSpeed * dt) seconds
+    double rate = (double)initial.animationSpeed * initial.dt;
+    if (rate <= 0.0)
+        return false;
+    double steps = std::ceil(1.0 / rate / stepSeconds);
+    if (steps + 1.0 > MAX_CLIP_FRAMES)
+    {
+        std::cerr << "Error: One loop takes " << steps << " steps; clips hold at most " << MAX_CLIP_FRAMES << std::endl;
+        return false;
+    }
+
+    // Frame 0 is the placed pose; then the live update once around, up to
+    // the step in which the path wraps. Rounding in the live parameter moves
+    // the wrap a little from 1 / rate, so the loop ends where it happens.
+    ArticulatedFigure figure;
+    AnimationState state = initial;
+    if (arcLength)
+        placeOnPath(figure, state, path, *arcLength, 0.0f);
+    else
+        placeOnPath(figure, state, path, 0.0f);
+
+    std::vector<float> values;
+    values.reserve(((size_t)steps + 2) * CLIP_TRACK_COUNT);
+    double phase = 0.0;
+    double loopSteps = 0.0;
+    for (uint32_t i = 0; loopSteps == 0.0 && i < MAX_CLIP_FRAMES; i++)
+    {
+        if (i > 0)
+        {
+            float t = state.t;
+            stepWalk(figure, state, path, arcLength, stepSeconds, phase);
+            if (state.t < t)
+                loopSteps = (i - 1) + (1.0 - t) / (1.0 - t + state.t);
+        }
+        values.resize(values.size() + CLIP_TRACK_COUNT);
+        float *frame = &values[values.size() - CLIP_TRACK_COUNT];
+        poseValues(figure, frame);
+        frame[CLIP_WALK_CYCLE] = (float)phase;
+    }
+    if (loopSteps == 0.0)
+    {
+        std::cerr << "Error: The walk did not wrap within " << MAX_CLIP_FRAMES << " frames" << std::endl;
+        return false;
+    }
+    uint32_t count = (uint32_t)(values.size() / CLIP_TRACK_COUNT);
+    uint32_t last = count - 1;
+    double loop = loopSteps * stepSeconds;
+
+    // 16-bit range of each track. Quantizing moves a key by up to half a
+    // step, so key reduction keeps that much of the tolerance in reserve.
+    float tolerances[CLIP_TRACK_COUNT];
+    for (int track = 0; track < CLIP_TRACK_COUNT; track++)
+    {
+        float lowest = values[track];
+        float highest = values[track];
+        for (uint32_t i = 1; i < count; i++)
+        {
+            lowest = std::min(lowest, values[(size_t)i * CLIP_TRACK_COUNT + track]);
+            highest = std::max(highest, values[(size_t)i * CLIP_TRACK_COUNT + track]);
+        }
+        ranges[track].minimum = lowest;
+        ranges[track].scale = (highest - lowest) / 65535.0f;
+        tolerances[track] = std::max(0.0f, trackTolerance(tolerance, track) - ranges[track].scale * 0.5f);
+    }
+
+    // Greedy per block: extend each span while the line between its ends
+    // reproduces every frame in it. Spans stop at block starts, which are
+    // always keys, so every block decodes on its own.
+    keyMasks.assign(blockCount(count), 0);
+    keys.clear();
+    for (uint32_t start = 0; start < count; start += CLIP_BLOCK_FRAMES)
+    {
+        uint32_t blockEnd = std::min(start + CLIP_BLOCK_FRAMES, last);
+        uint32_t key = start;
+        for (;;)
+        {
+            keyMasks[start / CLIP_BLOCK_FRAMES] |= 1u << (key - start);
+            for (int track = 0; track < CLIP_TRACK_COUNT; track++)
+            {
+                const ClipTrackRange &range = ranges[track];
+                float v = values[(size_t)key * CLIP_TRACK_COUNT + track];
+                float q = range.scale > 0.0f ? (v - range.minimum) / range.scale : 0.0f;
+                keys.push_back((uint16_t)std::min(65535.0f, std::floor(q + 0.5f)));
+            }
+
+            if (key >= blockEnd)
+                break;
+            uint32_t next = key + 1;
+            while (next < blockEnd && spanFits(values, key, next + 1, tolerances))
+                next++;
+            // A block end that starts the next block is that block's first key
+            if (next == start + CLIP_BLOCK_FRAMES)
+                break;
+            key = next;
+        }
+    }
+    buildKeyOffsets();
+
+    frameCount = count;
+    frameSeconds = stepSeconds;
+    loopSeconds = loop;
+
+    // Phase at the end of the loop, inside the last step
+    float phase0 = values[(size_t)(last - 1) * CLIP_TRACK_COUNT + CLIP_WALK_CYCLE];
+    float phase1 = values[(size_t)last * CLIP_TRACK_COUNT + CLIP_WALK_CYCLE];
+    cyclePerLoop = phase0 + (phase1 - phase0) * (loopSteps - (last - 1));
+
+    // Check playback against the live walk from the start of the path until
+    // a block of frames past the wrap, so both ends of the loop are covered
+    for (int track = 0; track < CLIP_TRACK_COUNT; track++)
+        errors[track] = 0.0f;
+    for (uint32_t i = 0; i < count + CLIP_BLOCK_FRAMES; i++)
+    {
+        if (i >= count)
+            stepWalk(figure, state, path, arcLength, stepSeconds, phase);
+
+        float live[CLIP_TRACK_COUNT];
+        float decoded[CLIP_TRACK_COUNT];
+        if (i < count)
+            std::copy(&values[(size_t)i * CLIP_TRACK_COUNT], &values[(size_t)(i + 1) * CLIP_TRACK_COUNT], live);
+        else
+            poseValues(figure, live);
+        double played = sampleTracks((double)i * stepSeconds, decoded);
+        double livePhase = i < count ? live[CLIP_WALK_CYCLE] : phase;
+        decoded[CLIP_WALK_CYCLE] = (float)(played - livePhase);
+        live[CLIP_WALK_CYCLE] = 0.0f;
+
+        for (int track = 0; track < CLIP_TRACK_COUNT; track++)
+            errors[track] = std::max(errors[track], (float)fabs(decoded[track] - live[track]));
+    }
+    return true;
+}
+
+void AnimationClip::buildKeyOffsets()
+{
+    keyOffsets.resize(keyMasks.size());
+    uint32_t offset = 0;
+    for (size_t block = 0; block < keyMasks.size(); block++)
+    {
+        keyOffsets[block] = offset;
+        offset += bitCount(keyMasks[block]);
+    }
+}
+
+void AnimationClip::findKeys(uint32_t frame, uint32_t &frame0, uint32_t &frame1, uint32_t &index) const
+{
+    uint32_t block = frame / CLIP_BLOCK_FRAMES;
+    uint32_t bit = frame % CLIP_BLOCK_FRAMES;
+    uint32_t mask = keyMasks[block];
+    uint32_t blockStart = block * CLIP_BLOCK_FRAMES;
+
+    // Key at or before the frame; bit 0 is always set
+    uint32_t atOrBelow = mask & (0xffffffffu >> (31 - bit));
+    index = keyOffsets[block] + bitCount(atOrBelow) - 1;
+    frame0 = blockStart + highestBit(atOrBelow);
+
+    // Next key: later in the block, else the next block's first frame
+    uint32_t above = mask & ~atOrBelow;
+    frame1 = above ? blockStart + lowestBit(above) : blockStart + CLIP_BLOCK_FRAMES;
+}
+
+void AnimationClip::decode(uint32_t index, float alpha, float *values) const
+{
+    const uint16_t *key0 = &keys[(size_t)index * CLIP_TRACK_COUNT];
+    const uint16_t *key1 = key0 + CLIP_TRACK_COUNT;
+    for (int track = 0; track < CLIP_TRACK_COUNT; track++)
+    {
+        float q = key0[track] + ((float)key1[track] - (float)key0[track]) * alpha;
+        values[track] = ranges[track].minimum + q * ranges[track].scale;
+    }
+}
+
+double AnimationClip::sampleTracks(double seconds, float *values) const
+{
+    double loops = std::floor(seconds / loopSeconds);
+    double time = seconds - loops * loopSeconds;
+    double x = time / frameSeconds;
+    uint32_t frame = std::min((uint32_t)x, frameCount - 2);
+
+    uint32_t frame0, frame1, index;
+    findKeys(frame, frame0, frame1, index);
+    decode(index, (float)((x - frame0) / (frame1 - frame0)), values);
+    return values[CLIP_WALK_CYCLE] + loops * cyclePerLoop;
+}
+
+void AnimationClip::sample(double seconds, ArticulatedFigure &figure) const
+{
+    if (!isValid())
+        return;
+
+    float values[CLIP_TRACK_COUNT];
+    double phase = sampleTracks(seconds, values);
+
+    figure.position = Vec3(values[CLIP_POSITION_X], values[CLIP_POSITION_Y], values[CLIP_POSITION_Z]);
+    Vec3 forward(values[CLIP_FORWARD_X], values[CLIP_FORWARD_Y], values[CLIP_FORWARD_Z]);
+    if (forward.length() > 1e-6f)
+        figure.forward = forward.normalize();
+    figure.bodyTilt = values[CLIP_BODY_TILT];
+    applyGaitPhase(figure, (float)fmod(phase, 2.0 * PI));
+}
+
+size_t AnimationClip::memoryBytes() const
+{
+    return keyMasks.size() * sizeof(uint32_t) + keyOffsets.size() * sizeof(uint32_t) + keys.size() * sizeof(uint16_t);
+}
+
+// Header, track ranges, block masks, then the interleaved keys. Key offsets
+// are prefix sums of the masks and are rebuilt on load.
+bool AnimationClip::save(const char *filename) const
+{
+    ByteWriter out;
+    out.put(CLIP_MAGIC, sizeof(CLIP_MAGIC));
+    out.putU32(CLIP_VERSION);
+    out.putU32(CLIP_TRACK_COUNT);
+    out.putU32(frameCount);
+    out.putFloat(frameSeconds);
+    out.put(&loopSeconds, sizeof(loopSeconds));
+    out.put(&cyclePerLoop, sizeof(cyclePerLoop));
+    for (const ClipTrackRange &range : ranges)
+    {
+        out.putFloat(range.minimum);
+        out.putFloat(range.scale);
+    }
+    out.putU32((uint32_t)keyCount());
+    out.put(keyMasks.data(), keyMasks.size() * sizeof(uint32_t));
+    out.put(keys.data(), keys.size() * sizeof(uint16_t));
+
+    FILE *file = fopen(filename, "wb");
+    if (!file)
+    {
+        std::cerr << "Error: Could not write " << filename << std::endl;
+        return false;
+    }
+    bool ok = fwrite(out.bytes.data(), 1, out.bytes.size(), file) == out.bytes.size();
+    ok = fclose(file) == 0 && ok;
+    if (!ok)
+        std::cerr << "Error: Failed writing " << filename << std::endl;
+    return ok;
+}
+
+bool AnimationClip::load(const char *filename)
+{
+    frameCount = 0;
+    MappedFile file;
+    if (!file.open(filename))
+    {
+        std::cerr << "Error: Could not open " << filename << std::endl;
+        return false;
+    }
+
+    ByteReader in(file.data(), file.size());
+    char magic[4];
+    in.get(magic, sizeof(magic));
+    if (!in.ok || memcmp(magic, CLIP_MAGIC, sizeof(magic)) != 0)
+    {
+        std::cerr << "Error: " << filename << " is not an animation clip" << std::endl;
+        return false;
+    }
+    uint32_t version = in.getU32();
+    if (version != CLIP_VERSION)
+    {
+        std::cerr << "Error: " << filename << " has unsupported version " << version << std::endl;
+        return false;
+    }
+
+    uint32_t trackCount = in.getU32();
+    uint32_t count = in.getU32();
+    float step = in.getFloat();
+    double loop;
+    in.get(&loop, sizeof(loop));
+    double cycle;
+    in.get(&cycle, sizeof(cycle));
+    for (ClipTrackRange &range : ranges)
+    {
+        range.minimum = in.getFloat();
+        range.scale = in.getFloat();
+    }
+    uint32_t keyTotal = in.getU32();
+
+    uint32_t blocks = blockCount(count);
+    if (trackCount != CLIP_TRACK_COUNT || count < 2 || count > MAX_CLIP_FRAMES || !(step > 0.0f) ||
+        !(loop > 0.0) || loop > (double)step * (count - 1) || !std::isfinite(cycle) ||
+        (size_t)blocks * sizeof(uint32_t) + (size_t)keyTotal * CLIP_TRACK_COUNT * sizeof(uint16_t) != in.remaining())
+        in.ok = false;
+
+    if (in.ok)
+    {
+        keyMasks.resize(blocks);
+        keys.resize((size_t)keyTotal * CLIP_TRACK_COUNT);
+        in.get(keyMasks.data(), keyMasks.size() * sizeof(uint32_t));
+        in.get(keys.data(), keys.size() * sizeof(uint16_t));
+
+        // The sampler trusts the masks: every block starts with a key, the
+        // last frame is a key, nothing lies past it and the counts agree
+        uint32_t lastBit = (count - 1) % CLIP_BLOCK_FRAMES;
+        uint32_t validBits = 0xffffffffu >> (31 - lastBit);
+        size_t total = 0;
+        for (uint32_t mask : keyMasks)
+        {
+            if (!(mask & 1))
+                in.ok = false;
+            total += bitCount(mask);
+        }
+        uint32_t finalMask = keyMasks[blocks - 1];
+        if (total != keyTotal || (finalMask & ~validBits) || !(finalMask & (1u << lastBit)))
+            in.ok = false;
+    }
+
+    if (!in.ok)
+    {
+        std::cerr << "Error: " << filename << " is truncated or corrupt" << std::endl;
+        return false;
+    }
+
+    buildKeyOffsets();
+    for (int i = 0; i < CLIP_TRACK_COUNT; i++)
+        errors[i] = 0.0f;
+    frameCount = count;
+    frameSeconds = step;
+    loopSeconds = loop;
+    cyclePerLoop = cycle;
+    return true;
+}
@@ -0,0 +1,186 @@
+#include "hierarchical_walk/ArcLengthTable.h"
+#include <algorithm>
+
+ArcLengthTable::ArcLengthTable()
+    : length(0.0f),
+      sourceVersion(0)
+{
+}
+
+// Length of [u0, u0 + step] of one segment by 3-point Gauss-Legendre quadrature
+static double segmentPieceLength(const CompiledSpline &path, int segment, float u0, float step)
+{
+    const float nodes[3] = {0.1127016654f, 0.5f, 0.8872983346f};
+    const float weights[3] = {0.2777777778f, 0.4444444444f, 0.2777777778f};
+
+    double piece = 0.0;
+    for (int g = 0; g < 3; g++)
+        piece += weights[g] * path.segmentDerivative(segment, u0 + nodes[g] * step).length();
+    return piece * step;
+}
+
+void ArcLengthTable::build(const CompiledSpline &path, int samplesPerSegment)
+{
+    distances.clear();
+    uniformParameters.clear();
+    length = 0.0f;
+    sourceVersion = path.version();
+
+    if (!path.isValid())
+        return;
+    if (samplesPerSegment < 1)
+        samplesPerSegment = 1;
+
+    int numSegments = path.segmentCount();
+    float step = 1.0f / samplesPerSegment;
+
+    // Cumulative length, accumulated in double to keep long paths accurate
+    distances.reserve(numSegments * samplesPerSegment + 1);
+    distances.push_back(0.0f);
+    double total = 0.0;
+    for (int segment = 0; segment < numSegments; segment++)
+    {
+        for (int k = 0; k < samplesPerSegment; k++)
+        {
+            total += segmentPieceLength(path, segment, k * step, step);
+            distances.push_back((float)total);
+        }
+    }
+    length = (float)total;
+    resample();
+}
+
+void ArcLengthTable::update(const CompiledSpline &path, const ArcLengthTable &previous, const SplineEdit &edit)
+{
+    int samplesPerSegment = edit.oldCount > 0 ? ((int)previous.distances.size() - 1) / edit.oldCount : 0;
+    if (!path.isValid() || samplesPerSegment < 1 ||
+        (int)previous.distances.size() != edit.oldCount * samplesPerSegment + 1)
+    {
+        build(path, samplesPerSegment < 1 ? DEFAULT_ARC_SAMPLES_PER_SEGMENT : samplesPerSegment);
+        return;
+    }
+
+    // Built aside, so previous may be this table
+    int numSegments = path.segmentCount();
+    float step = 1.0f / samplesPerSegment;
+    std::vector<float> updated;
+    updated.reserve(numSegments * samplesPerSegment + 1);
+    updated.push_back(0.0f);
+    double total = 0.0;
+    for (int segment = 0; segment < numSegments; segment++)
+    {
+        // Unchanged segments keep their pieces; the float differences round
+        // a little, far below the quadrature error
+        int old = edit.previousSegment(segment);
+        for (int k = 0; k < samplesPerSegment; k++)
+        {
+            if (old >= 0)
+            {
+                int i = old * samplesPerSegment + k;
+                total += (double)previous.distances[i + 1] - previous.distances[i];
+            }
+            else
+            {
+                total += segmentPieceLength(path, segment, k * step, step);
+            }
+            updated.push_back((float)total);
+        }
+    }
+
+    distances.swap(updated);
+    length = (float)total;
+    sourceVersion = path.version();
+    resample();
+}
+
+// Resample so that entry k holds t at distance k * length / (size - 1).
+// The distances rise with k, so one forward walk over the cumulative table
+// finds the interval a binary search would, without evaluating the spline.
+void ArcLengthTable::resample()
+{
+    int uniformSize = (int)distances.size();
+    uniformParameters.resize(uniformSize);
+    int i = 1;
+    for (int k = 0; k < uniformSize; k++)
+    {
+        float s = length * k / (uniformSize - 1);
+        if (length <= 0.0f || s <= 0.0f)
+        {
+            uniformParameters[k] = 0.0f;
+            continue;
+        }
+        if (s >= length)
+        {
+            uniformParameters[k] = 1.0f;
+            continue;
+        }
+
+        // First entry with distance greater than s, as in parameterAtDistance
+        while (distances[i] <= s)
+            i++;
+        uniformParameters[k] = parameterInInterval(i, s);
+    }
+}
+
+float ArcLengthTable::parameterAtDistance(float s) const
+{
+    if (!isValid() || length <= 0.0f)
+        return 0.0f;
+    if (s <= 0.0f)
+        return 0.0f;
+    if (s >= length)
+        return 1.0f;
+
+    // First entry with distance greater than s; s lies between it and the one before
+    int i = (int)(std::upper_bound(distances.begin(), distances.end(), s) - distances.begin());
+    return parameterInInterval(i, s);
+}
+
+float ArcLengthTable::parameterInInterval(int i, float s) const
+{
+    float d0 = distances[i - 1];
+    float d1 = distances[i];
+    float fraction = (d1 > d0) ? (s - d0) / (d1 - d0) : 0.0f;
+
+    int intervals = (int)distances.size() - 1;
+    return (i - 1 + fraction) / intervals;
+}
+
+float ArcLengthTable::parameterAtDistanceUniform(float s) const
+{
+    if (!isValid() || length <= 0.0f)
+        return 0.0f;
+    if (s <= 0.0f)
+        return 0.0f;
+    if (s >= length)
+        return 1.0f;
+
+    int intervals = (int)uniformParameters.size() - 1;
+    float x = s / length * intervals;
+    int i = (int)x;
+    if (i >= intervals)
+        return 1.0f;
+
+    float fraction = x - i;
+    return uniformParameters[i] + (uniformParameters[i + 1] - uniformParameters[i]) * fraction;
+}
+
+float ArcLengthTable::distanceAtParameter(float t) const
+{
+    if (!isValid())
+        return 0.0f;
+    if (t <= 0.0f)
+        return 0.0f;
+    if (t >= 1.0f)
+        return length;
+
+    // The table is uniform in t, so the interval is found directly
+    int intervals = (int)distances.size() - 1;
+    float x = t * intervals;
+    int i = (int)x;
+    if (i >= intervals)
+        return length;
+
+    float fraction = x - i;
+    return distances[i] + (distances[i + 1] - distances[i]) * fraction;
+}
@@ -1,4 +1,7 @@
 #include "hierarchical_walk/ArticulatedFigure.h"
+#include "hierarchical_walk/Constants.h"
+#include "hierarchical_walk/Quat.h"
+#include <cmath>
 
 ArticulatedFigure::ArticulatedFigure()
     : position(0, 0, 0),
@@ -9,4 +12,117 @@ ArticulatedFigure::ArticulatedFigure()
       leftKneeAngle(0),
       rightKneeAngle(0)
 {
-}
\ No newline at end of file
+}
+
+static float lerp(float a, float b, float alpha)
+{
+    return a + (b - a) * alpha;
+}
+
+ArticulatedFigure interpolateFigure(const ArticulatedFigure &a, const ArticulatedFigure &b, float alpha)
+{
+    ArticulatedFigure figure;
+    figure.position = a.position + (b.position - a.position) * alpha;
+
+    // Blend the heading and renormalize; keep b's if the two nearly cancel
+    Vec3 forward = a.forward + (b.forward - a.forward) * alpha;
+    figure.forward = forward.length() > 1e-6f ? forward.normalize() : b.forward;
+
+    figure.bodyTilt = lerp(a.bodyTilt, b.bodyTilt, alpha);
+    figure.leftHipAngle = lerp(a.leftHipAngle, b.leftHipAngle, alpha);
+    figure.rightHipAngle = lerp(a.rightHipAngle, b.rightHipAngle, alpha);
+    figure.leftKneeAngle = lerp(a.leftKneeAngle, b.leftKneeAngle, alpha);
+    figure.rightKneeAngle = lerp(a.rightKneeAngle, b.rightKneeAngle, alpha);
+    return figure;
+}
+
+void interpolateFigures(
+    const std::vector<ArticulatedFigure> &previous,
+    const std::vector<ArticulatedFigure> &current,
+    float alpha,
+    std::vector<ArticulatedFigure> &out)
+{
+    size_t count = current.size();
+    out.resize(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        if (i < previous.size())
+            out[i] = interpolateFigure(previous[i], current[i], alpha);
+        else
+            out[i] = current[i];
+    }
+}
+
+// ============================================================================
+// SKELETON
+// ============================================================================
+
+static Skeleton buildFigureSkeleton()
+{
+    // Added in FigureJoint order; every joint bends about the figure's x axis
+    const Vec3 xAxis(1, 0, 0);
+    Skeleton skeleton;
+    skeleton.addJoint("pelvis", -1, Vec3(0, 0, 0), xAxis);
+    const char *sides[2] = {"left", "right"};
+    const float hipOffsets[2] = {-TORSO_WIDTH * 0.3f, TORSO_WIDTH * 0.3f};
+    for (int side = 0; side < 2; side++)
+    {
+        std::string prefix = sides[side];
+        int hip = skeleton.addJoint(prefix + "_hip", JOINT_PELVIS, Vec3(hipOffsets[side], 0, 0), xAxis);
+        int knee = skeleton.addJoint(prefix + "_knee", hip, Vec3(0, -LEG_LENGTH, 0), xAxis);
+        skeleton.addJoint(prefix + "_ankle", knee, Vec3(0, -LEG_LENGTH, 0), xAxis);
+    }
+    return skeleton;
+}
+
+static std::vector<SkeletonPart> buildFigureParts()
+{
+    // Leg meshes run along +z; turn them to the leg's axis
+    const Mat4 legAlign = Mat4::rotation(-90, Vec3(1, 0, 0));
+    std::vector<SkeletonPart> parts;
+    parts.push_back(SkeletonPart(JOINT_PELVIS, SHAPE_TORSO, Mat4::identity()));
+    const int hips[2] = {JOINT_LEFT_HIP, JOINT_RIGHT_HIP};
+    const int knees[2] = {JOINT_LEFT_KNEE, JOINT_RIGHT_KNEE};
+    const int ankles[2] = {JOINT_LEFT_ANKLE, JOINT_RIGHT_ANKLE};
+    for (int side = 0; side < 2; side++)
+    {
+        parts.push_back(SkeletonPart(hips[side], SHAPE_THIGH, legAlign));
+        parts.push_back(SkeletonPart(knees[side], SHAPE_KNEE, Mat4::identity()));
+        parts.push_back(SkeletonPart(knees[side], SHAPE_SHIN, legAlign));
+        parts.push_back(SkeletonPart(ankles[side], SHAPE_FOOT, Mat4::identity()));
+    }
+    return parts;
+}
+
+const Skeleton &figureSkeleton()
+{
+    static const Skeleton skeleton = buildFigureSkeleton();
+    return skeleton;
+}
+
+const std::vector<SkeletonPart> &figureParts()
+{
+    static const std::vector<SkeletonPart> parts = buildFigureParts();
+    return parts;
+}
+
+Mat4 figureRootTransform(const ArticulatedFigure &figure)
+{
+    float heading = atan2(figure.forward.x, figure.forward.z) * 180.0f / PI;
+    return rigidTransform(Quat::fromAxisAngle(Vec3(0, 1, 0), heading), figure.position);
+}
+
+void computeFigureJoints(const ArticulatedFigure &figure, Mat4 *world)
+{
+    float angles[FIGURE_JOINT_COUNT] = {};
+    angles[JOINT_PELVIS] = figure.bodyTilt;
+    angles[JOINT_LEFT_HIP] = figure.leftHipAngle;
+    angles[JOINT_LEFT_KNEE] = figure.leftKneeAngle;
+    angles[JOINT_RIGHT_HIP] = figure.rightHipAngle;
+    angles[JOINT_RIGHT_KNEE] = figure.rightKneeAngle;
+
+    const Skeleton &skeleton = figureSkeleton();
+    Mat4 local[FIGURE_JOINT_COUNT];
+    skeleton.computeLocalTransforms(angles, local);
+    skeleton.computeWorldTransforms(figureRootTransform(figure), local, world);
+}
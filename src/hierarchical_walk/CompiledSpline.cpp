@@ -0,0 +1,256 @@
+#include "hierarchical_walk/CompiledSpline.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+// Versions are unique across all splines, so a cache keyed on version()
+// can never mistake one path for another
+static unsigned nextVersion()
+{
+    static std::atomic<unsigned> counter(0);
+    return ++counter;
+}
+
+SplineEdit::SplineEdit()
+    : front(0),
+      back(0),
+      oldCount(0),
+      newCount(0)
+{
+}
+
+int SplineEdit::previousSegment(int i) const
+{
+    if (i < front)
+        return i;
+    if (i >= newCount - back)
+        return i - newCount + oldCount;
+    return -1;
+}
+
+CompiledSpline::CompiledSpline()
+    : splineType(CATMULL_ROM),
+      buildVersion(0)
+{
+}
+
+CompiledSpline::CompiledSpline(const std::vector<Vec3> &points, SplineType type)
+    : splineType(type),
+      buildVersion(0)
+{
+    setControlPoints(points, type);
+}
+
+void CompiledSpline::setControlPoints(const std::vector<Vec3> &newPoints, SplineType type)
+{
+    setControlPoints(newPoints.data(), newPoints.size(), type);
+}
+
+void CompiledSpline::setControlPoints(const Vec3 *newPoints, size_t count, SplineType type)
+{
+    // Rebuilding from our own points() must not reassign the storage being read
+    if (newPoints != points.data())
+        points.assign(newPoints, newPoints + count);
+    else
+        points.resize(count);
+    splineType = type;
+
+    int numSegments = points.size() >= 4 ? (int)points.size() - 3 : 0;
+    segments.resize(numSegments);
+    for (int i = 0; i < numSegments; i++)
+        buildSegment(i);
+
+    buildVersion = nextVersion();
+}
+
+void CompiledSpline::setControlPoint(size_t index, const Vec3 &point)
+{
+    if (index >= points.size())
+        return;
+
+    points[index] = point;
+
+    // Segment i uses points i..i+3
+    int first = (int)index - 3;
+    if (first < 0)
+        first = 0;
+    int last = (int)index;
+    if (last > segmentCount() - 1)
+        last = segmentCount() - 1;
+
+    for (int i = first; i <= last; i++)
+        buildSegment(i);
+
+    buildVersion = nextVersion();
+}
+
+SplineEdit CompiledSpline::updateControlPoints(const Vec3 *newPoints, size_t count, SplineType type)
+{
+    SplineEdit edit;
+    edit.oldCount = segmentCount();
+    edit.newCount = count >= 4 ? (int)count - 3 : 0;
+
+    // Longest runs of identical points at the start and the end. Bitwise
+    // comparison, so -0 and NaN count as changes rather than matches.
+    size_t oldSize = points.size();
+    size_t common = std::min(oldSize, count);
+    size_t prefix = 0, suffix = 0;
+    if (type == splineType && newPoints != points.data())
+    {
+        while (prefix < common && memcmp(&points[prefix], &newPoints[prefix], sizeof(Vec3)) == 0)
+            prefix++;
+        while (suffix < common - prefix &&
+               memcmp(&points[oldSize - 1 - suffix], &newPoints[count - 1 - suffix], sizeof(Vec3)) == 0)
+            suffix++;
+    }
+
+    // Segment i uses points i..i+3, so it is unchanged when all four lie in a run
+    edit.front = prefix >= 3 ? (int)prefix - 3 : 0;
+    edit.back = suffix >= 3 ? (int)suffix - 3 : 0;
+
+    // Slide the unchanged tail to its new place, then fill in the middle
+    if (edit.newCount > edit.oldCount)
+    {
+        segments.resize(edit.newCount);
+        std::move_backward(segments.begin() + edit.oldCount - edit.back, segments.begin() + edit.oldCount,
+                           segments.begin() + edit.newCount);
+    }
+    else if (edit.newCount < edit.oldCount)
+    {
+        std::move(segments.begin() + edit.oldCount - edit.back, segments.begin() + edit.oldCount,
+                  segments.begin() + edit.newCount - edit.back);
+        segments.resize(edit.newCount);
+    }
+
+    if (newPoints != points.data())
+        points.assign(newPoints, newPoints + count);
+    else
+        points.resize(count);
+    splineType = type;
+    for (int i = edit.front; i < edit.newCount - edit.back; i++)
+        buildSegment(i);
+
+    buildVersion = nextVersion();
+    return edit;
+}
+
+void CompiledSpline::clear()
+{
+    points.clear();
+    segments.clear();
+    buildVersion = nextVersion();
+}
+
+SplineSegment compileSegment(const Vec3 &p0, const Vec3 &p1, const Vec3 &p2, const Vec3 &p3, SplineType type)
+{
+    const Vec3 points[4] = {p0, p1, p2, p3};
+    return visitSplineBasis(type, [&](auto basis)
+    {
+        return decltype(basis)::compile(points);
+    });
+}
+
+void CompiledSpline::buildSegment(int i)
+{
+    segments[i] = compileSegment(points[i], points[i + 1], points[i + 2], points[i + 3], splineType);
+}
+
+void CompiledSpline::locate(float t, int &segment, float &u) const
+{
+    locateSegment(segmentCount(), t, segment, u);
+}
+
+Vec3 CompiledSpline::evaluateSegment(int segment, float u) const
+{
+    return evaluatePolynomial(segments[segment], u);
+}
+
+Vec3 CompiledSpline::evaluate(float t) const
+{
+    if (!isValid())
+        return Vec3(0, 0, 0);
+
+    int segment;
+    float u;
+    locate(t, segment, u);
+    return evaluateSegment(segment, u);
+}
+
+Vec3 CompiledSpline::segmentDerivative(int segment, float u) const
+{
+    return polynomialDerivative(segments[segment], u);
+}
+
+Vec3 CompiledSpline::segmentSecondDerivative(int segment, float u) const
+{
+    return polynomialSecondDerivative(segments[segment], u);
+}
+
+Vec3 CompiledSpline::derivative(float t) const
+{
+    if (!isValid())
+        return Vec3(0, 0, 0);
+
+    int segment;
+    float u;
+    locate(t, segment, u);
+
+    // du/dt is the segment count
+    return segmentDerivative(segment, u) * (float)segmentCount();
+}
+
+Vec3 CompiledSpline::secondDerivative(float t) const
+{
+    if (!isValid())
+        return Vec3(0, 0, 0);
+
+    int segment;
+    float u;
+    locate(t, segment, u);
+
+    float n = (float)segmentCount();
+    return segmentSecondDerivative(segment, u) * (n * n);
+}
+
+SplineSample CompiledSpline::sample(float t) const
+{
+    SplineSample result;
+    result.curvature = 0.0f;
+    if (!isValid())
+        return result;
+
+    int segment;
+    float u;
+    locate(t, segment, u);
+
+    Vec3 d1 = segmentDerivative(segment, u);
+    Vec3 d2 = segmentSecondDerivative(segment, u);
+    float n = (float)segmentCount();
+
+    result.position = evaluateSegment(segment, u);
+    result.tangent = d1.normalize();
+    result.firstDerivative = d1 * n;
+    result.secondDerivative = d2 * (n * n);
+
+    // |p' x p''| / |p'|^3, independent of the parameter scale
+    float speed = d1.length();
+    if (speed > 0.0f)
+    {
+        Vec3 cross(d1.y * d2.z - d1.z * d2.y,
+                   d1.z * d2.x - d1.x * d2.z,
+                   d1.x * d2.y - d1.y * d2.x);
+        result.curvature = cross.length() / (speed * speed * speed);
+    }
+    return result;
+}
+
+Vec3 getSplineTangent(const CompiledSpline &spline, float t)
+{
+    if (!spline.isValid())
+        return Vec3(0, 0, 0);
+
+    int segment;
+    float u;
+    spline.locate(t, segment, u);
+    return spline.segmentDerivative(segment, u).normalize();
+}
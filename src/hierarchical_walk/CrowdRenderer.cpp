@@ -0,0 +1,297 @@
+#include "hierarchical_walk/CrowdRenderer.h"
+#include "hierarchical_walk/Renderer.h"
+#include <GL/glew.h>
+#include <iostream>
+
+namespace
+{
+
+// ============================================================================
+// TRANSFORMS
+// ============================================================================
+
+void append(std::vector<float> &out, const Mat4 &t)
+{
+    out.insert(out.end(), t.data(), t.data() + 16);
+}
+
+// ============================================================================
+// INSTANCING SHADER
+// ============================================================================
+
+// Per-instance model matrix occupies attribute locations 8..11. Lower
+// locations alias the fixed-function arrays on some drivers.
+const GLuint INSTANCE_MATRIX_LOCATION = 8;
+
+// Reproduces the fixed-function lighting set up in initGL: one positional
+// light, color material for ambient and diffuse, no specular.
+const char *VERTEX_SHADER =
+    "#version 120\n"
+    "attribute mat4 instanceMatrix;\n"
+    "uniform vec3 partColor;\n"
+    "varying vec3 litColor;\n"
+    "void main()\n"
+    "{\n"
+    "    vec4 eye = gl_ModelViewMatrix * (instanceMatrix * gl_Vertex);\n"
+    "    vec3 n = normalize(gl_NormalMatrix * (mat3(instanceMatrix) * gl_Normal));\n"
+    "    vec3 l = normalize(gl_LightSource[0].position.xyz - eye.xyz);\n"
+    "    float diffuse = max(dot(n, l), 0.0);\n"
+    "    vec3 ambient = gl_LightModel.ambient.rgb + gl_LightSource[0].ambient.rgb;\n"
+    "    litColor = partColor * (ambient + gl_LightSource[0].diffuse.rgb * diffuse);\n"
+    "    gl_Position = gl_ProjectionMatrix * eye;\n"
+    "}\n";
+
+const char *FRAGMENT_SHADER =
+    "#version 120\n"
+    "varying vec3 litColor;\n"
+    "void main()\n"
+    "{\n"
+    "    gl_FragColor = vec4(litColor, 1.0);\n"
+    "}\n";
+
+struct CrowdRendererState
+{
+    GLuint program = 0;
+    GLuint instanceBuffer = 0;
+    GLint colorLocation = -1;
+    CrowdInstances instances;
+};
+
+CrowdRendererState renderer;
+
+GLuint compileShader(GLenum type, const char *source)
+{
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, nullptr);
+    glCompileShader(shader);
+
+    GLint ok = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+    if (!ok)
+    {
+        char log[1024];
+        glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+        std::cerr << "Crowd shader compile error: " << log << std::endl;
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+GLuint linkCrowdProgram()
+{
+    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, VERTEX_SHADER);
+    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, FRAGMENT_SHADER);
+    if (!vertexShader || !fragmentShader)
+    {
+        glDeleteShader(vertexShader);
+        glDeleteShader(fragmentShader);
+        return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+    glBindAttribLocation(program, INSTANCE_MATRIX_LOCATION, "instanceMatrix");
+    glLinkProgram(program);
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+
+    GLint ok = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &ok);
+    if (!ok)
+    {
+        char log[1024];
+        glGetProgramInfoLog(program, sizeof(log), nullptr, log);
+        std::cerr << "Crowd shader link error: " << log << std::endl;
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+// ============================================================================
+// DRAW PATHS
+// ============================================================================
+
+// One part mesh with its color and instance transforms
+struct PartBatch
+{
+    const Mesh *mesh;
+    float r, g, b;
+    const std::vector<float> *matrices;
+};
+
+int collectBatches(const SceneMeshes &meshes, const CrowdInstances &instances, PartBatch batches[FIGURE_SHAPE_COUNT])
+{
+    int count = 0;
+    for (int shape = 0; shape < FIGURE_SHAPE_COUNT; shape++)
+    {
+        if (instances.shapes[shape].empty())
+            continue;
+        const float *color = figureShapeColor(shape);
+        PartBatch batch = {&meshes.shapes[shape], color[0], color[1], color[2], &instances.shapes[shape]};
+        batches[count++] = batch;
+    }
+    return count;
+}
+
+int drawInstanced(const SceneMeshes &meshes, const CrowdInstances &instances)
+{
+    PartBatch batches[FIGURE_SHAPE_COUNT];
+    int batchCount = collectBatches(meshes, instances, batches);
+
+    // Upload every part's matrices into one orphaned stream buffer
+    size_t offsets[FIGURE_SHAPE_COUNT];
+    size_t totalBytes = 0;
+    for (int i = 0; i < batchCount; i++)
+    {
+        offsets[i] = totalBytes;
+        totalBytes += batches[i].matrices->size() * sizeof(float);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, renderer.instanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, totalBytes, nullptr, GL_STREAM_DRAW);
+    for (int i = 0; i < batchCount; i++)
+    {
+        glBufferSubData(GL_ARRAY_BUFFER, offsets[i],
+                        batches[i].matrices->size() * sizeof(float), batches[i].matrices->data());
+    }
+
+    glUseProgram(renderer.program);
+    int drawCalls = 0;
+    for (int i = 0; i < batchCount; i++)
+    {
+        const PartBatch &batch = batches[i];
+        GLsizei instanceCount = (GLsizei)(batch.matrices->size() / 16);
+        GLenum mode = meshPrimitiveMode(batch.mesh->primitive);
+
+        glUniform3f(renderer.colorLocation, batch.r, batch.g, batch.b);
+        glBindVertexArray(batch.mesh->vertexArray);
+        glBindBuffer(GL_ARRAY_BUFFER, renderer.instanceBuffer);
+        for (GLuint column = 0; column < 4; column++)
+        {
+            GLuint location = INSTANCE_MATRIX_LOCATION + column;
+            glEnableVertexAttribArray(location);
+            glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, 16 * sizeof(float),
+                                  (const void *)(offsets[i] + column * 4 * sizeof(float)));
+            glVertexAttribDivisor(location, 1);
+        }
+
+        glDrawElementsInstanced(mode, batch.mesh->indexCount, GL_UNSIGNED_INT, 0, instanceCount);
+        drawCalls++;
+
+        // Leave the mesh's vertex array as drawMesh expects it
+        for (GLuint column = 0; column < 4; column++)
+        {
+            glVertexAttribDivisor(INSTANCE_MATRIX_LOCATION + column, 0);
+            glDisableVertexAttribArray(INSTANCE_MATRIX_LOCATION + column);
+        }
+        glBindVertexArray(0);
+    }
+
+    glUseProgram(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    return drawCalls;
+}
+
+// Fixed-function fallback: no matrix-stack chains, one load per part
+int drawPerInstance(const SceneMeshes &meshes, const CrowdInstances &instances)
+{
+    PartBatch batches[FIGURE_SHAPE_COUNT];
+    int batchCount = collectBatches(meshes, instances, batches);
+
+    int drawCalls = 0;
+    for (int i = 0; i < batchCount; i++)
+    {
+        const PartBatch &batch = batches[i];
+        glColor3f(batch.r, batch.g, batch.b);
+
+        const std::vector<float> &matrices = *batch.matrices;
+        for (size_t m = 0; m < matrices.size(); m += 16)
+        {
+            glPushMatrix();
+            glMultMatrixf(&matrices[m]);
+            drawMesh(*batch.mesh);
+            glPopMatrix();
+            drawCalls++;
+        }
+    }
+    return drawCalls;
+}
+
+} // namespace
+
+void computeCrowdInstances(const std::vector<ArticulatedFigure> &figures, CrowdInstances &instances)
+{
+    const std::vector<SkeletonPart> &parts = figureParts();
+    size_t partsPerShape[FIGURE_SHAPE_COUNT] = {};
+    for (const SkeletonPart &part : parts)
+        partsPerShape[part.shape]++;
+    for (int shape = 0; shape < FIGURE_SHAPE_COUNT; shape++)
+    {
+        instances.shapes[shape].clear();
+        instances.shapes[shape].reserve(figures.size() * partsPerShape[shape] * 16);
+    }
+    instances.figures = (int)figures.size();
+
+    Mat4 joints[FIGURE_JOINT_COUNT];
+    for (const ArticulatedFigure &figure : figures)
+    {
+        computeFigureJoints(figure, joints);
+        for (const SkeletonPart &part : parts)
+            append(instances.shapes[part.shape], joints[part.joint] * part.placement);
+    }
+}
+
+bool initCrowdRenderer()
+{
+    releaseCrowdRenderer();
+
+    // Instanced arrays and instanced draws are core in OpenGL 3.3
+    if (!GLEW_VERSION_3_3)
+        return false;
+
+    renderer.program = linkCrowdProgram();
+    if (!renderer.program)
+        return false;
+
+    renderer.colorLocation = glGetUniformLocation(renderer.program, "partColor");
+    glGenBuffers(1, &renderer.instanceBuffer);
+    return true;
+}
+
+void releaseCrowdRenderer()
+{
+    if (renderer.instanceBuffer)
+        glDeleteBuffers(1, &renderer.instanceBuffer);
+    if (renderer.program)
+        glDeleteProgram(renderer.program);
+    renderer.instanceBuffer = 0;
+    renderer.program = 0;
+    renderer.colorLocation = -1;
+}
+
+bool crowdInstancingAvailable()
+{
+    const SceneMeshes *meshes = sceneMeshes();
+    return renderer.program != 0 && meshes && meshes->shapes[SHAPE_TORSO].vertexArray != 0;
+}
+
+int drawCrowd(const std::vector<ArticulatedFigure> &figures, bool useInstancing)
+{
+    const SceneMeshes *meshes = sceneMeshes();
+    if (!meshes)
+    {
+        // No mesh cache: draw each figure through the matrix stack
+        for (const ArticulatedFigure &figure : figures)
+            drawFigure(figure);
+        return (int)(figures.size() * figureParts().size());
+    }
+
+    computeCrowdInstances(figures, renderer.instances);
+
+    if (useInstancing && crowdInstancingAvailable())
+        return drawInstanced(*meshes, renderer.instances);
+    return drawPerInstance(*meshes, renderer.instances);
+}
@@ -0,0 +1,86 @@
+#include "hierarchical_walk/CrowdSeparation.h"
+#include "hierarchical_walk/Constants.h"
+#include <algorithm>
+
+SeparationSettings::SeparationSettings()
+    : radius(TORSO_WIDTH + 2 * LEG_RADIUS),
+      pushSpeed(2.0f),
+      returnRate(0.5f),
+      maxOffset(1.5f),
+      maxNeighbors(16)
+{
+}
+
+CrowdSeparation::CrowdSeparation(const SeparationSettings &settings)
+    : config(settings)
+{
+}
+
+void CrowdSeparation::reset(size_t walkerCount)
+{
+    offsets.assign(walkerCount, Vec3(0, 0, 0));
+    nextOffsets.assign(walkerCount, Vec3(0, 0, 0));
+    positions.resize(walkerCount);
+}
+
+void CrowdSeparation::update(
+    const std::vector<Vec3> &pathPositions,
+    float deltaTime,
+    JobSystem *jobs,
+    size_t chunkSize)
+{
+    if (pathPositions.size() != offsets.size())
+        reset(pathPositions.size());
+
+    for (size_t i = 0; i < pathPositions.size(); i++)
+        positions[i] = pathPositions[i] + offsets[i];
+    grid.build(positions, config.radius);
+
+    // Each walker reads the shared grid and writes only its own next offset
+    if (jobs)
+    {
+        jobs->parallelFor(positions.size(), cacheAlignedChunkSize(chunkSize, sizeof(Vec3)), [&](size_t begin, size_t end)
+        {
+            updateRange(deltaTime, begin, end);
+        });
+    }
+    else
+    {
+        updateRange(deltaTime, 0, positions.size());
+    }
+    offsets.swap(nextOffsets);
+}
+
+void CrowdSeparation::updateRange(float deltaTime, size_t begin, size_t end)
+{
+    float keep = std::max(0.0f, 1.0f - config.returnRate * deltaTime);
+    for (size_t i = begin; i < end; i++)
+    {
+        const Vec3 &self = positions[i];
+        Vec3 push(0, 0, 0);
+        int neighbors = 0;
+        grid.forEachNear(self, config.radius, [&](uint32_t j, const Vec3 &other)
+        {
+            if (j == i)
+                return true;
+
+            // Push harder the deeper the overlap; walkers on the same spot
+            // split by index so the pair still separates
+            float dx = self.x - other.x;
+            float dz = self.z - other.z;
+            float distance = std::sqrt(dx * dx + dz * dz);
+            float weight = 1.0f - distance / config.radius;
+            if (distance > 1e-6f)
+                push += Vec3(dx / distance, 0, dz / distance) * weight;
+            else
+                push += Vec3(i < j ? weight : -weight, 0, 0);
+            return ++neighbors < config.maxNeighbors;
+        });
+
+        Vec3 offset = offsets[i] * keep + push * (config.pushSpeed * deltaTime);
+        float length = offset.length();
+        if (length > config.maxOffset)
+            offset = offset * (config.maxOffset / length);
+        nextOffsets[i] = offset;
+    }
+}
@@ -0,0 +1,273 @@
+#include "hierarchical_walk/CrowdState.h"
+#include "hierarchical_walk/Constants.h"
+#include "hierarchical_walk/SimdLanes.h"
+#include "hierarchical_walk/SplineBatch.h"
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+
+// ============================================================================
+// KERNEL
+// ============================================================================
+
+// Advance walkers [i, i + Lanes::width)
+template <typename Lanes>
+void updateCrowdLanes(
+    CrowdState &crowd,
+    size_t i,
+    const CompiledSpline &path,
+    float deltaTime)
+{
+    const int W = Lanes::width;
+    const Lanes zero = Lanes::set(0.0f);
+    const Lanes one = Lanes::set(1.0f);
+
+    // Advance and wrap the path parameter
+    Lanes scaledDelta = Lanes::set(deltaTime) *
+        (Lanes::load(&crowd.animationSpeed[i]) * Lanes::load(&crowd.dt[i]));
+    Lanes t = Lanes::load(&crowd.t[i]) + scaledDelta;
+    t = selectGreater(t, one, t - truncateLanes(t), t);
+    t.store(&crowd.t[i]);
+
+    // New position, speed and local derivative
+    Lanes position[3], derivative[3];
+    evaluateSplineLanes(path, &crowd.t[i], position, derivative);
+
+    Lanes x = position[0];
+    Lanes y = position[1];
+    Lanes z = position[2];
+
+    Lanes vx = x - Lanes::load(&crowd.positionX[i]);
+    Lanes vy = y - Lanes::load(&crowd.positionY[i]);
+    Lanes vz = z - Lanes::load(&crowd.positionZ[i]);
+    Lanes speed = sqrtLanes(vx * vx + vy * vy + vz * vz);
+
+    x.store(&crowd.positionX[i]);
+    y.store(&crowd.positionY[i]);
+    z.store(&crowd.positionZ[i]);
+
+    // Forward direction: normalized analytic derivative, as in CompiledSpline::sample
+    Lanes dx = derivative[0];
+    Lanes dy = derivative[1];
+    Lanes dz = derivative[2];
+    Lanes len = sqrtLanes(dx * dx + dy * dy + dz * dz);
+    selectGreater(len, zero, dx / len, zero).store(&crowd.forwardX[i]);
+    selectGreater(len, zero, dy / len, zero).store(&crowd.forwardY[i]);
+    selectGreater(len, zero, dz / len, zero).store(&crowd.forwardZ[i]);
+
+    // Body tilt
+    const Lanes maxTilt = Lanes::set(15.0f);
+    Lanes tilt = speed * Lanes::set(5.0f);
+    selectGreater(tilt, maxTilt, maxTilt, tilt).store(&crowd.bodyTilt[i]);
+
+    // Walk cycle
+    const Lanes twoPi = Lanes::set(2 * PI);
+    Lanes walkCycle = Lanes::load(&crowd.walkCycle[i]) +
+        speed * Lanes::load(&crowd.walkSpeed[i]) * Lanes::set(2.0f);
+    walkCycle = selectGreater(walkCycle, twoPi, walkCycle - twoPi, walkCycle);
+    walkCycle.store(&crowd.walkCycle[i]);
+
+    // Leg angles. sin() is evaluated in double precision by the scalar path,
+    // so it stays scalar here; each phase is computed once and reused.
+    for (int j = 0; j < W; j++)
+    {
+        float cycle = crowd.walkCycle[i + j];
+        double phase = std::sin((double)cycle);
+        double opposite = std::sin((double)(cycle + PI));
+
+        crowd.leftHipAngle[i + j] = phase * HIP_SWING;
+        crowd.rightHipAngle[i + j] = opposite * HIP_SWING;
+        crowd.leftKneeAngle[i + j] = (phase < 0) ? -phase * KNEE_BEND : 0;
+        crowd.rightKneeAngle[i + j] = (opposite < 0) ? -opposite * KNEE_BEND : 0;
+    }
+}
+
+inline bool sameBits(float a, float b)
+{
+    return std::memcmp(&a, &b, sizeof(float)) == 0;
+}
+
+} // namespace
+
+// ============================================================================
+// CROWD STATE
+// ============================================================================
+
+void CrowdState::clear()
+{
+    positionX.clear();
+    positionY.clear();
+    positionZ.clear();
+    forwardX.clear();
+    forwardY.clear();
+    forwardZ.clear();
+    bodyTilt.clear();
+    leftHipAngle.clear();
+    rightHipAngle.clear();
+    leftKneeAngle.clear();
+    rightKneeAngle.clear();
+    t.clear();
+    dt.clear();
+    walkCycle.clear();
+    walkSpeed.clear();
+    animationSpeed.clear();
+}
+
+void CrowdState::addWalker(const ArticulatedFigure &figure, const AnimationState &state)
+{
+    positionX.push_back(figure.position.x);
+    positionY.push_back(figure.position.y);
+    positionZ.push_back(figure.position.z);
+    forwardX.push_back(figure.forward.x);
+    forwardY.push_back(figure.forward.y);
+    forwardZ.push_back(figure.forward.z);
+    bodyTilt.push_back(figure.bodyTilt);
+    leftHipAngle.push_back(figure.leftHipAngle);
+    rightHipAngle.push_back(figure.rightHipAngle);
+    leftKneeAngle.push_back(figure.leftKneeAngle);
+    rightKneeAngle.push_back(figure.rightKneeAngle);
+    t.push_back(state.t);
+    dt.push_back(state.dt);
+    walkCycle.push_back(state.walkCycle);
+    walkSpeed.push_back(state.walkSpeed);
+    animationSpeed.push_back(state.animationSpeed);
+}
+
+void CrowdState::setWalker(size_t i, const ArticulatedFigure &figure, const AnimationState &state)
+{
+    positionX[i] = figure.position.x;
+    positionY[i] = figure.position.y;
+    positionZ[i] = figure.position.z;
+    forwardX[i] = figure.forward.x;
+    forwardY[i] = figure.forward.y;
+    forwardZ[i] = figure.forward.z;
+    bodyTilt[i] = figure.bodyTilt;
+    leftHipAngle[i] = figure.leftHipAngle;
+    rightHipAngle[i] = figure.rightHipAngle;
+    leftKneeAngle[i] = figure.leftKneeAngle;
+    rightKneeAngle[i] = figure.rightKneeAngle;
+    t[i] = state.t;
+    dt[i] = state.dt;
+    walkCycle[i] = state.walkCycle;
+    walkSpeed[i] = state.walkSpeed;
+    animationSpeed[i] = state.animationSpeed;
+}
+
+ArticulatedFigure CrowdState::getFigure(size_t i) const
+{
+    ArticulatedFigure figure;
+    figure.position = Vec3(positionX[i], positionY[i], positionZ[i]);
+    figure.forward = Vec3(forwardX[i], forwardY[i], forwardZ[i]);
+    figure.bodyTilt = bodyTilt[i];
+    figure.leftHipAngle = leftHipAngle[i];
+    figure.rightHipAngle = rightHipAngle[i];
+    figure.leftKneeAngle = leftKneeAngle[i];
+    figure.rightKneeAngle = rightKneeAngle[i];
+    return figure;
+}
+
+AnimationState CrowdState::getAnimationState(size_t i) const
+{
+    AnimationState state;
+    state.t = t[i];
+    state.dt = dt[i];
+    state.walkCycle = walkCycle[i];
+    state.walkSpeed = walkSpeed[i];
+    state.animationSpeed = animationSpeed[i];
+    return state;
+}
+
+// ============================================================================
+// UPDATE
+// ============================================================================
+
+// Advance walkers [begin, end)
+static void updateCrowdRange(
+    CrowdState &crowd,
+    const CompiledSpline &path,
+    float deltaTime,
+    size_t begin,
+    size_t end)
+{
+    size_t i = begin;
+
+    // Full SIMD blocks, then the remainder one walker at a time
+    for (; i + SimdLanes::width <= end; i += SimdLanes::width)
+        updateCrowdLanes<SimdLanes>(crowd, i, path, deltaTime);
+    for (; i < end; i++)
+        updateCrowdLanes<ScalarLanes>(crowd, i, path, deltaTime);
+}
+
+void updateCrowdAnimation(
+    CrowdState &crowd,
+    const CompiledSpline &path,
+    float deltaTime)
+{
+    if (!path.isValid())
+        return;
+
+    updateCrowdRange(crowd, path, deltaTime, 0, crowd.size());
+}
+
+void updateCrowdAnimation(
+    CrowdState &crowd,
+    const CompiledSpline &path,
+    float deltaTime,
+    JobSystem &jobs,
+    size_t chunkSize)
+{
+    if (!path.isValid())
+        return;
+
+    // Whole cache lines per chunk also makes every chunk a whole number of SIMD blocks
+    chunkSize = cacheAlignedChunkSize(chunkSize, sizeof(float));
+    jobs.parallelFor(crowd.size(), chunkSize, [&](size_t begin, size_t end)
+    {
+        updateCrowdRange(crowd, path, deltaTime, begin, end);
+    });
+}
+
+void updateCrowdAnimationScalar(
+    CrowdState &crowd,
+    const CompiledSpline &path,
+    float deltaTime)
+{
+    for (size_t i = 0; i < crowd.size(); i++)
+    {
+        ArticulatedFigure figure = crowd.getFigure(i);
+        AnimationState state = crowd.getAnimationState(i);
+        updateWalkingAnimation(figure, state, path, deltaTime);
+        crowd.setWalker(i, figure, state);
+    }
+}
+
+bool crowdWalkerMatches(
+    const CrowdState &crowd,
+    size_t i,
+    const ArticulatedFigure &figure,
+    const AnimationState &state)
+{
+    return sameBits(crowd.positionX[i], figure.position.x) &&
+           sameBits(crowd.positionY[i], figure.position.y) &&
+           sameBits(crowd.positionZ[i], figure.position.z) &&
+           sameBits(crowd.forwardX[i], figure.forward.x) &&
+           sameBits(crowd.forwardY[i], figure.forward.y) &&
+           sameBits(crowd.forwardZ[i], figure.forward.z) &&
+           sameBits(crowd.bodyTilt[i], figure.bodyTilt) &&
+           sameBits(crowd.leftHipAngle[i], figure.leftHipAngle) &&
+           sameBits(crowd.rightHipAngle[i], figure.rightHipAngle) &&
+           sameBits(crowd.leftKneeAngle[i], figure.leftKneeAngle) &&
+           sameBits(crowd.rightKneeAngle[i], figure.rightKneeAngle) &&
+           sameBits(crowd.t[i], state.t) &&
+           sameBits(crowd.dt[i], state.dt) &&
+           sameBits(crowd.walkCycle[i], state.walkCycle) &&
+           sameBits(crowd.walkSpeed[i], state.walkSpeed) &&
+           sameBits(crowd.animationSpeed[i], state.animationSpeed);
+}
+
+const char *crowdKernelName()
+{
+    return SIMD_LANES_NAME;
+}
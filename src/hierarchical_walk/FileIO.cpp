@@ -1,57 +1,390 @@
 #include "hierarchical_walk/FileIO.h"
 #include "hierarchical_walk/Constants.h"
-#include <fstream>
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
-#include <sstream>
+#include <type_traits>
 
-bool loadControlPoints(
-    const char *filename,
-    std::vector<Vec3> &controlPoints,
-    SplineType &splineType,
-    float &dt)
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Binary files store Vec3 exactly as it is laid out in memory
+static_assert(sizeof(Vec3) == 3 * sizeof(float), "Vec3 must be three packed floats");
+static_assert(std::is_trivially_copyable<Vec3>::value, "Vec3 must be trivially copyable");
+static_assert(sizeof(BinaryPathHeader) == 24, "BinaryPathHeader layout changed");
+
+// ============================================================================
+// MEMORY-MAPPED FILES
+// ============================================================================
+
+MappedFile::MappedFile()
+    : bytes(nullptr), length(0), opened(false)
+#ifdef _WIN32
+    , fileHandle(nullptr), mappingHandle(nullptr)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const char *filename)
 {
-    std::ifstream file(filename);
-    if (!file.is_open())
+    close();
+
+    HANDLE handle = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (handle == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(handle, &fileSize))
     {
-        std::cerr << "Error: Could not open " << filename << std::endl;
+        CloseHandle(handle);
         return false;
     }
 
+    // Empty files cannot be mapped but are still valid input
+    length = (size_t)fileSize.QuadPart;
+    if (length == 0)
+    {
+        CloseHandle(handle);
+        bytes = "";
+        opened = true;
+        return true;
+    }
+
+    HANDLE mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping)
+    {
+        CloseHandle(handle);
+        length = 0;
+        return false;
+    }
+
+    const void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view)
+    {
+        CloseHandle(mapping);
+        CloseHandle(handle);
+        length = 0;
+        return false;
+    }
+
+    fileHandle = handle;
+    mappingHandle = mapping;
+    bytes = (const char *)view;
+    opened = true;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (mappingHandle)
+    {
+        UnmapViewOfFile(bytes);
+        CloseHandle((HANDLE)mappingHandle);
+        CloseHandle((HANDLE)fileHandle);
+        mappingHandle = nullptr;
+        fileHandle = nullptr;
+    }
+    bytes = nullptr;
+    length = 0;
+    opened = false;
+}
+
+#else
+
+bool MappedFile::open(const char *filename)
+{
+    close();
+
+    int fd = ::open(filename, O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    // Empty files cannot be mapped but are still valid input
+    length = (size_t)info.st_size;
+    if (length == 0)
+    {
+        ::close(fd);
+        bytes = "";
+        opened = true;
+        return true;
+    }
+
+    void *view = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // The mapping keeps its own reference to the file
+    if (view == MAP_FAILED)
+    {
+        length = 0;
+        return false;
+    }
+    madvise(view, length, MADV_SEQUENTIAL);
+
+    bytes = (const char *)view;
+    opened = true;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (bytes && length > 0)
+        munmap((void *)bytes, length);
+    bytes = nullptr;
+    length = 0;
+    opened = false;
+}
+
+#endif
+
+// ============================================================================
+// TEXT FORMAT
+// ============================================================================
+
+static bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+}
+
+static const char *findLineEnd(const char *p, const char *end)
+{
+    const char *newline = (const char *)memchr(p, '\n', end - p);
+    return newline ? newline : end;
+}
+
+// Parse one float after optional whitespace; returns nullptr when there is none
+static const char *parseFloat(const char *p, const char *end, float &value)
+{
+    while (p < end && isSpace(*p))
+        p++;
+    if (p < end && *p == '+') // Accepted by operator>> but not by from_chars
+        p++;
+
+    std::from_chars_result result = std::from_chars(p, end, value);
+    return result.ec == std::errc() ? result.ptr : nullptr;
+}
+
+static void parseControlPoints(
+    const char *p,
+    const char *end,
+    std::vector<Vec3> &controlPoints,
+    SplineType &splineType,
+    float &dt,
+    bool quiet)
+{
     controlPoints.clear();
-    std::string line;
 
     // Read spline type
-    if (std::getline(file, line))
+    if (p < end)
     {
-        if (line.find("CATMULL") != std::string::npos)
-        {
-            splineType = CATMULL_ROM;
-            std::cout << "Using Catmull-Rom spline" << std::endl;
-        }
-        else if (line.find("BSPLINE") != std::string::npos)
-        {
-            splineType = BSPLINE;
-            std::cout << "Using B-Spline" << std::endl;
-        }
+        const char *lineEnd = findLineEnd(p, end);
+        if (parseSplineType(p, lineEnd, splineType))
+            std::cout << "Using " << splineTypeName(splineType) << '\n';
+        p = lineEnd < end ? lineEnd + 1 : end;
     }
 
     // Read dt value
-    if (std::getline(file, line))
+    if (p < end)
     {
-        std::istringstream iss(line);
-        iss >> dt;
-        std::cout << "Time step dt: " << dt << std::endl;
+        const char *lineEnd = findLineEnd(p, end);
+        parseFloat(p, lineEnd, dt);
+        std::cout << "Time step dt: " << dt << '\n';
+        p = lineEnd < end ? lineEnd + 1 : end;
     }
 
+    // One point per line is the common layout, so the line count bounds the size
+    controlPoints.reserve(std::count(p, end, '\n') + 1);
+
     // Read control points
     float x, y, z;
-    while (file >> x >> y >> z)
+    while ((p = parseFloat(p, end, x)) && (p = parseFloat(p, end, y)) && (p = parseFloat(p, end, z)))
     {
         controlPoints.push_back(Vec3(x, y, z));
-        std::cout << "Control point: (" << x << ", " << y << ", " << z << ")" << std::endl;
+        if (!quiet)
+            std::cout << "Control point: (" << x << ", " << y << ", " << z << ")\n";
     }
 
-    file.close();
     std::cout << "Loaded " << controlPoints.size() << " control points" << std::endl;
+}
+
+bool loadControlPoints(
+    const char *filename,
+    std::vector<Vec3> &controlPoints,
+    SplineType &splineType,
+    float &dt,
+    bool quiet)
+{
+    MappedFile file;
+    if (!file.open(filename))
+    {
+        std::cerr << "Error: Could not open " << filename << std::endl;
+        return false;
+    }
+
+    parseControlPoints(file.data(), file.data() + file.size(), controlPoints, splineType, dt, quiet);
     return controlPoints.size() >= 4;
-}
\ No newline at end of file
+}
+
+// ============================================================================
+// BINARY FORMAT
+// ============================================================================
+
+static bool hasBinaryMagic(const MappedFile &file)
+{
+    return file.size() >= sizeof(BINARY_PATH_MAGIC) &&
+           memcmp(file.data(), BINARY_PATH_MAGIC, sizeof(BINARY_PATH_MAGIC)) == 0;
+}
+
+// Validate the header of a mapped binary path file
+static const BinaryPathHeader *readBinaryHeader(const MappedFile &file, const char *filename)
+{
+    if (file.size() < sizeof(BinaryPathHeader) || !hasBinaryMagic(file))
+    {
+        std::cerr << "Error: " << filename << " is not a binary path file" << std::endl;
+        return nullptr;
+    }
+
+    const BinaryPathHeader *header = (const BinaryPathHeader *)file.data();
+    if (header->version != BINARY_PATH_VERSION)
+    {
+        std::cerr << "Error: " << filename << " has unsupported version " << header->version << std::endl;
+        return nullptr;
+    }
+    if (header->splineType >= SPLINE_TYPE_COUNT)
+    {
+        std::cerr << "Error: " << filename << " has unknown spline type " << header->splineType << std::endl;
+        return nullptr;
+    }
+
+    size_t available = (file.size() - sizeof(BinaryPathHeader)) / sizeof(Vec3);
+    if (header->pointCount > available)
+    {
+        std::cerr << "Error: " << filename << " is truncated" << std::endl;
+        return nullptr;
+    }
+    return header;
+}
+
+bool saveBinaryPath(
+    const char *filename,
+    const std::vector<Vec3> &controlPoints,
+    SplineType splineType,
+    float dt)
+{
+    FILE *file = fopen(filename, "wb");
+    if (!file)
+    {
+        std::cerr << "Error: Could not write " << filename << std::endl;
+        return false;
+    }
+
+    BinaryPathHeader header;
+    memcpy(header.magic, BINARY_PATH_MAGIC, sizeof(header.magic));
+    header.version = BINARY_PATH_VERSION;
+    header.splineType = (uint32_t)splineType;
+    header.dt = dt;
+    header.pointCount = controlPoints.size();
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(controlPoints.data(), sizeof(Vec3), controlPoints.size(), file) == controlPoints.size();
+    ok = fclose(file) == 0 && ok;
+    if (!ok)
+        std::cerr << "Error: Failed writing " << filename << std::endl;
+    return ok;
+}
+
+// ============================================================================
+// EITHER FORMAT
+// ============================================================================
+
+bool loadPath(const char *filename, CompiledSpline &path, float &dt, bool quiet)
+{
+    MappedFile file;
+    if (!file.open(filename))
+    {
+        std::cerr << "Error: Could not open " << filename << std::endl;
+        return false;
+    }
+
+    if (hasBinaryMagic(file))
+    {
+        const BinaryPathHeader *header = readBinaryHeader(file, filename);
+        if (!header || header->pointCount < 4)
+            return false;
+
+        // Compile straight from the mapping; no intermediate point array
+        const Vec3 *points = (const Vec3 *)(file.data() + sizeof(BinaryPathHeader));
+        path.setControlPoints(points, (size_t)header->pointCount, (SplineType)header->splineType);
+        dt = header->dt;
+        std::cout << "Loaded " << header->pointCount << " control points from binary path" << std::endl;
+        return true;
+    }
+
+    std::vector<Vec3> points;
+    SplineType splineType = CATMULL_ROM;
+    parseControlPoints(file.data(), file.data() + file.size(), points, splineType, dt, quiet);
+    if (points.size() < 4)
+        return false;
+
+    path.setControlPoints(points, splineType);
+    return true;
+}
+
+bool reloadPath(const char *filename, CompiledSpline &path, float &dt, SplineEdit &edit, bool quiet)
+{
+    MappedFile file;
+    if (!file.open(filename))
+    {
+        std::cerr << "Error: Could not open " << filename << std::endl;
+        return false;
+    }
+
+    if (hasBinaryMagic(file))
+    {
+        const BinaryPathHeader *header = readBinaryHeader(file, filename);
+        if (!header || header->pointCount < 4)
+            return false;
+
+        const Vec3 *points = (const Vec3 *)(file.data() + sizeof(BinaryPathHeader));
+        edit = path.updateControlPoints(points, (size_t)header->pointCount, (SplineType)header->splineType);
+        dt = header->dt;
+        return true;
+    }
+
+    std::vector<Vec3> points;
+    SplineType splineType = CATMULL_ROM;
+    float newDt = dt;
+    parseControlPoints(file.data(), file.data() + file.size(), points, splineType, newDt, quiet);
+    if (points.size() < 4)
+        return false;
+
+    edit = path.updateControlPoints(points.data(), points.size(), splineType);
+    dt = newDt;
+    return true;
+}
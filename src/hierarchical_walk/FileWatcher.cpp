@@ -0,0 +1,162 @@
+#include "hierarchical_walk/FileWatcher.h"
+#include <iostream>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#else
+#include <chrono>
+#include <sys/stat.h>
+#include <thread>
+#endif
+
+static std::string nameOf(const std::string &filename)
+{
+    size_t slash = filename.find_last_of("/\\");
+    return slash == std::string::npos ? filename : filename.substr(slash + 1);
+}
+
+#ifdef __linux__
+
+// Directory part of a path, "." for a bare file name
+static std::string directoryOf(const std::string &filename)
+{
+    size_t slash = filename.find_last_of("/\\");
+    if (slash == std::string::npos)
+        return ".";
+    return slash == 0 ? "/" : filename.substr(0, slash);
+}
+
+FileWatcher::FileWatcher()
+    : watching(false),
+      notifyFd(-1)
+{
+}
+
+FileWatcher::~FileWatcher()
+{
+    close();
+}
+
+bool FileWatcher::watch(const std::string &filename)
+{
+    close();
+    path = filename;
+    name = nameOf(filename);
+
+    notifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (notifyFd < 0)
+    {
+        std::cerr << "Error: Could not create a file watch for " << filename << std::endl;
+        return false;
+    }
+
+    // Written and closed, or renamed into place; not created, which is
+    // reported before the new contents are written
+    std::string directory = directoryOf(filename);
+    if (inotify_add_watch(notifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+    {
+        std::cerr << "Error: Could not watch " << directory << std::endl;
+        close();
+        return false;
+    }
+    watching = true;
+    return true;
+}
+
+void FileWatcher::close()
+{
+    if (notifyFd >= 0)
+        ::close(notifyFd);
+    notifyFd = -1;
+    watching = false;
+}
+
+bool FileWatcher::wait(int timeoutMs)
+{
+    if (!watching)
+        return false;
+
+    pollfd request = {notifyFd, POLLIN, 0};
+    if (poll(&request, 1, timeoutMs) <= 0)
+        return false;
+
+    // Drain every queued event; any one naming the file counts
+    bool changed = false;
+    alignas(inotify_event) char buffer[4096];
+    ssize_t bytes;
+    while ((bytes = read(notifyFd, buffer, sizeof(buffer))) > 0)
+    {
+        for (char *p = buffer; p < buffer + bytes;)
+        {
+            const inotify_event *event = (const inotify_event *)p;
+            if (event->len > 0 && name == event->name)
+                changed = true;
+            p += sizeof(inotify_event) + event->len;
+        }
+    }
+    return changed;
+}
+
+#else
+
+// Modification time and size of a file, both -1 if it is missing
+static void fileStamp(const std::string &filename, int64_t &modified, int64_t &size)
+{
+    struct stat info;
+    if (stat(filename.c_str(), &info) != 0)
+    {
+        modified = -1;
+        size = -1;
+        return;
+    }
+    modified = (int64_t)info.st_mtime;
+    size = (int64_t)info.st_size;
+}
+
+FileWatcher::FileWatcher()
+    : watching(false),
+      modified(-1),
+      size(-1)
+{
+}
+
+FileWatcher::~FileWatcher()
+{
+    close();
+}
+
+bool FileWatcher::watch(const std::string &filename)
+{
+    close();
+    path = filename;
+    name = nameOf(filename);
+    fileStamp(path, modified, size);
+    watching = true;
+    return true;
+}
+
+void FileWatcher::close()
+{
+    watching = false;
+}
+
+bool FileWatcher::wait(int timeoutMs)
+{
+    if (!watching)
+        return false;
+
+    // Modification times have a resolution of a second on some file
+    // systems, so the size is compared as well
+    std::this_thread::sleep_for(std::chrono::milliseconds(timeoutMs));
+    int64_t newModified, newSize;
+    fileStamp(path, newModified, newSize);
+    if (newModified == modified && newSize == size)
+        return false;
+    modified = newModified;
+    size = newSize;
+    return newModified >= 0;
+}
+
+#endif
@@ -0,0 +1,30 @@
+#include "hierarchical_walk/FixedTimestep.h"
+#include <cmath>
+
+FixedTimestep::FixedTimestep(double stepSeconds, int maxSubsteps)
+    : step(stepSeconds),
+      maxSubsteps(maxSubsteps),
+      accumulator(0.0),
+      dropped(0)
+{
+}
+
+int FixedTimestep::advance(double elapsedSeconds)
+{
+    if (elapsedSeconds > 0.0)
+        accumulator += elapsedSeconds;
+
+    double steps = std::floor(accumulator / step);
+    if (steps > maxSubsteps)
+    {
+        // Keep the fraction of a step so interpolation stays continuous
+        dropped += (long long)(steps - maxSubsteps);
+        accumulator -= (steps - maxSubsteps) * step;
+        steps = maxSubsteps;
+    }
+
+    accumulator -= steps * step;
+    if (accumulator < 0.0) // Rounding in the division above
+        accumulator = 0.0;
+    return (int)steps;
+}
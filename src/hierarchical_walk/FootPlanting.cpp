@@ -0,0 +1,139 @@
+#include "hierarchical_walk/FootPlanting.h"
+#include "hierarchical_walk/Constants.h"
+#include "hierarchical_walk/Mat4.h"
+#include <algorithm>
+#include <cmath>
+
+FootContact::FootContact()
+    : point(0, 0, 0),
+      hipAngle(0),
+      kneeAngle(0),
+      phase(FOOT_SWING)
+{
+}
+
+FootPlanting::FootPlanting()
+    : slip(0.0f)
+{
+}
+
+static float clampUnit(float value)
+{
+    return std::min(1.0f, std::max(-1.0f, value));
+}
+
+bool solveTwoBoneLeg(float forward, float down, float thigh, float shin, float &hipAngle, float &kneeAngle)
+{
+    // A leg at angle a hangs along (0, -cos a, -sin a), so the hip-to-ankle
+    // line sits at atan2(-forward, down)
+    float line = atan2(-forward, down);
+
+    float reach = thigh + shin;
+    float distance = sqrt(forward * forward + down * down);
+    bool reached = distance <= reach;
+    distance = std::min(reach, std::max(distance, std::max(std::fabs(thigh - shin), 1e-4f)));
+
+    // Law of cosines: the thigh leans forward of the line by the angle at the
+    // hip, and the knee bends by the supplement of the angle at the knee
+    float hipOffset = acos(clampUnit((thigh * thigh + distance * distance - shin * shin) / (2.0f * thigh * distance)));
+    float kneeInterior = acos(clampUnit((thigh * thigh + shin * shin - distance * distance) / (2.0f * thigh * shin)));
+
+    hipAngle = (line - hipOffset) * 180.0f / PI;
+    kneeAngle = (PI - kneeInterior) * 180.0f / PI;
+    return reached;
+}
+
+// Ankle position in the pelvis frame for a hip at hipOffset
+static Vec3 legAnkle(const Vec3 &hipOffset, float thigh, float shin, float hipAngle, float kneeAngle)
+{
+    float hip = hipAngle * PI / 180.0f;
+    float shinAngle = (hipAngle + kneeAngle) * PI / 180.0f;
+    return hipOffset + Vec3(0, -thigh * cos(hip) - shin * cos(shinAngle), -thigh * sin(hip) - shin * sin(shinAngle));
+}
+
+void applyFootPlanting(ArticulatedFigure &figure, const AnimationState &state, FootPlanting &planting)
+{
+    // Hips and knees bend about the pelvis x axis, so each leg is solved in
+    // the pelvis y-z plane. The frame is figureRootTransform followed by the
+    // tilt, built from the heading vector rather than its angle.
+    const Skeleton &skeleton = figureSkeleton();
+    Vec3 heading = Vec3(figure.forward.x, 0, figure.forward.z).normalize();
+    if (heading.length() == 0.0f)
+        heading = Vec3(0, 0, 1);
+    Vec3 right(heading.z, 0, -heading.x);
+    const Vec3 &offset = skeleton.offset(JOINT_PELVIS);
+    Vec3 origin = figure.position + right * offset.x + Vec3(0, offset.y, 0) + heading * offset.z;
+    float tilt = figure.bodyTilt * PI / 180.0f;
+    Vec3 up = Vec3(0, 1, 0) * cos(tilt) + heading * sin(tilt);
+    Vec3 front = heading * cos(tilt) - Vec3(0, 1, 0) * sin(tilt);
+    Mat4 pelvis = {{right.x, right.y, right.z, 0,
+                    up.x, up.y, up.z, 0,
+                    front.x, front.y, front.z, 0,
+                    origin.x, origin.y, origin.z, 1}};
+    Mat4 toPelvis = inverseRigid(pelvis);
+
+    const int hips[FOOT_COUNT] = {JOINT_LEFT_HIP, JOINT_RIGHT_HIP};
+    const int knees[FOOT_COUNT] = {JOINT_LEFT_KNEE, JOINT_RIGHT_KNEE};
+    const int ankles[FOOT_COUNT] = {JOINT_LEFT_ANKLE, JOINT_RIGHT_ANKLE};
+    float *hipAngles[FOOT_COUNT] = {&figure.leftHipAngle, &figure.rightHipAngle};
+    float *kneeAngles[FOOT_COUNT] = {&figure.leftKneeAngle, &figure.rightKneeAngle};
+
+    // The gait swings the left foot back while cos(walkCycle) > 0 and the
+    // right one half a cycle later; each lifts off as its swing turns forward
+    float swing = cos(state.walkCycle);
+    for (int side = 0; side < FOOT_COUNT; side++)
+    {
+        FootContact &foot = planting.feet[side];
+        float &hipAngle = *hipAngles[side];
+        float &kneeAngle = *kneeAngles[side];
+        bool stance = side == FOOT_LEFT ? swing > 0.0f : swing < 0.0f;
+
+        if (!stance)
+        {
+            if (foot.phase == FOOT_PLANTED)
+                foot.phase = FOOT_RELEASING;
+            if (foot.phase == FOOT_RELEASING)
+            {
+                float liftOff = side == FOOT_LEFT ? 0.5f * PI : 1.5f * PI;
+                float sinceLiftOff = fmod(state.walkCycle - liftOff + 4.0f * PI, 2.0f * PI);
+                if (sinceLiftOff < FOOT_RELEASE_PHASE)
+                {
+                    float weight = sinceLiftOff / FOOT_RELEASE_PHASE;
+                    hipAngle = foot.hipAngle + (hipAngle - foot.hipAngle) * weight;
+                    kneeAngle = foot.kneeAngle + (kneeAngle - foot.kneeAngle) * weight;
+                }
+                else
+                    foot.phase = FOOT_SWING;
+            }
+            continue;
+        }
+
+        const Vec3 &hipOffset = skeleton.offset(hips[side]);
+        float thigh = skeleton.offset(knees[side]).length();
+        float shin = skeleton.offset(ankles[side]).length();
+
+        // Touch down wherever the gait put the ankle, so the pose does not jump
+        if (foot.phase != FOOT_PLANTED)
+        {
+            foot.point = transformPoint(pelvis, legAnkle(hipOffset, thigh, shin, hipAngle, kneeAngle));
+            foot.phase = FOOT_PLANTED;
+        }
+
+        Vec3 target = transformPoint(toPelvis, foot.point) - hipOffset;
+        if (!solveTwoBoneLeg(target.z, -target.y, thigh, shin, hipAngle, kneeAngle))
+        {
+            // The stride outran the leg: slide the contact along the ground
+            // to the edge of reach, at its height and back under the hip
+            float reach = thigh + shin;
+            float along = sqrt(std::max(reach * reach - target.y * target.y, 0.0f));
+            Vec3 slid(0, target.y, target.z < 0.0f ? -along : along);
+            solveTwoBoneLeg(slid.z, -slid.y, thigh, shin, hipAngle, kneeAngle);
+            Vec3 reached = transformPoint(pelvis, hipOffset + slid);
+            planting.slip += (reached - foot.point).length();
+            foot.point = reached;
+        }
+
+        foot.hipAngle = hipAngle;
+        foot.kneeAngle = kneeAngle;
+    }
+}
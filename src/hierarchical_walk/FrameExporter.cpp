@@ -0,0 +1,377 @@
+#include "hierarchical_walk/FrameExporter.h"
+#include "hierarchical_walk/Profiler.h"
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#define popen _popen
+#define pclose _pclose
+#endif
+
+bool parseFrameFormat(const char *name, FrameFormat &format)
+{
+    if (strcmp(name, "raw") == 0)
+        format = FRAME_RAW;
+    else if (strcmp(name, "ppm") == 0)
+        format = FRAME_PPM;
+    else if (strcmp(name, "y4m") == 0)
+        format = FRAME_Y4M;
+    else
+        return false;
+    return true;
+}
+
+FrameExporter::FrameExporter()
+    : width(0),
+      height(0),
+      fps(0),
+      format(FRAME_PPM),
+      frameCount(0),
+      usePixelBuffers(false),
+      framebuffer(0),
+      colorBuffer(0),
+      depthBuffer(0),
+      stream(nullptr),
+      streamIsPipe(false),
+      streamIsStdout(false),
+      headerWritten(false),
+      writerStopping(false),
+      writeFailed(false)
+{
+    for (int i = 0; i < FRAME_READBACK_BUFFERS; i++)
+        pixelBuffers[i] = 0;
+}
+
+FrameExporter::~FrameExporter()
+{
+    close();
+}
+
+bool FrameExporter::open(const char *output, FrameFormat frameFormat, int frameWidth, int frameHeight, int frameRate)
+{
+    close();
+
+    if (!GLEW_VERSION_3_0 && !GLEW_ARB_framebuffer_object)
+    {
+        std::cerr << "Error: Offscreen rendering needs framebuffer objects" << std::endl;
+        return false;
+    }
+
+    width = frameWidth;
+    height = frameHeight;
+    fps = frameRate;
+    format = frameFormat;
+    frameCount = 0;
+    headerWritten = false;
+    writeFailed = false;
+
+    // Open the output; patterns open one file per frame on the writer thread
+    if (strcmp(output, "-") == 0)
+    {
+#ifdef _WIN32
+        _setmode(_fileno(stdout), _O_BINARY);
+#endif
+        stream = stdout;
+        streamIsStdout = true;
+    }
+    else if (output[0] == '|')
+    {
+        stream = popen(output + 1, "w");
+        streamIsPipe = true;
+    }
+    else if (strchr(output, '%'))
+    {
+        outputPattern = output;
+    }
+    else
+    {
+        stream = fopen(output, "wb");
+    }
+
+    if (outputPattern.empty() && !stream)
+    {
+        std::cerr << "Error: Could not open " << output << " for writing" << std::endl;
+        return false;
+    }
+
+    // Offscreen color and depth targets at the export resolution
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glGenRenderbuffers(1, &colorBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+    glGenRenderbuffers(1, &depthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cerr << "Error: Offscreen framebuffer is incomplete (0x" << std::hex << status << std::dec << ")" << std::endl;
+        close();
+        return false;
+    }
+
+    // Ring of pixel buffers for asynchronous readback; without them each
+    // frame is read straight into client memory
+    size_t frameBytes = (size_t)width * height * 4;
+    usePixelBuffers = GLEW_VERSION_2_1 || GLEW_ARB_pixel_buffer_object;
+    if (usePixelBuffers)
+    {
+        glGenBuffers(FRAME_READBACK_BUFFERS, pixelBuffers);
+        for (int i = 0; i < FRAME_READBACK_BUFFERS; i++)
+        {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, pixelBuffers[i]);
+            glBufferData(GL_PIXEL_PACK_BUFFER, frameBytes, nullptr, GL_STREAM_READ);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+
+    // Client-side frames cycle between this thread and the writer
+    bufferStorage.assign(FRAME_WRITE_QUEUE, std::vector<uint8_t>(frameBytes));
+    freeBuffers.clear();
+    for (std::vector<uint8_t> &buffer : bufferStorage)
+        freeBuffers.push_back(&buffer);
+
+    writerStopping = false;
+    writer = std::thread(&FrameExporter::writerLoop, this);
+    return true;
+}
+
+void FrameExporter::beginFrame()
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glViewport(0, 0, width, height);
+}
+
+void FrameExporter::endFrame()
+{
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+
+    if (!usePixelBuffers)
+    {
+        std::vector<uint8_t> *buffer = acquireBuffer();
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, buffer->data());
+        std::lock_guard<std::mutex> lock(queueMutex);
+        writeQueue.push_back(std::make_pair(buffer, frameCount++));
+        queueCondition.notify_all();
+        return;
+    }
+
+    int slot = frameCount % FRAME_READBACK_BUFFERS;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pixelBuffers[slot]);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    inFlight.push_back(slot);
+    frameCount++;
+
+    // Once the ring is full, hand the oldest frame to the writer. Its copy has
+    // had the following frames' drawing to finish in, so mapping rarely waits,
+    // and its slot is the one the next frame reads into.
+    if ((int)inFlight.size() == FRAME_READBACK_BUFFERS)
+    {
+        collectFrame(inFlight.front());
+        inFlight.pop_front();
+    }
+}
+
+// Copy a finished readback out of its pixel buffer and queue it for writing
+void FrameExporter::collectFrame(int slot)
+{
+    std::vector<uint8_t> *buffer = acquireBuffer();
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pixelBuffers[slot]);
+    const void *pixels = glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+    if (pixels)
+    {
+        memcpy(buffer->data(), pixels, buffer->size());
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    else
+    {
+        memset(buffer->data(), 0, buffer->size());
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    // Frames leave the ring in the order they were drawn
+    int index = frameCount - (int)inFlight.size();
+    std::lock_guard<std::mutex> lock(queueMutex);
+    if (!pixels)
+        writeFailed = true;
+    writeQueue.push_back(std::make_pair(buffer, index));
+    queueCondition.notify_all();
+}
+
+// Free client buffer; waits while the writer is behind
+std::vector<uint8_t> *FrameExporter::acquireBuffer()
+{
+    std::unique_lock<std::mutex> lock(queueMutex);
+    queueCondition.wait(lock, [&] { return !freeBuffers.empty(); });
+    std::vector<uint8_t> *buffer = freeBuffers.back();
+    freeBuffers.pop_back();
+    return buffer;
+}
+
+bool FrameExporter::close()
+{
+    if (writer.joinable())
+    {
+        // Drain the readback ring, then let the writer finish the queue
+        while (!inFlight.empty())
+        {
+            collectFrame(inFlight.front());
+            inFlight.pop_front();
+        }
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            writerStopping = true;
+        }
+        queueCondition.notify_all();
+        writer.join();
+    }
+
+    if (pixelBuffers[0])
+        glDeleteBuffers(FRAME_READBACK_BUFFERS, pixelBuffers);
+    for (int i = 0; i < FRAME_READBACK_BUFFERS; i++)
+        pixelBuffers[i] = 0;
+    if (framebuffer)
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glDeleteFramebuffers(1, &framebuffer);
+        glDeleteRenderbuffers(1, &colorBuffer);
+        glDeleteRenderbuffers(1, &depthBuffer);
+    }
+    framebuffer = colorBuffer = depthBuffer = 0;
+    inFlight.clear();
+
+    if (stream)
+    {
+        bool ok;
+        if (streamIsPipe)
+            ok = pclose(stream) == 0;
+        else if (streamIsStdout)
+            ok = fflush(stream) == 0;
+        else
+            ok = fclose(stream) == 0;
+        if (!ok)
+            writeFailed = true;
+    }
+    stream = nullptr;
+    streamIsPipe = false;
+    streamIsStdout = false;
+    outputPattern.clear();
+    bufferStorage.clear();
+    freeBuffers.clear();
+    writeQueue.clear();
+
+    bool ok = !writeFailed;
+    writeFailed = false;
+    return ok;
+}
+
+// ============================================================================
+// WRITER THREAD
+// ============================================================================
+
+void FrameExporter::writerLoop()
+{
+    PROFILE_THREAD_NAME("frame writer");
+    for (;;)
+    {
+        std::pair<std::vector<uint8_t> *, int> job;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueCondition.wait(lock, [&] { return writerStopping || !writeQueue.empty(); });
+            if (writeQueue.empty())
+                return;
+            job = writeQueue.front();
+            writeQueue.pop_front();
+        }
+
+        bool ok;
+        {
+            PROFILE_SCOPE("write frame");
+            ok = writeFrame(*job.first, job.second);
+        }
+
+        std::lock_guard<std::mutex> lock(queueMutex);
+        if (!ok)
+            writeFailed = true;
+        freeBuffers.push_back(job.first);
+        queueCondition.notify_all();
+    }
+}
+
+bool FrameExporter::writeFrame(const std::vector<uint8_t> &rgba, int index)
+{
+    if (outputPattern.empty())
+        return writeToStream(stream, rgba);
+
+    // One file per frame; each gets its own header
+    char name[1024];
+    snprintf(name, sizeof(name), outputPattern.c_str(), index);
+    FILE *file = fopen(name, "wb");
+    if (!file)
+        return false;
+    headerWritten = false;
+    bool ok = writeToStream(file, rgba);
+    return fclose(file) == 0 && ok;
+}
+
+// Convert one bottom-up RGBA frame to the output layout and write it
+bool FrameExporter::writeToStream(FILE *out, const std::vector<uint8_t> &rgba)
+{
+    size_t pixelCount = (size_t)width * height;
+    converted.resize(pixelCount * 3);
+    uint8_t *dst = converted.data();
+
+    if (format == FRAME_Y4M)
+    {
+        if (!headerWritten)
+            fprintf(out, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444\n", width, height, fps);
+        fputs("FRAME\n", out);
+
+        // Separate Y, Cb and Cr planes, BT.601 studio range
+        uint8_t *planeY = dst;
+        uint8_t *planeU = dst + pixelCount;
+        uint8_t *planeV = dst + pixelCount * 2;
+        for (int y = 0; y < height; y++)
+        {
+            const uint8_t *src = &rgba[(size_t)(height - 1 - y) * width * 4];
+            size_t row = (size_t)y * width;
+            for (int x = 0; x < width; x++, src += 4)
+            {
+                int r = src[0], g = src[1], b = src[2];
+                planeY[row + x] = (uint8_t)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+                planeU[row + x] = (uint8_t)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+                planeV[row + x] = (uint8_t)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+            }
+        }
+    }
+    else
+    {
+        if (format == FRAME_PPM)
+            fprintf(out, "P6\n%d %d\n255\n", width, height);
+
+        // GL rows start at the bottom; images start at the top
+        for (int y = 0; y < height; y++)
+        {
+            const uint8_t *src = &rgba[(size_t)(height - 1 - y) * width * 4];
+            for (int x = 0; x < width; x++, src += 4, dst += 3)
+            {
+                dst[0] = src[0];
+                dst[1] = src[1];
+                dst[2] = src[2];
+            }
+        }
+    }
+    headerWritten = true;
+
+    return fwrite(converted.data(), 1, converted.size(), out) == converted.size();
+}
@@ -0,0 +1,97 @@
+#include "hierarchical_walk/GpuTimer.h"
+
+GpuTimer::GpuTimer()
+    : frame(0),
+      active(false),
+      available(false)
+{
+    for (int f = 0; f < GPU_TIMER_FRAMES; f++)
+    {
+        used[f] = 0;
+        for (int s = 0; s < GPU_TIMER_SCOPES; s++)
+        {
+            queries[f][s] = 0;
+            names[f][s] = nullptr;
+            cpuStart[f][s] = 0;
+        }
+    }
+}
+
+GpuTimer::~GpuTimer()
+{
+    release();
+}
+
+bool GpuTimer::init()
+{
+    release();
+    if (!GLEW_VERSION_3_3 && !GLEW_ARB_timer_query)
+        return false;
+
+    glGenQueries(GPU_TIMER_FRAMES * GPU_TIMER_SCOPES, &queries[0][0]);
+    for (int f = 0; f < GPU_TIMER_FRAMES; f++)
+        used[f] = 0;
+    frame = 0;
+    available = true;
+    return true;
+}
+
+void GpuTimer::release()
+{
+    if (!available)
+        return;
+    if (active)
+        end();
+    glDeleteQueries(GPU_TIMER_FRAMES * GPU_TIMER_SCOPES, &queries[0][0]);
+    available = false;
+}
+
+void GpuTimer::beginFrame()
+{
+    if (!available)
+        return;
+    if (active)
+        end();
+
+    // The slot about to be reused holds the oldest frame's queries
+    frame = (frame + 1) % GPU_TIMER_FRAMES;
+    int count = used[frame];
+    used[frame] = 0;
+    if (count == 0)
+        return;
+
+    // Queries finish in order, so the last one being ready means all are.
+    // If the GPU is that far behind, the frame's results are dropped.
+    GLint ready = 0;
+    glGetQueryObjectiv(queries[frame][count - 1], GL_QUERY_RESULT_AVAILABLE, &ready);
+    if (!ready)
+        return;
+
+    for (int s = 0; s < count; s++)
+    {
+        GLuint64 nanoseconds = 0;
+        glGetQueryObjectui64v(queries[frame][s], GL_QUERY_RESULT, &nanoseconds);
+        profiler().recordGpu(names[frame][s], cpuStart[frame][s], nanoseconds);
+    }
+}
+
+bool GpuTimer::begin(const char *name)
+{
+    if (!available || active || used[frame] == GPU_TIMER_SCOPES)
+        return false;
+
+    int slot = used[frame]++;
+    names[frame][slot] = name;
+    cpuStart[frame][slot] = profiler().now();
+    glBeginQuery(GL_TIME_ELAPSED, queries[frame][slot]);
+    active = true;
+    return true;
+}
+
+void GpuTimer::end()
+{
+    if (!active)
+        return;
+    glEndQuery(GL_TIME_ELAPSED);
+    active = false;
+}
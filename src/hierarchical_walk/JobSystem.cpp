@@ -0,0 +1,181 @@
+#include "hierarchical_walk/JobSystem.h"
+#include "hierarchical_walk/Profiler.h"
+
+static uint64_t packRange(uint32_t begin, uint32_t end)
+{
+    return ((uint64_t)end << 32) | begin;
+}
+
+static uint32_t rangeBegin(uint64_t range) { return (uint32_t)range; }
+static uint32_t rangeEnd(uint64_t range) { return (uint32_t)(range >> 32); }
+
+size_t cacheAlignedChunkSize(size_t chunkSize, size_t elementSize)
+{
+    // Smallest element count whose size is a multiple of the cache line
+    size_t step = 1;
+    while ((step * elementSize) % CACHE_LINE_SIZE != 0 && step < CACHE_LINE_SIZE)
+        step++;
+
+    if (chunkSize < step)
+        return step;
+    return (chunkSize + step - 1) / step * step;
+}
+
+JobSystem::JobSystem(int threadCount)
+    : queues(threadCount > 0 ? threadCount : (std::thread::hardware_concurrency() > 0 ? std::thread::hardware_concurrency() : 1)),
+      jobBody(nullptr),
+      jobCount(0),
+      jobChunkSize(1),
+      pendingChunks(0),
+      busyWorkers(0),
+      generation(0),
+      stopping(false)
+{
+    for (ChunkQueue &queue : queues)
+        queue.range.store(0, std::memory_order_relaxed);
+
+    for (int i = 1; i < (int)queues.size(); i++)
+        workers.emplace_back(&JobSystem::workerLoop, this, i);
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        stopping = true;
+    }
+    wakeCondition.notify_all();
+    for (std::thread &worker : workers)
+        worker.join();
+}
+
+void JobSystem::parallelFor(size_t count, size_t chunkSize, const std::function<void(size_t, size_t)> &body)
+{
+    if (count == 0)
+        return;
+    if (chunkSize == 0)
+        chunkSize = 1;
+
+    size_t chunkCount = (count + chunkSize - 1) / chunkSize;
+    if (queues.size() == 1 || chunkCount == 1)
+    {
+        for (size_t begin = 0; begin < count; begin += chunkSize)
+            body(begin, begin + chunkSize < count ? begin + chunkSize : count);
+        return;
+    }
+
+    jobBody = &body;
+    jobCount = count;
+    jobChunkSize = chunkSize;
+    pendingChunks.store(chunkCount, std::memory_order_relaxed);
+    busyWorkers.store((int)workers.size(), std::memory_order_relaxed);
+
+    // Contiguous runs keep neighbouring chunks on one thread until stolen
+    size_t threads = queues.size();
+    for (size_t i = 0; i < threads; i++)
+    {
+        uint32_t begin = (uint32_t)(chunkCount * i / threads);
+        uint32_t end = (uint32_t)(chunkCount * (i + 1) / threads);
+        queues[i].range.store(packRange(begin, end), std::memory_order_release);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        generation++;
+    }
+    wakeCondition.notify_all();
+
+    runChunks(0);
+
+    // Barrier: chunks held by other threads may still be running, and a
+    // worker that found nothing may still be touching the queues
+    while (pendingChunks.load(std::memory_order_acquire) != 0 ||
+           busyWorkers.load(std::memory_order_acquire) != 0)
+        std::this_thread::yield();
+    jobBody = nullptr;
+}
+
+void JobSystem::workerLoop(int index)
+{
+    PROFILE_THREAD_NAME("job worker");
+    uint64_t seen = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            wakeCondition.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping)
+                return;
+            seen = generation;
+        }
+        runChunks(index);
+        busyWorkers.fetch_sub(1, std::memory_order_acq_rel);
+    }
+}
+
+void JobSystem::runChunks(int index)
+{
+    uint32_t chunk;
+    for (;;)
+    {
+        if (popChunk(index, chunk) || stealChunks(index, chunk))
+            runChunk(chunk);
+        else
+            return;
+    }
+}
+
+// Take the first chunk of our own queue
+bool JobSystem::popChunk(int index, uint32_t &chunk)
+{
+    std::atomic<uint64_t> &range = queues[index].range;
+    uint64_t current = range.load(std::memory_order_acquire);
+    for (;;)
+    {
+        uint32_t begin = rangeBegin(current);
+        uint32_t end = rangeEnd(current);
+        if (begin >= end)
+            return false;
+        if (range.compare_exchange_weak(current, packRange(begin + 1, end), std::memory_order_acq_rel))
+        {
+            chunk = begin;
+            return true;
+        }
+    }
+}
+
+// Move the back half of another queue into ours and take its first chunk
+bool JobSystem::stealChunks(int thief, uint32_t &chunk)
+{
+    int threads = (int)queues.size();
+    for (int offset = 1; offset < threads; offset++)
+    {
+        std::atomic<uint64_t> &victim = queues[(thief + offset) % threads].range;
+        uint64_t current = victim.load(std::memory_order_acquire);
+        for (;;)
+        {
+            uint32_t begin = rangeBegin(current);
+            uint32_t end = rangeEnd(current);
+            if (begin >= end)
+                break;
+
+            uint32_t stolen = (end - begin + 1) / 2;
+            if (victim.compare_exchange_weak(current, packRange(begin, end - stolen), std::memory_order_acq_rel))
+            {
+                // Our queue is empty, so nobody else can be claiming from it
+                chunk = end - stolen;
+                queues[thief].range.store(packRange(chunk + 1, end), std::memory_order_release);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void JobSystem::runChunk(uint32_t chunk)
+{
+    size_t begin = chunk * jobChunkSize;
+    size_t end = begin + jobChunkSize < jobCount ? begin + jobChunkSize : jobCount;
+    (*jobBody)(begin, end);
+    pendingChunks.fetch_sub(1, std::memory_order_acq_rel);
+}
@@ -0,0 +1,269 @@
+#include "hierarchical_walk/Mesh.h"
+#include "hierarchical_walk/Constants.h"
+#include <GL/glew.h>
+#include <cmath>
+#include <cstddef>
+
+MeshData::MeshData()
+    : primitive(MESH_TRIANGLES)
+{
+}
+
+Mesh::Mesh()
+    : vertexArray(0),
+      vertexBuffer(0),
+      indexBuffer(0),
+      primitive(MESH_TRIANGLES),
+      indexCount(0)
+{
+}
+
+// ============================================================================
+// GEOMETRY GENERATORS
+// ============================================================================
+
+static void addVertex(MeshData &mesh, float px, float py, float pz, float nx, float ny, float nz)
+{
+    MeshVertex v = {px, py, pz, nx, ny, nz};
+    mesh.vertices.push_back(v);
+}
+
+// Append a quad (four vertices in order) as two triangles
+static void addQuad(MeshData &mesh, const float corners[4][3], float nx, float ny, float nz)
+{
+    unsigned int base = (unsigned int)mesh.vertices.size();
+    for (int i = 0; i < 4; i++)
+        addVertex(mesh, corners[i][0], corners[i][1], corners[i][2], nx, ny, nz);
+
+    unsigned int quad[6] = {base, base + 1, base + 2, base, base + 2, base + 3};
+    mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+}
+
+MeshData buildBoxMesh(float width, float height, float depth)
+{
+    MeshData mesh;
+    float x = width / 2;
+    float z = depth / 2;
+
+    const float front[4][3] = {{-x, 0, z}, {x, 0, z}, {x, height, z}, {-x, height, z}};
+    const float back[4][3] = {{-x, 0, -z}, {-x, height, -z}, {x, height, -z}, {x, 0, -z}};
+    const float top[4][3] = {{-x, height, -z}, {-x, height, z}, {x, height, z}, {x, height, -z}};
+    const float bottom[4][3] = {{-x, 0, -z}, {x, 0, -z}, {x, 0, z}, {-x, 0, z}};
+    const float right[4][3] = {{x, 0, -z}, {x, height, -z}, {x, height, z}, {x, 0, z}};
+    const float left[4][3] = {{-x, 0, -z}, {-x, 0, z}, {-x, height, z}, {-x, height, -z}};
+
+    addQuad(mesh, front, 0, 0, 1);
+    addQuad(mesh, back, 0, 0, -1);
+    addQuad(mesh, top, 0, 1, 0);
+    addQuad(mesh, bottom, 0, -1, 0);
+    addQuad(mesh, right, 1, 0, 0);
+    addQuad(mesh, left, -1, 0, 0);
+    return mesh;
+}
+
+MeshData buildCylinderMesh(float radius, float height, int slices)
+{
+    MeshData mesh;
+
+    // Open tube, one ring of vertices at each end
+    for (int i = 0; i <= slices; i++)
+    {
+        float angle = 2 * PI * i / slices;
+        float nx = sin(angle);
+        float ny = cos(angle);
+        addVertex(mesh, radius * nx, radius * ny, 0, nx, ny, 0);
+        addVertex(mesh, radius * nx, radius * ny, height, nx, ny, 0);
+    }
+
+    for (int i = 0; i < slices; i++)
+    {
+        unsigned int a = 2 * i;
+        unsigned int quad[6] = {a, a + 2, a + 3, a, a + 3, a + 1};
+        mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+    }
+    return mesh;
+}
+
+MeshData buildSphereMesh(float radius, int slices, int stacks)
+{
+    MeshData mesh;
+
+    for (int j = 0; j <= stacks; j++)
+    {
+        float polar = PI * j / stacks;
+        float ring = sin(polar);
+        float nz = cos(polar);
+        for (int i = 0; i <= slices; i++)
+        {
+            float angle = 2 * PI * i / slices;
+            float nx = ring * cos(angle);
+            float ny = ring * sin(angle);
+            addVertex(mesh, radius * nx, radius * ny, radius * nz, nx, ny, nz);
+        }
+    }
+
+    unsigned int rowLength = slices + 1;
+    for (int j = 0; j < stacks; j++)
+    {
+        for (int i = 0; i < slices; i++)
+        {
+            unsigned int a = j * rowLength + i;
+            unsigned int b = a + rowLength;
+            unsigned int quad[6] = {a, b, b + 1, a, b + 1, a + 1};
+            mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+        }
+    }
+    return mesh;
+}
+
+MeshData buildGridMesh(int halfExtent)
+{
+    MeshData mesh;
+    mesh.primitive = MESH_LINES;
+
+    float extent = (float)halfExtent;
+    for (int i = -halfExtent; i <= halfExtent; i++)
+    {
+        addVertex(mesh, i, 0, -extent, 0, 1, 0);
+        addVertex(mesh, i, 0, extent, 0, 1, 0);
+        addVertex(mesh, -extent, 0, i, 0, 1, 0);
+        addVertex(mesh, extent, 0, i, 0, 1, 0);
+    }
+
+    for (unsigned int i = 0; i < mesh.vertices.size(); i++)
+        mesh.indices.push_back(i);
+    return mesh;
+}
+
+MeshData buildPointMesh(const std::vector<Vec3> &points, MeshPrimitive primitive)
+{
+    MeshData mesh;
+    mesh.primitive = primitive;
+    mesh.vertices.reserve(points.size());
+    mesh.indices.reserve(points.size());
+
+    for (unsigned int i = 0; i < points.size(); i++)
+    {
+        addVertex(mesh, points[i].x, points[i].y, points[i].z, 0, 1, 0);
+        mesh.indices.push_back(i);
+    }
+    return mesh;
+}
+
+void transformMesh(MeshData &mesh, float tx, float ty, float tz, float sx, float sy, float sz)
+{
+    for (MeshVertex &v : mesh.vertices)
+    {
+        v.px = v.px * sx + tx;
+        v.py = v.py * sy + ty;
+        v.pz = v.pz * sz + tz;
+
+        // Normals transform by the inverse scale
+        float nx = v.nx / sx;
+        float ny = v.ny / sy;
+        float nz = v.nz / sz;
+        float len = sqrt(nx * nx + ny * ny + nz * nz);
+        if (len > 0)
+        {
+            v.nx = nx / len;
+            v.ny = ny / len;
+            v.nz = nz / len;
+        }
+    }
+}
+
+// ============================================================================
+// GPU MESHES
+// ============================================================================
+
+unsigned int meshPrimitiveMode(MeshPrimitive primitive)
+{
+    switch (primitive)
+    {
+    case MESH_LINES:
+        return GL_LINES;
+    case MESH_LINE_STRIP:
+        return GL_LINE_STRIP;
+    case MESH_POINTS:
+        return GL_POINTS;
+    default:
+        return GL_TRIANGLES;
+    }
+}
+
+static void setVertexPointers()
+{
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glVertexPointer(3, GL_FLOAT, sizeof(MeshVertex), (const void *)offsetof(MeshVertex, px));
+    glNormalPointer(GL_FLOAT, sizeof(MeshVertex), (const void *)offsetof(MeshVertex, nx));
+}
+
+Mesh uploadMesh(const MeshData &data)
+{
+    Mesh mesh;
+    mesh.primitive = data.primitive;
+    mesh.indexCount = (int)data.indices.size();
+
+    bool hasVertexArrays = GLEW_VERSION_3_0 || GLEW_ARB_vertex_array_object;
+    if (hasVertexArrays)
+    {
+        glGenVertexArrays(1, &mesh.vertexArray);
+        glBindVertexArray(mesh.vertexArray);
+    }
+
+    glGenBuffers(1, &mesh.vertexBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, data.vertices.size() * sizeof(MeshVertex),
+                 data.vertices.data(), GL_STATIC_DRAW);
+
+    glGenBuffers(1, &mesh.indexBuffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indexBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, data.indices.size() * sizeof(unsigned int),
+                 data.indices.data(), GL_STATIC_DRAW);
+
+    // The vertex array object records the pointers and the index buffer
+    if (hasVertexArrays)
+    {
+        setVertexPointers();
+        glBindVertexArray(0);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    return mesh;
+}
+
+void destroyMesh(Mesh &mesh)
+{
+    if (mesh.vertexArray)
+        glDeleteVertexArrays(1, &mesh.vertexArray);
+    if (mesh.vertexBuffer)
+        glDeleteBuffers(1, &mesh.vertexBuffer);
+    if (mesh.indexBuffer)
+        glDeleteBuffers(1, &mesh.indexBuffer);
+    mesh = Mesh();
+}
+
+void drawMesh(const Mesh &mesh)
+{
+    GLenum mode = meshPrimitiveMode(mesh.primitive);
+
+    if (mesh.vertexArray)
+    {
+        glBindVertexArray(mesh.vertexArray);
+        glDrawElements(mode, mesh.indexCount, GL_UNSIGNED_INT, 0);
+        glBindVertexArray(0);
+        return;
+    }
+
+    // No vertex array objects: bind the buffers and set the pointers each draw
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.vertexBuffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indexBuffer);
+    setVertexPointers();
+    glDrawElements(mode, mesh.indexCount, GL_UNSIGNED_INT, 0);
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
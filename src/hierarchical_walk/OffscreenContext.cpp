@@ -0,0 +1,95 @@
+#include "hierarchical_walk/OffscreenContext.h"
+
+#ifdef HAVE_EGL
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <cstring>
+
+static EGLDisplay offscreenDisplay = EGL_NO_DISPLAY;
+static EGLContext offscreenContext = EGL_NO_CONTEXT;
+
+// Prefer Mesa's surfaceless platform, which needs no GPU device or display;
+// fall back to the default display
+static EGLDisplay openDisplay()
+{
+    const char *extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if (extensions && strstr(extensions, "EGL_MESA_platform_surfaceless"))
+    {
+        PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+            (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if (getPlatformDisplay)
+        {
+            EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+            if (display != EGL_NO_DISPLAY)
+                return display;
+        }
+    }
+    return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+bool createOffscreenContext()
+{
+    destroyOffscreenContext();
+
+    offscreenDisplay = openDisplay();
+    if (offscreenDisplay == EGL_NO_DISPLAY)
+        return false;
+
+    EGLint major, minor;
+    if (!eglInitialize(offscreenDisplay, &major, &minor) || !eglBindAPI(EGL_OPENGL_API))
+    {
+        destroyOffscreenContext();
+        return false;
+    }
+
+    // The renderer uses the fixed-function pipeline, so ask for a compatibility context
+    EGLConfig config;
+    EGLint configCount = 0;
+    const EGLint configAttributes[] = {EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE};
+    eglChooseConfig(offscreenDisplay, configAttributes, &config, 1, &configCount);
+
+    const char *extensions = eglQueryString(offscreenDisplay, EGL_EXTENSIONS);
+    bool noConfig = extensions && strstr(extensions, "EGL_KHR_no_config_context");
+    if (configCount < 1 && !noConfig)
+    {
+        destroyOffscreenContext();
+        return false;
+    }
+
+    offscreenContext = eglCreateContext(offscreenDisplay, configCount > 0 ? config : EGL_NO_CONFIG_KHR,
+                                        EGL_NO_CONTEXT, nullptr);
+    if (offscreenContext == EGL_NO_CONTEXT ||
+        !eglMakeCurrent(offscreenDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, offscreenContext))
+    {
+        destroyOffscreenContext();
+        return false;
+    }
+    return true;
+}
+
+void destroyOffscreenContext()
+{
+    if (offscreenDisplay == EGL_NO_DISPLAY)
+        return;
+
+    eglMakeCurrent(offscreenDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (offscreenContext != EGL_NO_CONTEXT)
+        eglDestroyContext(offscreenDisplay, offscreenContext);
+    eglTerminate(offscreenDisplay);
+    offscreenContext = EGL_NO_CONTEXT;
+    offscreenDisplay = EGL_NO_DISPLAY;
+}
+
+#else
+
+bool createOffscreenContext()
+{
+    return false;
+}
+
+void destroyOffscreenContext()
+{
+}
+
+#endif
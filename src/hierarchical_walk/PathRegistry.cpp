@@ -0,0 +1,85 @@
+#include "hierarchical_walk/PathRegistry.h"
+#include "hierarchical_walk/Constants.h"
+#include "hierarchical_walk/FileIO.h"
+
+PathData::PathData()
+    : dt(DEFAULT_DT)
+{
+}
+
+size_t PathData::memoryBytes() const
+{
+    return spline.controlPoints().capacity() * sizeof(Vec3)
+        + spline.segmentCount() * sizeof(SplineSegment)
+        + arcLength.memoryBytes();
+}
+
+WalkerPath::WalkerPath()
+    : path(INVALID_PATH),
+      speedScale(1.0f),
+      lateralOffset(0.0f),
+      constantSpeed(false)
+{
+}
+
+WalkerPath::WalkerPath(PathHandle handle)
+    : path(handle),
+      speedScale(1.0f),
+      lateralOffset(0.0f),
+      constantSpeed(false)
+{
+}
+
+PathHandle PathRegistry::load(const std::string &filename, bool quiet)
+{
+    PathHandle existing = find(filename);
+    if (existing != INVALID_PATH)
+        return existing;
+
+    std::shared_ptr<PathData> data(new PathData());
+    data->name = filename;
+    if (!loadPath(filename.c_str(), data->spline, data->dt, quiet) || !data->spline.isValid())
+        return INVALID_PATH;
+    return insert(data);
+}
+
+PathHandle PathRegistry::add(const std::string &name, const std::vector<Vec3> &points, SplineType type, float dt)
+{
+    PathHandle existing = find(name);
+    if (existing != INVALID_PATH)
+        return existing;
+
+    std::shared_ptr<PathData> data(new PathData());
+    data->name = name;
+    data->dt = dt;
+    data->spline.setControlPoints(points, type);
+    if (!data->spline.isValid())
+        return INVALID_PATH;
+    return insert(data);
+}
+
+PathHandle PathRegistry::find(const std::string &name) const
+{
+    // Paths are few and looked up only when loading, so a linear search will do
+    for (size_t i = 0; i < paths.size(); i++)
+    {
+        if (paths[i]->name == name)
+            return (PathHandle)i;
+    }
+    return INVALID_PATH;
+}
+
+size_t PathRegistry::memoryBytes() const
+{
+    size_t bytes = paths.capacity() * sizeof(SharedPath);
+    for (const SharedPath &path : paths)
+        bytes += sizeof(PathData) + path->memoryBytes();
+    return bytes;
+}
+
+PathHandle PathRegistry::insert(const std::shared_ptr<PathData> &data)
+{
+    data->arcLength.build(data->spline);
+    paths.push_back(data);
+    return (PathHandle)(paths.size() - 1);
+}
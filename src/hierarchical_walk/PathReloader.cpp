@@ -0,0 +1,102 @@
+#include "hierarchical_walk/PathReloader.h"
+#include "hierarchical_walk/FileIO.h"
+#include <chrono>
+
+// How often the reload thread checks whether it should stop
+static const int STOP_POLL_MS = 100;
+
+PathReload::PathReload()
+    : seconds(0.0)
+{
+}
+
+PathReloader::PathReloader()
+    : running(false),
+      displayTolerance(DEFAULT_PATH_TOLERANCE),
+      hasReady(false)
+{
+}
+
+PathReloader::~PathReloader()
+{
+    stop();
+}
+
+bool PathReloader::start(const SharedPath &path, float tolerance)
+{
+    stop();
+    if (!path || !watcher.watch(path->name))
+        return false;
+
+    current = path;
+    displayTolerance = tolerance;
+    tessellation = PathTessellation();
+    running.store(true, std::memory_order_release);
+    thread = std::thread(&PathReloader::run, this);
+    return true;
+}
+
+void PathReloader::stop()
+{
+    if (!running.exchange(false))
+        return;
+    thread.join();
+    watcher.close();
+}
+
+bool PathReloader::take(PathReload &out)
+{
+    std::lock_guard<std::mutex> lock(readyMutex);
+    if (!hasReady)
+        return false;
+    out = std::move(ready);
+    ready = PathReload();
+    hasReady = false;
+    return true;
+}
+
+void PathReloader::run()
+{
+    // The first rebuild needs a polyline to update; build it here, off the render thread
+    tessellation.build(current->spline, displayTolerance);
+
+    while (running.load(std::memory_order_acquire))
+    {
+        if (!watcher.wait(STOP_POLL_MS))
+            continue;
+
+        // Let the rest of the save land before reading
+        while (running.load(std::memory_order_acquire) && watcher.wait(RELOAD_SETTLE_MS))
+        {
+        }
+        if (running.load(std::memory_order_acquire))
+            reload();
+    }
+}
+
+void PathReloader::reload()
+{
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point start = Clock::now();
+
+    // Copy the current path and edit the copy; readers of the current one are untouched
+    PathReload result;
+    std::shared_ptr<PathData> next(new PathData(*current));
+    if (reloadPath(next->name.c_str(), next->spline, next->dt, result.edit))
+    {
+        next->arcLength.update(next->spline, current->arcLength, result.edit);
+        tessellation.update(next->spline, result.edit);
+        current = next;
+        result.path = next;
+        result.tessellation = tessellation;
+    }
+    result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    // An unread reload is replaced, since only the newest path matters, but
+    // a failed load never hides a good path that is still waiting
+    std::lock_guard<std::mutex> lock(readyMutex);
+    if (!result.path && hasReady && ready.path)
+        return;
+    ready = std::move(result);
+    hasReady = true;
+}
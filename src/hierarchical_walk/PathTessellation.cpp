@@ -0,0 +1,131 @@
+#include "hierarchical_walk/PathTessellation.h"
+#include "hierarchical_walk/SplineBatch.h"
+
+// Limit on interval halvings per segment (at most 2^16 pieces)
+static const int MAX_SUBDIVISION_DEPTH = 16;
+
+PathTessellation::PathTessellation()
+    : errorTolerance(DEFAULT_PATH_TOLERANCE),
+      sourceVersion(0)
+{
+}
+
+void PathTessellation::build(const CompiledSpline &path, float tolerance)
+{
+    errorTolerance = tolerance > 0.0f ? tolerance : DEFAULT_PATH_TOLERANCE;
+    segmentVertices.assign(path.segmentCount(), std::vector<Vec3>());
+
+    for (int i = 0; i < path.segmentCount(); i++)
+        tessellateSegment(path, i, segmentVertices[i]);
+
+    endPoint = path.evaluate(1.0f);
+    sourceVersion = path.version();
+    flatten();
+}
+
+void PathTessellation::update(const CompiledSpline &path, const SplineEdit &edit)
+{
+    if ((int)segmentVertices.size() != edit.oldCount || path.segmentCount() != edit.newCount)
+    {
+        build(path, errorTolerance);
+        return;
+    }
+
+    std::vector<std::vector<Vec3>> updated(edit.newCount);
+    for (int i = 0; i < edit.newCount; i++)
+    {
+        int old = edit.previousSegment(i);
+        if (old >= 0)
+            updated[i].swap(segmentVertices[old]);
+        else
+            tessellateSegment(path, i, updated[i]);
+    }
+    segmentVertices.swap(updated);
+
+    endPoint = path.evaluate(1.0f);
+    sourceVersion = path.version();
+    flatten();
+}
+
+void PathTessellation::rebuildSegments(const CompiledSpline &path, int first, int last)
+{
+    // A different segment count means the whole layout changed
+    if ((int)segmentVertices.size() != path.segmentCount())
+    {
+        build(path, errorTolerance);
+        return;
+    }
+
+    if (first < 0)
+        first = 0;
+    if (last > path.segmentCount() - 1)
+        last = path.segmentCount() - 1;
+
+    for (int i = first; i <= last; i++)
+        tessellateSegment(path, i, segmentVertices[i]);
+
+    endPoint = path.evaluate(1.0f);
+    sourceVersion = path.version();
+    flatten();
+}
+
+void PathTessellation::tessellateSegment(const CompiledSpline &path, int segment, std::vector<Vec3> &out) const
+{
+    // Choose the vertex parameters first, then evaluate them in one batch
+    std::vector<float> parameters;
+
+    // Intervals still to be checked; the top of the stack is the leftmost
+    struct Interval
+    {
+        float u0, u1;
+        float curvature0, curvature1; // |p''| at the ends
+        int depth;
+    };
+
+    Interval stack[MAX_SUBDIVISION_DEPTH + 2];
+    int top = 0;
+    stack[top++] = {0.0f, 1.0f,
+                    path.segmentSecondDerivative(segment, 0.0f).length(),
+                    path.segmentSecondDerivative(segment, 1.0f).length(),
+                    0};
+
+    while (top > 0)
+    {
+        Interval interval = stack[--top];
+        float h = interval.u1 - interval.u0;
+
+        // p'' is linear in u, so its largest magnitude on the interval is at an end
+        float maxCurvature = interval.curvature0 > interval.curvature1 ? interval.curvature0 : interval.curvature1;
+        float chordError = h * h * 0.125f * maxCurvature;
+
+        if (chordError <= errorTolerance || interval.depth >= MAX_SUBDIVISION_DEPTH)
+        {
+            parameters.push_back(interval.u0);
+            continue;
+        }
+
+        // Push the right half first so the left half is emitted first
+        float mid = (interval.u0 + interval.u1) * 0.5f;
+        float curvatureMid = path.segmentSecondDerivative(segment, mid).length();
+        stack[top++] = {mid, interval.u1, curvatureMid, interval.curvature1, interval.depth + 1};
+        stack[top++] = {interval.u0, mid, interval.curvature0, curvatureMid, interval.depth + 1};
+    }
+
+    out.resize(parameters.size());
+    evaluateSegmentBatch(path, segment, parameters.data(), parameters.size(), out.data());
+}
+
+void PathTessellation::flatten()
+{
+    size_t total = 1;
+    for (const std::vector<Vec3> &segment : segmentVertices)
+        total += segment.size();
+
+    polyline.clear();
+    polyline.reserve(total);
+    for (const std::vector<Vec3> &segment : segmentVertices)
+        polyline.insert(polyline.end(), segment.begin(), segment.end());
+
+    if (!segmentVertices.empty())
+        polyline.push_back(endPoint);
+}
@@ -0,0 +1,255 @@
+#include "hierarchical_walk/Profiler.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+
+ProfileEvent::ProfileEvent()
+    : name(""),
+      start(0),
+      duration(0),
+      thread(0)
+{
+}
+
+ProfileRing::ProfileRing(int index, const char *name)
+    : written(0),
+      threadName(name),
+      ringIndex(index),
+      slots(new Slot[PROFILE_RING_CAPACITY])
+{
+}
+
+uint64_t ProfileRing::drain(uint64_t &readIndex, std::vector<ProfileEvent> &out) const
+{
+    uint64_t end = written.load(std::memory_order_acquire);
+    uint64_t begin = readIndex;
+    uint64_t lost = 0;
+    if (end - begin > PROFILE_RING_CAPACITY)
+    {
+        lost += end - PROFILE_RING_CAPACITY - begin;
+        begin = end - PROFILE_RING_CAPACITY;
+    }
+
+    size_t first = out.size();
+    for (uint64_t i = begin; i < end; i++)
+    {
+        const Slot &slot = slots[i & (PROFILE_RING_CAPACITY - 1)];
+        ProfileEvent event;
+        event.name = slot.name.load(std::memory_order_relaxed);
+        event.start = slot.start.load(std::memory_order_relaxed);
+        event.duration = slot.duration.load(std::memory_order_relaxed);
+        event.thread = ringIndex;
+        out.push_back(event);
+    }
+
+    // Slots the writer reached while they were copied may be torn. Writing
+    // index w (even unfinished) overwrites index w - capacity.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t after = written.load(std::memory_order_relaxed);
+    uint64_t unsafe = after + 1 > PROFILE_RING_CAPACITY ? after + 1 - PROFILE_RING_CAPACITY : 0;
+    if (unsafe > begin)
+    {
+        size_t torn = (size_t)(std::min(unsafe, end) - begin);
+        out.erase(out.begin() + first, out.begin() + first + torn);
+        lost += torn;
+    }
+
+    readIndex = end;
+    return lost;
+}
+
+ProfileStat::ProfileStat()
+    : name(""),
+      count(0),
+      next(0),
+      total(0)
+{
+}
+
+void ProfileStat::add(float ms)
+{
+    milliseconds[next] = ms;
+    next = (next + 1) % PROFILE_HISTORY;
+    count = std::min(count + 1, PROFILE_HISTORY);
+    total++;
+}
+
+float ProfileStat::percentile(float p) const
+{
+    if (count == 0)
+        return 0.0f;
+
+    float sorted[PROFILE_HISTORY];
+    std::copy(milliseconds, milliseconds + count, sorted);
+    int rank = std::min(count - 1, std::max(0, (int)(p * (count - 1) + 0.5f)));
+    std::nth_element(sorted, sorted + rank, sorted + count);
+    return sorted[rank];
+}
+
+void ProfileStat::history(std::vector<float> &out) const
+{
+    out.clear();
+    int oldest = count < PROFILE_HISTORY ? 0 : next;
+    for (int i = 0; i < count; i++)
+        out.push_back(milliseconds[(oldest + i) % PROFILE_HISTORY]);
+}
+
+Profiler::Profiler()
+    : epoch(std::chrono::steady_clock::now()),
+      ringCount(0),
+      gpuRing(nullptr),
+      dropped(0),
+      tracing(false)
+{
+}
+
+Profiler &profiler()
+{
+    static Profiler instance;
+    return instance;
+}
+
+uint64_t Profiler::now() const
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+ProfileRing *Profiler::addRing(const char *name)
+{
+    std::lock_guard<std::mutex> lock(ringMutex);
+    int index = ringCount.load(std::memory_order_relaxed);
+    if (index == PROFILE_MAX_THREADS)
+        return nullptr;
+    rings[index].reset(new ProfileRing(index, name));
+    ringCount.store(index + 1, std::memory_order_release);
+    return rings[index].get();
+}
+
+ProfileRing *Profiler::threadRing()
+{
+    // There is one profiler per process, so the ring can be cached per thread
+    thread_local ProfileRing *ring = nullptr;
+    thread_local bool registered = false;
+    if (!registered)
+    {
+        registered = true;
+        ring = addRing(nullptr);
+    }
+    return ring;
+}
+
+void Profiler::recordGpu(const char *name, uint64_t start, uint64_t duration)
+{
+    if (!gpuRing)
+        gpuRing = addRing("GPU");
+    if (gpuRing)
+        gpuRing->push(name, start, duration);
+}
+
+void Profiler::setThreadName(const char *name)
+{
+    if (ProfileRing *ring = threadRing())
+        ring->setName(name);
+}
+
+void Profiler::collect()
+{
+    int count = ringCount.load(std::memory_order_acquire);
+    readIndex.resize(count, 0);
+    drained.clear();
+    for (int i = 0; i < count; i++)
+        dropped += rings[i]->drain(readIndex[i], drained);
+
+    for (const ProfileEvent &event : drained)
+    {
+        // Scopes are few, so a linear search by name is cheap
+        ProfileStat *target = nullptr;
+        for (ProfileStat &stat : scopeStats)
+        {
+            if (stat.name == event.name || strcmp(stat.name, event.name) == 0)
+            {
+                target = &stat;
+                break;
+            }
+        }
+        if (!target)
+        {
+            scopeStats.push_back(ProfileStat());
+            target = &scopeStats.back();
+            target->name = event.name;
+        }
+        target->add(event.duration / 1e6f);
+    }
+
+    if (tracing)
+        traceEvents.insert(traceEvents.end(), drained.begin(), drained.end());
+}
+
+const ProfileStat *Profiler::stat(const char *name) const
+{
+    for (const ProfileStat &stat : scopeStats)
+    {
+        if (strcmp(stat.name, name) == 0)
+            return &stat;
+    }
+    return nullptr;
+}
+
+bool Profiler::writeTrace(const char *filename) const
+{
+    FILE *file = fopen(filename, "w");
+    if (!file)
+    {
+        std::cerr << "Error: Could not write trace " << filename << std::endl;
+        return false;
+    }
+
+    // Complete ("X") events in microseconds, one lane per recording thread.
+    // Scope names are string literals and are written without escaping.
+    fprintf(file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    // Records are separated, not terminated, by commas
+    const char *separator = "";
+    int count = ringCount.load(std::memory_order_acquire);
+    for (int i = 0; i < count; i++)
+    {
+        const char *name = rings[i]->name();
+        if (name)
+            fprintf(file, "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"args\": {\"name\": \"%s\"}}", separator, i, name);
+        else
+            fprintf(file, "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"args\": {\"name\": \"thread %d\"}}", separator, i, i);
+        separator = ",\n";
+    }
+    for (const ProfileEvent &event : traceEvents)
+    {
+        fprintf(file, "%s{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f}",
+                separator, event.name, event.thread, event.start / 1000.0, event.duration / 1000.0);
+        separator = ",\n";
+    }
+    fprintf(file, "\n]}\n");
+
+    bool ok = !ferror(file);
+    if (fclose(file) != 0 || !ok)
+    {
+        std::cerr << "Error: Failed writing trace " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void Profiler::printSummary(std::ostream &out) const
+{
+    out << "=== Profile (last " << PROFILE_HISTORY << " samples per scope) ===" << std::endl;
+    out << std::left << std::setw(24) << "Scope" << std::right << std::setw(10) << "Count"
+        << std::setw(12) << "p50 ms" << std::setw(12) << "p99 ms" << std::endl;
+    for (const ProfileStat &stat : scopeStats)
+    {
+        out << std::left << std::setw(24) << stat.name << std::right << std::setw(10) << stat.total
+            << std::fixed << std::setprecision(3)
+            << std::setw(12) << stat.percentile(0.5f) << std::setw(12) << stat.percentile(0.99f)
+            << std::defaultfloat << std::endl;
+    }
+    if (dropped > 0)
+        out << dropped << " events dropped (rings overran between collections)" << std::endl;
+}
@@ -1,14 +1,57 @@
 #include "hierarchical_walk/Renderer.h"
 #include "hierarchical_walk/Constants.h"
+#include "hierarchical_walk/Mesh.h"
+#include "hierarchical_walk/PathTessellation.h"
+#include "hierarchical_walk/SplineEngine.h"
 #include <GL/glew.h>
 #include <GL/glu.h>
+#include <algorithm>
 #include <cmath>
+#include <utility>
+
+static SceneMeshes meshes;
+
+// Tessellated path and control points, rebuilt only when the path changes
+struct PathDisplayCache
+{
+    PathTessellation tessellation;
+    Mesh curve;
+    Mesh points;
+    float tolerance = DEFAULT_PATH_TOLERANCE;
+    bool uploaded = false;
+    unsigned uploadedVersion = 0; // Path version the meshes were built from
+};
+
+// One cache per path slot, so several paths can be drawn each frame
+static std::vector<PathDisplayCache> pathCaches;
+static float pathTolerance = DEFAULT_PATH_TOLERANCE;
+
+static PathDisplayCache &pathCache(int slot)
+{
+    if ((int)pathCaches.size() <= slot)
+    {
+        PathDisplayCache empty;
+        empty.tolerance = pathTolerance;
+        pathCaches.resize(slot + 1, empty);
+    }
+    return pathCaches[slot];
+}
+
+const SceneMeshes *sceneMeshes()
+{
+    return meshes.ready ? &meshes : nullptr;
+}
+
+// Shared quadric for the immediate-mode primitives
+static GLUquadric *sharedQuadric()
+{
+    static GLUquadric *quad = gluNewQuadric();
+    return quad;
+}
 
 void drawCylinder(float radius, float height)
 {
-    GLUquadric *quad = gluNewQuadric();
-    gluCylinder(quad, radius, radius, height, 20, 20);
-    gluDeleteQuadric(quad);
+    gluCylinder(sharedQuadric(), radius, radius, height, 20, 20);
 }
 
 void drawBox(float width, float height, float depth)
@@ -60,46 +103,13 @@ void drawBox(float width, float height, float depth)
 
 void drawSphere(float radius)
 {
-    GLUquadric *quad = gluNewQuadric();
-    gluSphere(quad, radius, 20, 20);
-    gluDeleteQuadric(quad);
+    gluSphere(sharedQuadric(), radius, 20, 20);
 }
 
-void drawLeg(float hipAngle, float kneeAngle)
+// Immediate-mode foot, used when the mesh cache is unavailable
+static void drawFootImmediate()
 {
     glPushMatrix();
-
-    // Hip joint rotation
-    glRotatef(hipAngle, 1, 0, 0);
-
-    // Upper leg (thigh)
-    glColor3f(0.3f, 0.3f, 0.8f);
-    glPushMatrix();
-    glRotatef(-90, 1, 0, 0);
-    drawCylinder(LEG_RADIUS, LEG_LENGTH);
-    glPopMatrix();
-
-    // Move to knee position
-    glTranslatef(0, -LEG_LENGTH, 0);
-
-    // Knee joint
-    glColor3f(0.8f, 0.2f, 0.2f);
-    drawSphere(LEG_RADIUS * 1.2);
-
-    // Knee rotation
-    glRotatef(kneeAngle, 1, 0, 0);
-
-    // Lower leg (shin)
-    glColor3f(0.3f, 0.3f, 0.8f);
-    glPushMatrix();
-    glRotatef(-90, 1, 0, 0);
-    drawCylinder(LEG_RADIUS * 0.9, LEG_LENGTH);
-    glPopMatrix();
-
-    // Foot
-    glTranslatef(0, -LEG_LENGTH, 0);
-    glColor3f(0.6f, 0.4f, 0.2f);
-    glPushMatrix();
     glTranslatef(0, -LEG_RADIUS / 2, LEG_RADIUS);
     glScalef(1.5, 0.5, 2.5);
     glBegin(GL_QUADS);
@@ -131,41 +141,63 @@ void drawLeg(float hipAngle, float kneeAngle)
     glVertex3f(s, s, -s);
     glEnd();
     glPopMatrix();
-
-    glPopMatrix();
 }
 
-void drawFigure(const ArticulatedFigure &figure)
+const float *figureShapeColor(int shape)
 {
-    glPushMatrix();
-
-    // Position figure
-    glTranslatef(figure.position.x, figure.position.y, figure.position.z);
-
-    // Orient figure in forward direction
-    float angle = atan2(figure.forward.x, figure.forward.z) * 180.0f / PI;
-    glRotatef(angle, 0, 1, 0);
-
-    // Apply body tilt
-    glRotatef(figure.bodyTilt, 1, 0, 0);
+    static const float colors[FIGURE_SHAPE_COUNT][3] = {
+        {0.6f, 0.3f, 0.3f}, // Torso
+        {0.3f, 0.3f, 0.8f}, // Thigh
+        {0.8f, 0.2f, 0.2f}, // Knee
+        {0.3f, 0.3f, 0.8f}, // Shin
+        {0.6f, 0.4f, 0.2f}, // Foot
+    };
+    return colors[shape];
+}
 
-    // Draw torso
-    glColor3f(0.6f, 0.3f, 0.3f);
-    drawBox(TORSO_WIDTH, TORSO_HEIGHT, TORSO_DEPTH);
+// One figure shape at the current matrix, retained or immediate
+static void drawShape(int shape)
+{
+    if (meshes.ready)
+    {
+        drawMesh(meshes.shapes[shape]);
+        return;
+    }
 
-    // Draw left leg
-    glPushMatrix();
-    glTranslatef(-TORSO_WIDTH * 0.3f, 0, 0);
-    drawLeg(figure.leftHipAngle, figure.leftKneeAngle);
-    glPopMatrix();
+    switch (shape)
+    {
+    case SHAPE_TORSO:
+        drawBox(TORSO_WIDTH, TORSO_HEIGHT, TORSO_DEPTH);
+        break;
+    case SHAPE_THIGH:
+        drawCylinder(LEG_RADIUS, LEG_LENGTH);
+        break;
+    case SHAPE_KNEE:
+        drawSphere(LEG_RADIUS * 1.2);
+        break;
+    case SHAPE_SHIN:
+        drawCylinder(LEG_RADIUS * 0.9, LEG_LENGTH);
+        break;
+    case SHAPE_FOOT:
+        drawFootImmediate();
+        break;
+    }
+}
 
-    // Draw right leg
-    glPushMatrix();
-    glTranslatef(TORSO_WIDTH * 0.3f, 0, 0);
-    drawLeg(figure.rightHipAngle, figure.rightKneeAngle);
-    glPopMatrix();
+void drawFigure(const ArticulatedFigure &figure)
+{
+    Mat4 joints[FIGURE_JOINT_COUNT];
+    computeFigureJoints(figure, joints);
 
-    glPopMatrix();
+    for (const SkeletonPart &part : figureParts())
+    {
+        Mat4 model = joints[part.joint] * part.placement;
+        glColor3fv(figureShapeColor(part.shape));
+        glPushMatrix();
+        glMultMatrixf(model.data());
+        drawShape(part.shape);
+        glPopMatrix();
+    }
 }
 
 void drawSpline(const std::vector<Vec3> &controlPoints, SplineType type)
@@ -188,31 +220,227 @@ void drawSpline(const std::vector<Vec3> &controlPoints, SplineType type)
     // Draw spline curve
     glColor3f(0.0f, 1.0f, 0.0f);
     glLineWidth(2.0f);
-    glBegin(GL_LINE_STRIP);
-    for (float i = 0; i <= 1.0f; i += 0.01f)
+    float parameters[101];
+    Vec3 curve[101];
+    for (int i = 0; i <= 100; i++)
+        parameters[i] = i / 100.0f;
+    visitSplineBasis(type, [&](auto basis)
     {
-        Vec3 p = (type == CATMULL_ROM) ? evaluateCatmullRom(controlPoints, i) : evaluateBSpline(controlPoints, i);
+        SplineEngine<decltype(basis)>(controlPoints).evaluate(parameters, 101, curve, nullptr);
+    });
+
+    glBegin(GL_LINE_STRIP);
+    for (const auto &p : curve)
         glVertex3f(p.x, p.y, p.z);
-    }
     glEnd();
 
     glEnable(GL_LIGHTING);
 }
 
+void drawPolyline(const std::vector<Vec3> &vertices)
+{
+    if (vertices.size() < 2)
+        return;
+
+    glDisable(GL_LIGHTING);
+    glColor3f(0.0f, 1.0f, 0.0f);
+    glLineWidth(2.0f);
+    glBegin(GL_LINE_STRIP);
+    for (const auto &p : vertices)
+        glVertex3f(p.x, p.y, p.z);
+    glEnd();
+    glEnable(GL_LIGHTING);
+}
+
+static void releasePathCache(PathDisplayCache &cache)
+{
+    if (!cache.uploaded)
+        return;
+
+    destroyMesh(cache.curve);
+    destroyMesh(cache.points);
+    cache.uploaded = false;
+}
+
+static void releasePathCaches()
+{
+    for (PathDisplayCache &cache : pathCaches)
+        releasePathCache(cache);
+}
+
+// Re-tessellate and re-upload when the path has changed since the last draw
+static void updatePathCache(PathDisplayCache &cache, const CompiledSpline &path)
+{
+    if (cache.uploaded && cache.uploadedVersion == path.version())
+        return;
+
+    // A polyline handed over by setPathTessellation is already current
+    if (cache.tessellation.isStale(path))
+        cache.tessellation.build(path, cache.tolerance);
+
+    releasePathCache(cache);
+    cache.curve = uploadMesh(buildPointMesh(cache.tessellation.vertices(), MESH_LINE_STRIP));
+    cache.points = uploadMesh(buildPointMesh(path.controlPoints(), MESH_POINTS));
+    cache.uploaded = true;
+    cache.uploadedVersion = path.version();
+}
+
+void setPathTolerance(float tolerance)
+{
+    if (tolerance <= 0.0f)
+        return;
+
+    pathTolerance = tolerance;
+    for (PathDisplayCache &cache : pathCaches)
+    {
+        cache.tolerance = tolerance;
+        cache.tessellation = PathTessellation(); // Force a rebuild on the next draw
+        releasePathCache(cache);
+    }
+}
+
+void setPathTessellation(int slot, PathTessellation &tessellation)
+{
+    PathDisplayCache &cache = pathCache(slot);
+    if (tessellation.tolerance() == cache.tolerance)
+        cache.tessellation = std::move(tessellation);
+}
+
+void drawSpline(const CompiledSpline &path, int slot)
+{
+    if (!path.isValid())
+        return;
+
+    PathDisplayCache &cache = pathCache(slot);
+
+    // Without buffer objects, draw from the tessellation in immediate mode
+    if (!meshes.ready)
+    {
+        if (cache.tessellation.isStale(path))
+            cache.tessellation.build(path, cache.tolerance);
+    }
+    else
+    {
+        updatePathCache(cache, path);
+    }
+
+    glDisable(GL_LIGHTING);
+
+    // Draw control points
+    glPointSize(8.0f);
+    glColor3f(1.0f, 0.0f, 0.0f);
+    if (cache.uploaded)
+    {
+        drawMesh(cache.points);
+    }
+    else
+    {
+        glBegin(GL_POINTS);
+        for (const auto &p : path.controlPoints())
+            glVertex3f(p.x, p.y, p.z);
+        glEnd();
+    }
+
+    // Draw spline curve
+    glColor3f(0.0f, 1.0f, 0.0f);
+    glLineWidth(2.0f);
+    if (cache.uploaded)
+    {
+        drawMesh(cache.curve);
+    }
+    else
+    {
+        glBegin(GL_LINE_STRIP);
+        for (const auto &p : cache.tessellation.vertices())
+            glVertex3f(p.x, p.y, p.z);
+        glEnd();
+    }
+
+    glEnable(GL_LIGHTING);
+}
+
 void drawGround()
 {
     glDisable(GL_LIGHTING);
     glColor3f(0.4f, 0.4f, 0.4f);
+    if (meshes.ready)
+    {
+        drawMesh(meshes.ground);
+    }
+    else
+    {
+        glBegin(GL_LINES);
+        for (int i = -10; i <= 10; i++)
+        {
+            glVertex3f(i, 0, -10);
+            glVertex3f(i, 0, 10);
+            glVertex3f(-10, 0, i);
+            glVertex3f(10, 0, i);
+        }
+        glEnd();
+    }
+    glEnable(GL_LIGHTING);
+}
+
+void drawFrameTimeGraph(const std::vector<float> &frameMs, float p50, float p99, int windowWidth, int windowHeight)
+{
+    // Pixel coordinates, origin at the bottom left, drawn over the scene
+    glPushAttrib(GL_ENABLE_BIT | GL_CURRENT_BIT | GL_LINE_BIT);
+    glDisable(GL_LIGHTING);
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadIdentity();
+    glOrtho(0, windowWidth, 0, windowHeight, -1, 1);
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glLoadIdentity();
+
+    // The vertical scale fits twice the p99, and at least two 60 Hz frames
+    const float left = 10.0f, bottom = 10.0f, height = 120.0f, step = 2.0f;
+    float width = step * std::max((int)frameMs.size(), 1);
+    float scale = height / std::max(2.0f * p99, 2.0f * 1000.0f / 60.0f);
+
+    glColor4f(0.0f, 0.0f, 0.0f, 0.6f);
+    glBegin(GL_QUADS);
+    glVertex2f(left, bottom);
+    glVertex2f(left + width, bottom);
+    glVertex2f(left + width, bottom + height);
+    glVertex2f(left, bottom + height);
+    glEnd();
+
+    // One bar per frame, oldest on the left
+    glColor4f(0.3f, 0.6f, 1.0f, 0.9f);
     glBegin(GL_LINES);
-    for (int i = -10; i <= 10; i++)
+    for (size_t i = 0; i < frameMs.size(); i++)
     {
-        glVertex3f(i, 0, -10);
-        glVertex3f(i, 0, 10);
-        glVertex3f(-10, 0, i);
-        glVertex3f(10, 0, i);
+        float x = left + step * i + 0.5f;
+        glVertex2f(x, bottom);
+        glVertex2f(x, bottom + std::min(frameMs[i] * scale, height));
     }
     glEnd();
-    glEnable(GL_LIGHTING);
+
+    // 60 Hz budget in grey, p50 in green, p99 in red
+    const float levels[3] = {1000.0f / 60.0f, p50, p99};
+    const float colors[3][3] = {{0.6f, 0.6f, 0.6f}, {0.2f, 0.9f, 0.2f}, {1.0f, 0.3f, 0.2f}};
+    glLineWidth(1.0f);
+    glBegin(GL_LINES);
+    for (int i = 0; i < 3; i++)
+    {
+        float y = bottom + std::min(levels[i] * scale, height);
+        glColor4f(colors[i][0], colors[i][1], colors[i][2], 1.0f);
+        glVertex2f(left, y);
+        glVertex2f(left + width, y);
+    }
+    glEnd();
+
+    glPopMatrix();
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+    glPopAttrib();
 }
 
 void initGL(int windowWidth, int windowHeight)
@@ -239,4 +467,41 @@ void initGL(int windowWidth, int windowHeight)
     glLoadIdentity();
     gluPerspective(45.0, (float)windowWidth / (float)windowHeight, 0.1, 100.0);
     glMatrixMode(GL_MODELVIEW);
+
+    buildMeshCache();
+}
+
+void buildMeshCache()
+{
+    releaseMeshCache();
+
+    // Buffer objects are core since OpenGL 1.5; keep immediate mode otherwise
+    if (!GLEW_VERSION_1_5)
+        return;
+
+    // Foot: cube of half-size LEG_RADIUS, scaled and offset as in drawFootImmediate
+    float s = LEG_RADIUS;
+    MeshData foot = buildBoxMesh(2 * s, 2 * s, 2 * s);
+    transformMesh(foot, 0, -s, 0, 1, 1, 1);
+    transformMesh(foot, 0, -LEG_RADIUS / 2, LEG_RADIUS, 1.5f, 0.5f, 2.5f);
+
+    meshes.shapes[SHAPE_TORSO] = uploadMesh(buildBoxMesh(TORSO_WIDTH, TORSO_HEIGHT, TORSO_DEPTH));
+    meshes.shapes[SHAPE_THIGH] = uploadMesh(buildCylinderMesh(LEG_RADIUS, LEG_LENGTH, 20));
+    meshes.shapes[SHAPE_SHIN] = uploadMesh(buildCylinderMesh(LEG_RADIUS * 0.9f, LEG_LENGTH, 20));
+    meshes.shapes[SHAPE_KNEE] = uploadMesh(buildSphereMesh(LEG_RADIUS * 1.2f, 20, 20));
+    meshes.shapes[SHAPE_FOOT] = uploadMesh(foot);
+    meshes.ground = uploadMesh(buildGridMesh(10));
+    meshes.ready = true;
+}
+
+void releaseMeshCache()
+{
+    releasePathCaches();
+    if (!meshes.ready)
+        return;
+
+    for (Mesh &mesh : meshes.shapes)
+        destroyMesh(mesh);
+    destroyMesh(meshes.ground);
+    meshes.ready = false;
 }
\ No newline at end of file
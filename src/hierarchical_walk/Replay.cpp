@@ -0,0 +1,227 @@
+#include "hierarchical_walk/Replay.h"
+#include "hierarchical_walk/ByteStream.h"
+#include "hierarchical_walk/FileIO.h"
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+static const char REPLAY_MAGIC[4] = {'H', 'W', 'R', 'L'};
+static const uint32_t REPLAY_VERSION = 4;
+
+namespace
+{
+
+// Speed events carry a value; reset does not
+bool eventHasValue(ReplayEventType type)
+{
+    return type != REPLAY_RESET;
+}
+
+// ============================================================================
+// HASHING
+// ============================================================================
+
+const uint64_t FNV_OFFSET = 14695981039346656037ull;
+const uint64_t FNV_PRIME = 1099511628211ull;
+
+void hashBytes(uint64_t &hash, const void *data, size_t size)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= p[i];
+        hash *= FNV_PRIME;
+    }
+}
+
+void hashFloat(uint64_t &hash, float value)
+{
+    hashBytes(hash, &value, sizeof(value));
+}
+
+} // namespace
+
+// ============================================================================
+// REPLAY LOG
+// ============================================================================
+
+ReplayLog::ReplayLog()
+    : splineType(CATMULL_ROM),
+      pathDt(0.0f),
+      stepSeconds(0.0f),
+      walkerCount(0),
+      constantSpeed(false),
+      footPlanting(false),
+      separation(false),
+      animationSpeed(0.0f),
+      walkSpeed(0.0f),
+      lateralSpread(0.0f),
+      speedSpread(0.0f),
+      tickCount(0),
+      stateHash(0)
+{
+}
+
+void ReplayLog::record(uint64_t tick, ReplayEventType type, float value)
+{
+    ReplayEvent event;
+    event.tick = tick;
+    event.type = type;
+    event.value = eventHasValue(type) ? value : 0.0f;
+    events.push_back(event);
+}
+
+bool ReplayLog::save(const char *filename) const
+{
+    ByteWriter out;
+    out.put(REPLAY_MAGIC, sizeof(REPLAY_MAGIC));
+    out.putU32(REPLAY_VERSION);
+    out.putU8((uint8_t)splineType);
+    out.putU8(constantSpeed ? 1 : 0);
+    out.putU8(footPlanting ? 1 : 0);
+    out.putU8(separation ? 1 : 0);
+    out.putFloat(pathDt);
+    out.putFloat(stepSeconds);
+    out.putFloat(animationSpeed);
+    out.putFloat(walkSpeed);
+    out.putFloat(lateralSpread);
+    out.putFloat(speedSpread);
+    out.putU32(walkerCount);
+    out.putU32((uint32_t)controlPoints.size());
+    out.put(controlPoints.data(), controlPoints.size() * sizeof(Vec3));
+
+    out.putU32((uint32_t)events.size());
+    uint64_t previousTick = 0;
+    for (const ReplayEvent &event : events)
+    {
+        out.putVarint(event.tick - previousTick);
+        out.putU8((uint8_t)event.type);
+        if (eventHasValue(event.type))
+            out.putFloat(event.value);
+        previousTick = event.tick;
+    }
+
+    out.putU64(tickCount);
+    out.putU64(stateHash);
+
+    FILE *file = fopen(filename, "wb");
+    if (!file)
+    {
+        std::cerr << "Error: Could not write " << filename << std::endl;
+        return false;
+    }
+    bool ok = fwrite(out.bytes.data(), 1, out.bytes.size(), file) == out.bytes.size();
+    ok = fclose(file) == 0 && ok;
+    if (!ok)
+        std::cerr << "Error: Failed writing " << filename << std::endl;
+    return ok;
+}
+
+bool ReplayLog::load(const char *filename)
+{
+    MappedFile file;
+    if (!file.open(filename))
+    {
+        std::cerr << "Error: Could not open " << filename << std::endl;
+        return false;
+    }
+
+    ByteReader in(file.data(), file.size());
+    char magic[4];
+    in.get(magic, sizeof(magic));
+    if (!in.ok || memcmp(magic, REPLAY_MAGIC, sizeof(magic)) != 0)
+    {
+        std::cerr << "Error: " << filename << " is not a replay log" << std::endl;
+        return false;
+    }
+    uint32_t version = in.getU32();
+    if (version != REPLAY_VERSION)
+    {
+        std::cerr << "Error: " << filename << " has unsupported version " << version << std::endl;
+        return false;
+    }
+
+    uint8_t spline = in.getU8();
+    if (spline >= SPLINE_TYPE_COUNT)
+        in.ok = false;
+    splineType = (SplineType)spline;
+    constantSpeed = in.getU8() != 0;
+    footPlanting = in.getU8() != 0;
+    separation = in.getU8() != 0;
+    pathDt = in.getFloat();
+    stepSeconds = in.getFloat();
+    animationSpeed = in.getFloat();
+    walkSpeed = in.getFloat();
+    lateralSpread = in.getFloat();
+    speedSpread = in.getFloat();
+    walkerCount = in.getU32();
+
+    uint32_t pointCount = in.getU32();
+    if (pointCount > in.remaining() / sizeof(Vec3))
+        in.ok = false;
+    else
+    {
+        controlPoints.resize(pointCount);
+        in.get(controlPoints.data(), pointCount * sizeof(Vec3));
+    }
+
+    // Each event takes at least two bytes
+    uint32_t eventCount = in.getU32();
+    if (eventCount > in.remaining() / 2)
+        in.ok = false;
+    events.clear();
+    events.reserve(in.ok ? eventCount : 0);
+
+    uint64_t tick = 0;
+    for (uint32_t i = 0; i < eventCount && in.ok; i++)
+    {
+        ReplayEvent event;
+        tick += in.getVarint();
+        event.tick = tick;
+        uint8_t type = in.getU8();
+        if (type > REPLAY_CONSTANT_SPEED)
+            in.ok = false;
+        event.type = (ReplayEventType)type;
+        event.value = eventHasValue(event.type) ? in.getFloat() : 0.0f;
+        events.push_back(event);
+    }
+
+    tickCount = in.getU64();
+    stateHash = in.getU64();
+
+    if (!in.ok || walkerCount == 0 || stepSeconds <= 0.0f)
+    {
+        std::cerr << "Error: " << filename << " is truncated or corrupt" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+uint64_t hashWalkers(const std::vector<ArticulatedFigure> &figures, const std::vector<AnimationState> &states)
+{
+    uint64_t hash = FNV_OFFSET;
+    for (const ArticulatedFigure &figure : figures)
+    {
+        hashFloat(hash, figure.position.x);
+        hashFloat(hash, figure.position.y);
+        hashFloat(hash, figure.position.z);
+        hashFloat(hash, figure.forward.x);
+        hashFloat(hash, figure.forward.y);
+        hashFloat(hash, figure.forward.z);
+        hashFloat(hash, figure.bodyTilt);
+        hashFloat(hash, figure.leftHipAngle);
+        hashFloat(hash, figure.rightHipAngle);
+        hashFloat(hash, figure.leftKneeAngle);
+        hashFloat(hash, figure.rightKneeAngle);
+    }
+    for (const AnimationState &state : states)
+    {
+        hashFloat(hash, state.t);
+        hashFloat(hash, state.dt);
+        hashFloat(hash, state.walkCycle);
+        hashFloat(hash, state.walkSpeed);
+        hashFloat(hash, state.animationSpeed);
+        hashFloat(hash, state.distance);
+    }
+    return hash;
+}
@@ -0,0 +1,139 @@
+#include "hierarchical_walk/Simulation.h"
+#include <chrono>
+
+SimulationStats::SimulationStats()
+    : walkerCount(0),
+      stepCount(0),
+      totalSeconds(0.0),
+      minStepSeconds(0.0),
+      maxStepSeconds(0.0)
+{
+}
+
+void SimulationStats::recordStep(double seconds)
+{
+    totalSeconds += seconds;
+    if (stepCount == 0 || seconds < minStepSeconds)
+        minStepSeconds = seconds;
+    if (stepCount == 0 || seconds > maxStepSeconds)
+        maxStepSeconds = seconds;
+    stepCount++;
+}
+
+double SimulationStats::stepsPerSecond() const
+{
+    return totalSeconds > 0.0 ? stepCount / totalSeconds : 0.0;
+}
+
+double SimulationStats::walkerUpdatesPerSecond() const
+{
+    return stepsPerSecond() * walkerCount;
+}
+
+HeadlessSimulation::HeadlessSimulation(const PathRegistry &paths)
+    : pathRegistry(paths),
+      jobSystem(nullptr),
+      jobChunkSize(DEFAULT_JOB_CHUNK_SIZE),
+      footPlanting(false),
+      separating(false)
+{
+}
+
+void HeadlessSimulation::setJobSystem(JobSystem *jobs, size_t chunkSize)
+{
+    jobSystem = jobs;
+    jobChunkSize = chunkSize;
+}
+
+void HeadlessSimulation::addWalker(const WalkerPath &path, float phase)
+{
+    Walker walker;
+    walker.path = path;
+    placeOnPath(walker.figure, walker.state, path, pathRegistry, phase);
+
+    walkerList.push_back(walker);
+}
+
+void HeadlessSimulation::forEachChunk(const std::function<void(size_t, size_t)> &body)
+{
+    if (jobSystem)
+        jobSystem->parallelFor(walkerList.size(), jobChunkSize, body);
+    else
+        body(0, walkerList.size());
+}
+
+void HeadlessSimulation::step(float fixedDeltaTime)
+{
+    forEachChunk([&](size_t begin, size_t end)
+    {
+        stepRange(fixedDeltaTime, begin, end);
+    });
+    if (!separating)
+        return;
+
+    // Separation needs every walker's new path point before any can move
+    pathPositions.resize(walkerList.size());
+    for (size_t i = 0; i < walkerList.size(); i++)
+        pathPositions[i] = walkerList[i].figure.position;
+    crowdSeparation.update(pathPositions, fixedDeltaTime, jobSystem, jobChunkSize);
+
+    forEachChunk([&](size_t begin, size_t end)
+    {
+        placeRange(begin, end);
+    });
+}
+
+void HeadlessSimulation::stepRange(float fixedDeltaTime, size_t begin, size_t end)
+{
+    bool offsets = separating && crowdSeparation.size() == walkerList.size();
+    for (size_t i = begin; i < end; i++)
+    {
+        Walker &walker = walkerList[i];
+
+        // The gait runs on the path point, without last step's separation offset
+        if (offsets)
+            walker.figure.position = walker.figure.position - crowdSeparation.offset(i);
+
+        updateWalkingAnimation(walker.figure, walker.state, walker.path, pathRegistry, fixedDeltaTime);
+        if (footPlanting && !separating)
+            applyFootPlanting(walker.figure, walker.state, walker.feet);
+    }
+}
+
+// Move walkers off their path by their separation offset; feet are planted
+// after, where the figure actually stands
+void HeadlessSimulation::placeRange(size_t begin, size_t end)
+{
+    for (size_t i = begin; i < end; i++)
+    {
+        Walker &walker = walkerList[i];
+        walker.figure.position += crowdSeparation.offset(i);
+        if (footPlanting)
+            applyFootPlanting(walker.figure, walker.state, walker.feet);
+    }
+}
+
+double HeadlessSimulation::footSlip() const
+{
+    double slip = 0.0;
+    for (const Walker &walker : walkerList)
+        slip += walker.feet.slip;
+    return slip;
+}
+
+SimulationStats HeadlessSimulation::run(int steps, float fixedDeltaTime)
+{
+    typedef std::chrono::steady_clock Clock;
+
+    SimulationStats stats;
+    stats.walkerCount = (int)walkerList.size();
+
+    for (int i = 0; i < steps; i++)
+    {
+        Clock::time_point start = Clock::now();
+        step(fixedDeltaTime);
+        stats.recordStep(std::chrono::duration<double>(Clock::now() - start).count());
+    }
+
+    return stats;
+}
@@ -0,0 +1,123 @@
+#include "hierarchical_walk/SimulationThread.h"
+#include "hierarchical_walk/Profiler.h"
+#include <chrono>
+
+typedef std::chrono::steady_clock Clock;
+
+// Seconds on the steady clock, shared by both threads
+static double clockSeconds(Clock::time_point time)
+{
+    return std::chrono::duration<double>(time.time_since_epoch()).count();
+}
+
+PoseSnapshot::PoseSnapshot()
+    : tick(0),
+      tickTime(0.0)
+{
+}
+
+SimulationThread::SimulationThread()
+    : running(false),
+      tickInterval(1.0 / DEFAULT_TICK_RATE),
+      substepLimit(DEFAULT_MAX_SUBSTEPS)
+{
+}
+
+SimulationThread::~SimulationThread()
+{
+    stop();
+}
+
+void SimulationThread::start(double tickRate, int maxSubsteps, StepFunction step, CaptureFunction capture)
+{
+    stop();
+
+    tickInterval = 1.0 / tickRate;
+    substepLimit = maxSubsteps;
+    stepFunction = step;
+    captureFunction = capture;
+    running.store(true, std::memory_order_release);
+    thread = std::thread(&SimulationThread::run, this);
+}
+
+void SimulationThread::stop()
+{
+    running.store(false, std::memory_order_release);
+    if (thread.joinable())
+        thread.join();
+}
+
+void SimulationThread::post(std::function<void()> command)
+{
+    std::lock_guard<std::mutex> lock(commandMutex);
+    commands.push_back(command);
+}
+
+void SimulationThread::runCommands()
+{
+    std::vector<std::function<void()> > pending;
+    {
+        std::lock_guard<std::mutex> lock(commandMutex);
+        pending.swap(commands);
+    }
+    for (const std::function<void()> &command : pending)
+        command();
+}
+
+void SimulationThread::run()
+{
+    PROFILE_THREAD_NAME("simulation");
+    FixedTimestep timestep(tickInterval, substepLimit);
+    std::vector<ArticulatedFigure> lastPoses;
+    captureFunction(lastPoses);
+
+    uint64_t tickCount = 0;
+    Clock::time_point last = Clock::now();
+    while (running.load(std::memory_order_acquire))
+    {
+        // Wake when the accumulator reaches the next whole step
+        double untilStep = tickInterval - timestep.remainder();
+        std::this_thread::sleep_until(last + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(untilStep)));
+
+        Clock::time_point now = Clock::now();
+        int steps = timestep.advance(std::chrono::duration<double>(now - last).count());
+        last = now;
+
+        for (int i = 0; i < steps; i++)
+        {
+            runCommands();
+            stepFunction(timestep.stepSeconds());
+            tickCount++;
+
+            // Once every slot has grown to the crowd size, copying in does not allocate
+            PoseSnapshot &snapshot = snapshots.back();
+            snapshot.previous = lastPoses;
+            captureFunction(snapshot.current);
+            snapshot.tick = tickCount;
+            snapshot.tickTime = clockSeconds(now) - timestep.remainder() - (steps - 1 - i) * tickInterval;
+            lastPoses = snapshot.current;
+            snapshots.publish();
+        }
+    }
+
+    // Commands posted after the last tick still take effect
+    runCommands();
+}
+
+bool SimulationThread::interpolatedPoses(std::vector<ArticulatedFigure> &poses)
+{
+    snapshots.acquire();
+    const PoseSnapshot &snapshot = snapshots.front();
+    if (snapshot.tick == 0)
+        return false;
+
+    // Blend over the tick that follows the newest one
+    float alpha = (float)((clockSeconds(Clock::now()) - snapshot.tickTime) / tickInterval);
+    if (alpha < 0.0f)
+        alpha = 0.0f;
+    if (alpha > 1.0f)
+        alpha = 1.0f;
+
+    interpolateFigures(snapshot.previous, snapshot.current, alpha, poses);
+    return true;
+}
@@ -0,0 +1,53 @@
+#include "hierarchical_walk/Skeleton.h"
+#include "hierarchical_walk/Quat.h"
+
+// ============================================================================
+// SKELETON
+// ============================================================================
+
+int Skeleton::addJoint(const std::string &name, int parent, const Vec3 &offset, const Vec3 &axis)
+{
+    // Parents must come first, which keeps the arrays in evaluation order
+    if (parent < -1 || parent >= jointCount())
+        return -1;
+
+    parents.push_back(parent);
+    offsets.push_back(offset);
+    axes.push_back(axis);
+    names.push_back(name);
+    return jointCount() - 1;
+}
+
+int Skeleton::findJoint(const std::string &name) const
+{
+    for (int i = 0; i < jointCount(); i++)
+    {
+        if (names[i] == name)
+            return i;
+    }
+    return -1;
+}
+
+void Skeleton::computeLocalTransforms(const float *angles, Mat4 *local) const
+{
+    for (int i = 0; i < jointCount(); i++)
+    {
+        local[i] = rigidTransform(Quat::fromAxisAngle(axes[i], angles[i]), offsets[i]);
+    }
+}
+
+void Skeleton::computeWorldTransforms(const Mat4 &root, const Mat4 *local, Mat4 *world) const
+{
+    for (int i = 0; i < jointCount(); i++)
+    {
+        int p = parents[i];
+        world[i] = (p < 0 ? root : world[p]) * local[i];
+    }
+}
+
+SkeletonPart::SkeletonPart(int joint, int shape, const Mat4 &placement)
+    : joint(joint),
+      shape(shape),
+      placement(placement)
+{
+}
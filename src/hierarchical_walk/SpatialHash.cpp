@@ -0,0 +1,44 @@
+#include "hierarchical_walk/SpatialHash.h"
+
+SpatialHash::SpatialHash()
+    : cell(1.0f),
+      inverseCell(1.0f),
+      slotMask(0)
+{
+}
+
+void SpatialHash::build(const std::vector<Vec3> &points, float cellSize)
+{
+    cell = cellSize;
+    inverseCell = 1.0f / cellSize;
+
+    // At least twice as many slots as points keeps most slots to one cell
+    size_t slotCount = 1;
+    while (slotCount < 2 * points.size())
+        slotCount <<= 1;
+    slotMask = slotCount - 1;
+
+    // Counting sort: count per slot, prefix sum into start offsets, scatter
+    pointCell.resize(points.size());
+    pointSlot.resize(points.size());
+    slotStart.assign(slotCount + 1, 0);
+    for (size_t i = 0; i < points.size(); i++)
+    {
+        pointCell[i] = std::make_pair(cellCoordinate(points[i].x), cellCoordinate(points[i].z));
+        pointSlot[i] = (uint32_t)slotOf(pointCell[i].first, pointCell[i].second);
+        slotStart[pointSlot[i] + 1]++;
+    }
+    for (size_t s = 0; s < slotCount; s++)
+        slotStart[s + 1] += slotStart[s];
+
+    sorted.resize(points.size());
+    slotFill.assign(slotStart.begin(), slotStart.end() - 1);
+    for (size_t i = 0; i < points.size(); i++)
+    {
+        Entry &entry = sorted[slotFill[pointSlot[i]]++];
+        entry.point = points[i];
+        entry.cellX = pointCell[i].first;
+        entry.cellZ = pointCell[i].second;
+        entry.index = (uint32_t)i;
+    }
+}
@@ -0,0 +1,177 @@
+#include "hierarchical_walk/SplineBatch.h"
+#include <cstdint>
+#include <vector>
+
+// Write Lanes::width results from lanes back to arrays of Vec3
+template <typename Lanes>
+static void storeVectors(const Lanes *lanes, Vec3 *out)
+{
+    const int W = Lanes::width;
+    float values[3][W];
+    for (int axis = 0; axis < 3; axis++)
+        lanes[axis].store(values[axis]);
+    for (int j = 0; j < W; j++)
+        out[j] = Vec3(values[0][j], values[1][j], values[2][j]);
+}
+
+// Normalized derivative, as in Vec3::normalize
+template <typename Lanes>
+static void storeTangents(const Lanes *derivative, Vec3 *tangents)
+{
+    const Lanes zero = Lanes::set(0.0f);
+    Lanes dx = derivative[0];
+    Lanes dy = derivative[1];
+    Lanes dz = derivative[2];
+    Lanes len = sqrtLanes(dx * dx + dy * dy + dz * dz);
+
+    Lanes tangent[3] = {selectGreater(len, zero, dx / len, zero),
+                        selectGreater(len, zero, dy / len, zero),
+                        selectGreater(len, zero, dz / len, zero)};
+    storeVectors(tangent, tangents);
+}
+
+// Evaluate parameters [i, i + Lanes::width)
+template <typename Lanes>
+static void evaluateBatchLanes(const CompiledSpline &path, const float *t, size_t i, Vec3 *positions, Vec3 *tangents)
+{
+    Lanes position[3], derivative[3];
+    evaluateSplineLanes(path, t + i, position, tangents ? derivative : nullptr);
+    if (positions)
+        storeVectors(position, positions + i);
+    if (tangents)
+        storeTangents(derivative, tangents + i);
+}
+
+// Parameters bucketed by segment; kept per thread so batches reuse the storage
+struct SegmentBuckets
+{
+    std::vector<uint32_t> ends;  // Counts, then starts, then one past each bucket
+    std::vector<int> segments;   // Segment of each parameter
+    std::vector<float> local;    // Local parameter of each parameter
+    std::vector<uint32_t> order; // Parameter in each slot
+    std::vector<float> u;        // Local parameter in each slot
+};
+
+// Evaluate slots [i, i + Lanes::width) of one segment's bucket and put the
+// results back where their parameters were
+template <typename Lanes>
+static void evaluateBucketLanes(
+    const Lanes coefficients[4][3],
+    const SegmentBuckets &buckets,
+    size_t i,
+    Vec3 *positions,
+    Vec3 *tangents)
+{
+    const int W = Lanes::width;
+    Lanes position[3], derivative[3];
+    Vec3 values[W];
+    evaluatePolynomialLanes(coefficients, Lanes::load(&buckets.u[i]), position, tangents ? derivative : nullptr);
+    if (positions)
+    {
+        storeVectors(position, values);
+        for (int j = 0; j < W; j++)
+            positions[buckets.order[i + j]] = values[j];
+    }
+    if (tangents)
+    {
+        storeTangents(derivative, values);
+        for (int j = 0; j < W; j++)
+            tangents[buckets.order[i + j]] = values[j];
+    }
+}
+
+void evaluateSplineBatch(const CompiledSpline &path, const float *t, size_t count, Vec3 *positions, Vec3 *tangents)
+{
+    if (!path.isValid())
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            if (positions)
+                positions[i] = Vec3(0, 0, 0);
+            if (tangents)
+                tangents[i] = Vec3(0, 0, 0);
+        }
+        return;
+    }
+
+    // With fewer parameters than a SIMD block per segment, buckets would be
+    // mostly remainders; take the parameters in order, full SIMD blocks then
+    // the rest one at a time
+    size_t segmentCount = (size_t)path.segmentCount();
+    if (count < segmentCount * SimdLanes::width)
+    {
+        size_t i = 0;
+        for (; i + SimdLanes::width <= count; i += SimdLanes::width)
+            evaluateBatchLanes<SimdLanes>(path, t, i, positions, tangents);
+        for (; i < count; i++)
+            evaluateBatchLanes<ScalarLanes>(path, t, i, positions, tangents);
+        return;
+    }
+
+    // Counting sort by segment. It is stable, so sorted parameters keep
+    // their order and their results are written back in sequence.
+    static thread_local SegmentBuckets buckets;
+    buckets.ends.assign(segmentCount + 1, 0);
+    buckets.segments.resize(count);
+    buckets.local.resize(count);
+    buckets.order.resize(count);
+    buckets.u.resize(count);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        path.locate(t[i], buckets.segments[i], buckets.local[i]);
+        buckets.ends[buckets.segments[i] + 1]++;
+    }
+    for (size_t segment = 0; segment < segmentCount; segment++)
+        buckets.ends[segment + 1] += buckets.ends[segment];
+    for (size_t i = 0; i < count; i++)
+    {
+        uint32_t slot = buckets.ends[buckets.segments[i]]++;
+        buckets.order[slot] = (uint32_t)i;
+        buckets.u[slot] = buckets.local[i];
+    }
+
+    // Each bucket with its segment's coefficients in every lane
+    SimdLanes wide[4][3];
+    ScalarLanes narrow[4][3];
+    size_t begin = 0;
+    for (size_t segment = 0; segment < segmentCount; segment++)
+    {
+        size_t end = buckets.ends[segment];
+        if (begin == end)
+            continue;
+        broadcastSegment(path.segment((int)segment), wide);
+        broadcastSegment(path.segment((int)segment), narrow);
+
+        size_t i = begin;
+        for (; i + SimdLanes::width <= end; i += SimdLanes::width)
+            evaluateBucketLanes(wide, buckets, i, positions, tangents);
+        for (; i < end; i++)
+            evaluateBucketLanes(narrow, buckets, i, positions, tangents);
+        begin = end;
+    }
+}
+
+// Evaluate local parameters [i, i + Lanes::width) of one segment
+template <typename Lanes>
+static void evaluateSegmentLanes(const Lanes coefficients[4][3], const float *u, size_t i, Vec3 *positions)
+{
+    Lanes position[3];
+    evaluatePolynomialLanes(coefficients, Lanes::load(u + i), position, (Lanes *)nullptr);
+    storeVectors(position, positions + i);
+}
+
+void evaluateSegmentBatch(const CompiledSpline &path, int segment, const float *u, size_t count, Vec3 *positions)
+{
+    const SplineSegment &s = path.segment(segment);
+    SimdLanes wide[4][3];
+    ScalarLanes narrow[4][3];
+    broadcastSegment(s, wide);
+    broadcastSegment(s, narrow);
+
+    size_t i = 0;
+    for (; i + SimdLanes::width <= count; i += SimdLanes::width)
+        evaluateSegmentLanes(wide, u, i, positions);
+    for (; i < count; i++)
+        evaluateSegmentLanes(narrow, u, i, positions);
+}
@@ -0,0 +1,324 @@
+#include "hierarchical_walk/StreamingPath.h"
+#include "hierarchical_walk/Constants.h"
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+// How long the reader waits on a quiet source before checking for close()
+static const int STOP_POLL_MS = 100;
+
+static bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+}
+
+StreamCursor::StreamCursor()
+    : segment(0),
+      u(0.0f)
+{
+}
+
+StreamingPath::StreamingPath(size_t windowSegments)
+    : mask(0),
+      produced(0),
+      released(0),
+      pointCount(0),
+      ended(false),
+      stopping(false),
+      file(nullptr),
+      ownsFile(false),
+      headerLines(0),
+      splineType(CATMULL_ROM),
+      pathDt(DEFAULT_DT)
+{
+    // A power of two, so the slot of a segment is a mask away
+    size_t slots = 4;
+    while (slots < windowSegments)
+        slots <<= 1;
+    ring.resize(slots);
+    mask = slots - 1;
+}
+
+StreamingPath::~StreamingPath()
+{
+    close();
+}
+
+bool StreamingPath::open(const char *source)
+{
+    close();
+    if (strcmp(source, "-") == 0)
+    {
+        file = stdin;
+        ownsFile = false;
+    }
+    else
+    {
+        file = fopen(source, "rb");
+        ownsFile = true;
+        if (!file)
+        {
+            std::cerr << "Error: Could not open " << source << std::endl;
+            return false;
+        }
+    }
+
+    produced.store(0);
+    released.store(0);
+    pointCount.store(0);
+    ended.store(false);
+    stopping.store(false);
+    pending.clear();
+    headerLines = 0;
+    splineType = CATMULL_ROM;
+    pathDt = DEFAULT_DT;
+    reader = std::thread(&StreamingPath::readLoop, this);
+    return true;
+}
+
+void StreamingPath::close()
+{
+    if (reader.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(waitMutex);
+            stopping.store(true);
+        }
+        changed.notify_all();
+        reader.join();
+    }
+    if (file && ownsFile)
+        fclose(file);
+    file = nullptr;
+}
+
+void StreamingPath::waitFor(uint64_t count)
+{
+    std::unique_lock<std::mutex> lock(waitMutex);
+    changed.wait(lock, [&]()
+    {
+        return available() >= count || finished();
+    });
+}
+
+void StreamingPath::release(uint64_t segment)
+{
+    uint64_t limit = available();
+    if (segment > limit)
+        segment = limit;
+    if (segment <= released.load(std::memory_order_relaxed))
+        return;
+
+    // Under the lock, so a reader about to wait for a slot cannot miss it
+    {
+        std::lock_guard<std::mutex> lock(waitMutex);
+        released.store(segment, std::memory_order_release);
+    }
+    changed.notify_all();
+}
+
+Vec3 StreamingPath::evaluate(uint64_t segment, float u) const
+{
+    return evaluatePolynomial(slot(segment), u);
+}
+
+SplineSample StreamingPath::sample(uint64_t segment, float u) const
+{
+    const SplineSegment &s = slot(segment);
+    Vec3 d1 = polynomialDerivative(s, u);
+    Vec3 d2 = polynomialSecondDerivative(s, u);
+
+    SplineSample result;
+    result.position = evaluatePolynomial(s, u);
+    result.tangent = d1.normalize();
+    result.firstDerivative = d1;
+    result.secondDerivative = d2;
+    result.curvature = 0.0f;
+
+    // |p' x p''| / |p'|^3, independent of the parameter scale
+    float speed = d1.length();
+    if (speed > 0.0f)
+    {
+        Vec3 cross(d1.y * d2.z - d1.z * d2.y,
+                   d1.z * d2.x - d1.x * d2.z,
+                   d1.x * d2.y - d1.y * d2.x);
+        result.curvature = cross.length() / (speed * speed * speed);
+    }
+    return result;
+}
+
+size_t StreamingPath::memoryBytes() const
+{
+    return ring.capacity() * sizeof(SplineSegment) + STREAM_CHUNK_BYTES;
+}
+
+void StreamingPath::readLoop()
+{
+    std::vector<char> buffer(STREAM_CHUNK_BYTES);
+#ifdef _WIN32
+    int fd = _fileno(file);
+#else
+    int fd = fileno(file);
+#endif
+
+    bool reading = true;
+    while (reading && !stopping.load(std::memory_order_acquire))
+    {
+#ifdef _WIN32
+        int bytes = _read(fd, buffer.data(), (unsigned)buffer.size());
+#else
+        // Wait for input a little at a time, so a quiet pipe does not hold up close()
+        pollfd request = {fd, POLLIN, 0};
+        int ready = poll(&request, 1, STOP_POLL_MS);
+        if (ready == 0 || (ready < 0 && errno == EINTR))
+            continue;
+        ssize_t bytes = ready < 0 ? -1 : read(fd, buffer.data(), buffer.size());
+        if (bytes < 0 && errno == EINTR)
+            continue;
+#endif
+        if (bytes <= 0)
+        {
+            parsePending(true);
+            break;
+        }
+        pending.append(buffer.data(), (size_t)bytes);
+        reading = parsePending(false);
+
+        // Wake anyone waiting for the segments of this chunk
+        {
+            std::lock_guard<std::mutex> lock(waitMutex);
+        }
+        changed.notify_all();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(waitMutex);
+        ended.store(true, std::memory_order_release);
+    }
+    changed.notify_all();
+}
+
+bool StreamingPath::parsePending(bool atEnd)
+{
+    const char *begin = pending.data();
+    const char *p = begin;
+    const char *end = begin + pending.size();
+
+    // Header: the spline type line, then the dt line. Each is used only once complete.
+    while (headerLines < 2)
+    {
+        const char *lineEnd = (const char *)memchr(p, '\n', end - p);
+        if (!lineEnd && !atEnd)
+            break;
+        if (!lineEnd)
+            lineEnd = end;
+
+        if (headerLines == 0)
+        {
+            parseSplineType(p, lineEnd, splineType);
+        }
+        else
+        {
+            const char *q = p;
+            while (q < lineEnd && isSpace(*q))
+                q++;
+            float dt;
+            if (std::from_chars(q, lineEnd, dt).ec == std::errc())
+                pathDt = dt;
+        }
+        headerLines++;
+        p = lineEnd < end ? lineEnd + 1 : end;
+    }
+
+    // A number cut off at the end of the chunk is finished by the next one,
+    // so only text up to the last whitespace is parsed before the end
+    const char *limit = end;
+    if (!atEnd)
+    {
+        while (limit > p && !isSpace(limit[-1]))
+            limit--;
+    }
+
+    bool more = true;
+    while (headerLines == 2)
+    {
+        // Parse all three coordinates before taking any of them
+        const char *q = p;
+        float xyz[3];
+        int parsed = 0;
+        for (; parsed < 3; parsed++)
+        {
+            while (q < limit && isSpace(*q))
+                q++;
+            if (q < limit && *q == '+')
+                q++;
+            std::from_chars_result result = std::from_chars(q, limit, xyz[parsed]);
+            if (result.ec != std::errc())
+                break;
+            q = result.ptr;
+        }
+        if (parsed < 3)
+        {
+            // Text that is not a number ends the path, as it does in a file
+            while (q < limit && isSpace(*q))
+                q++;
+            if (q < limit || atEnd)
+                more = false;
+            break;
+        }
+
+        p = q;
+        if (!addPoint(Vec3(xyz[0], xyz[1], xyz[2])))
+        {
+            more = false;
+            break;
+        }
+    }
+
+    pending.erase(0, p - begin);
+    return more;
+}
+
+bool StreamingPath::addPoint(const Vec3 &point)
+{
+    uint64_t count = pointCount.load(std::memory_order_relaxed);
+    if (count < 3)
+    {
+        history[count] = point;
+        pointCount.store(count + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Segment count - 3 goes where the walkers gave up segment count - 3 - window
+    uint64_t segment = count - 3;
+    if (segment - released.load(std::memory_order_acquire) >= ring.size())
+    {
+        // Publish what is done before sleeping, so the walkers can reach the slot to free
+        std::unique_lock<std::mutex> lock(waitMutex);
+        changed.notify_all();
+        changed.wait(lock, [&]()
+        {
+            return stopping.load(std::memory_order_acquire) ||
+                   segment - released.load(std::memory_order_acquire) < ring.size();
+        });
+        if (stopping.load(std::memory_order_acquire))
+            return false;
+    }
+
+    ring[segment & mask] = compileSegment(history[0], history[1], history[2], point, splineType);
+    produced.store(segment + 1, std::memory_order_release);
+
+    history[0] = history[1];
+    history[1] = history[2];
+    history[2] = point;
+    pointCount.store(count + 1, std::memory_order_relaxed);
+    return true;
+}
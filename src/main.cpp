@@ -1,15 +1,43 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 #include <GL/glu.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
 
 #include "hierarchical_walk/Constants.h"
+#include "hierarchical_walk/CrowdRenderer.h"
+#include "hierarchical_walk/CrowdSeparation.h"
+#include "hierarchical_walk/CrowdState.h"
 #include "hierarchical_walk/Vec3.h"
 #include "hierarchical_walk/ArticulatedFigure.h"
 #include "hierarchical_walk/Spline.h"
 #include "hierarchical_walk/Renderer.h"
 #include "hierarchical_walk/Animation.h"
+#include "hierarchical_walk/AnimationClip.h"
 #include "hierarchical_walk/FileIO.h"
+#include "hierarchical_walk/FixedTimestep.h"
+#include "hierarchical_walk/FootPlanting.h"
+#include "hierarchical_walk/FrameExporter.h"
+#include "hierarchical_walk/GpuTimer.h"
+#include "hierarchical_walk/JobSystem.h"
+#include "hierarchical_walk/OffscreenContext.h"
+#include "hierarchical_walk/PathRegistry.h"
+#include "hierarchical_walk/PathReloader.h"
+#include "hierarchical_walk/PathTessellation.h"
+#include "hierarchical_walk/Profiler.h"
+#include "hierarchical_walk/Replay.h"
+#include "hierarchical_walk/Simulation.h"
+#include "hierarchical_walk/SimulationThread.h"
+#include "hierarchical_walk/StreamingPath.h"
 
 // ============================================================================
 // GLOBAL STATE
@@ -19,12 +47,40 @@ GLFWwindow *window = nullptr;
 int windowWidth = DEFAULT_WINDOW_WIDTH;
 int windowHeight = DEFAULT_WINDOW_HEIGHT;
 
-ArticulatedFigure figure;
-AnimationState animState;
-std::vector<Vec3> controlPoints;
-SplineType splineType = CATMULL_ROM;
+// Walkers shown in the window; the camera follows the first one
+std::vector<ArticulatedFigure> figures(1);
+std::vector<AnimationState> animStates(1);
+bool useInstancing = true; // Draw crowds with hardware instancing when available
+PathRegistry paths; // Every loaded path, shared by the walkers on it; the first is the main one
+std::vector<WalkerPath> walkerPaths; // Path, speed and lane of each walker in figures
+std::vector<SharedPath> drawnPaths; // What the renderer draws; the simulation thread owns paths
+std::vector<std::unique_ptr<PathReloader> > pathReloaders; // Watches of the path files, by handle
+StreamingPath *streamPath = nullptr; // Followed instead of paths with --stream
+std::vector<StreamCursor> streamCursors; // Position of each walker in figures on streamPath
+std::vector<Vec3> streamPolyline; // Buffered part of the stream, for the renderer
+std::mutex streamPolylineMutex;
+bool drawingStream = false; // Keep streamPolyline up to date
+uint64_t drawnStreamFirst = 0, drawnStreamEnd = 0; // Segments streamPolyline was built from
+float lateralSpread = 0.0f; // Width of the band walkers spread over across their path
+float speedSpread = 0.0f;   // Walker speeds vary by up to this fraction either way
+bool constantSpeed = false; // Advance by distance instead of by parameter
+bool footPlanting = true; // Lock feet in stance with the IK pass
+std::vector<FootPlanting> footPlants; // Foot contacts of each walker in figures
+bool separating = true; // Push walkers that come too close off their path
+CrowdSeparation separation; // Offset of each walker in figures from its path
+std::vector<Vec3> pathPositions; // Gathered for the separation pass
+JobSystem *jobSystem = nullptr; // Worker threads for walker updates
+size_t jobChunkSize = DEFAULT_JOB_CHUNK_SIZE;
+SimulationThread simulationThread; // Steps figures/animStates at a fixed rate when running
+std::vector<ArticulatedFigure> renderFigures; // Interpolated poses drawn each frame
+uint64_t simulationTick = 0; // Fixed steps taken since start
+ReplayLog replayLog;         // Inputs of this session when recording
+bool recordingReplay = false;
 
 double lastFrameTime = 0.0;
+GpuTimer gpuTimer;         // GPU time of the draw stages
+bool showProfile = false;  // Frame-time graph and timings in the title bar
+double lastTitleUpdate = 0.0;
 
 // Camera parameters
 float cameraDistance = DEFAULT_CAMERA_DISTANCE;
@@ -34,6 +90,550 @@ double lastMouseX = 0.0, lastMouseY = 0.0;
 bool mousePressed = false;
 bool firstMouse = true;
 
+// ============================================================================
+// COMMAND LINE
+// ============================================================================
+
+struct CommandLineOptions
+{
+    const char *filename = "control_points.txt";
+    std::vector<const char *> extraPaths; // More paths to share the walkers with
+    const char *streamSource = nullptr; // Walk a path read while walking, from a file or - for stdin
+    int streamWindow = (int)DEFAULT_STREAM_WINDOW; // Segments of the stream kept in memory
+    float lateralSpread = 0.0f; // Width of the band walkers spread over across their path
+    float speedSpread = 0.0f;   // Walker speeds vary by up to this fraction either way
+    bool headless = false;   // Run the batch simulation instead of opening a window
+    int walkerCount = 1000;  // Number of walkers in headless mode
+    int stepCount = 1000;    // Number of fixed steps in headless mode
+    float stepDt = 1.0f / 60.0f; // Fixed time step in seconds
+    bool soa = false;        // Use the structure-of-arrays crowd kernel
+    bool verifySoa = false;  // Check the crowd kernel against the scalar path
+    int verifyJobs = 0;      // Back-to-back parallel loops to check, 0 for none
+    bool constantSpeed = false; // Walk at constant speed using the arc-length table
+    bool footPlanting = true; // Lock feet in stance with the IK pass
+    bool separation = true;   // Push walkers that come too close off their path
+    int crowdSize = 1;       // Number of walkers shown in the window
+    bool instancing = true;  // Draw crowds with hardware instancing
+    float pathTolerance = DEFAULT_PATH_TOLERANCE; // Max error of the drawn path
+    bool quiet = false;      // Skip per-point logging while loading
+    bool watch = true;       // Reload path files in the window when they change
+    const char *saveBinary = nullptr; // Write the loaded path in binary form and exit
+    const char *bakeClip = nullptr;   // Bake one loop of the walk into a clip file and exit
+    const char *clipFile = nullptr;   // Play walkers back from a baked clip in headless mode
+    int threads = 0;         // Threads for walker updates, 0 for every core
+    int chunkSize = (int)DEFAULT_JOB_CHUNK_SIZE; // Walkers per job chunk
+    double tickRate = DEFAULT_TICK_RATE; // Fixed simulation steps per second
+    int maxSubsteps = DEFAULT_MAX_SUBSTEPS; // Steps per frame before time is dropped
+    bool simulationThread = true; // Step on a dedicated thread
+    const char *recordFile = nullptr; // Write the session's replay log here on exit
+    const char *replayFile = nullptr; // Rerun a replay log without a window
+    const char *exportOutput = nullptr; // Render frames offscreen to this file or pipe
+    FrameFormat exportFormat = FRAME_Y4M;
+    int exportWidth = 1280;
+    int exportHeight = 720;
+    int exportFps = 30;
+    int exportFrames = 300;
+    bool profile = false;    // Start with the frame-time overlay shown
+    const char *traceFile = nullptr; // Write a Chrome trace of the session on exit
+};
+
+void printUsage(const char *program)
+{
+    std::cout << "Usage: " << program << " [options] [control_points_file]" << std::endl;
+    std::cout << "  --headless        Run the batch simulation without a window" << std::endl;
+    std::cout << "  --walkers N       Number of walkers in headless mode (default 1000)" << std::endl;
+    std::cout << "  --steps N         Number of fixed steps in headless mode (default 1000)" << std::endl;
+    std::cout << "  --step-dt SECONDS Fixed time step in headless mode (default 1/60)" << std::endl;
+    std::cout << "  --crowd N         Number of walkers shown in the window (default 1)" << std::endl;
+    std::cout << "  --no-instancing   Draw crowds without hardware instancing" << std::endl;
+    std::cout << "  --path FILE       Add another path; walkers take turns between paths (repeatable)" << std::endl;
+    std::cout << "  --stream SOURCE   Walk a path read from a file or - (stdin) as it arrives;" << std::endl;
+    std::cout << "                    its dt counts segments per second at animation speed 1" << std::endl;
+    std::cout << "  --stream-window N Segments of the stream kept in memory (default 4096)" << std::endl;
+    std::cout << "  --lateral-spread D Spread walkers over a band D wide across their path (default 0)" << std::endl;
+    std::cout << "  --speed-spread S  Vary walker speeds by up to S either way, 0 <= S < 1 (default 0)" << std::endl;
+    std::cout << "  --path-tolerance D Max distance between drawn path and curve (default 0.005)" << std::endl;
+    std::cout << "  --constant-speed  Advance walkers by distance instead of by parameter" << std::endl;
+    std::cout << "  --no-foot-ik      Keep the procedural leg angles; feet may slide in stance" << std::endl;
+    std::cout << "  --no-separation   Let walkers pass through each other" << std::endl;
+    std::cout << "  --tick-rate HZ    Fixed simulation rate in the window (default 120)" << std::endl;
+    std::cout << "  --max-substeps N  Fixed steps per frame before time is dropped (default 5)" << std::endl;
+    std::cout << "  --no-sim-thread   Run the fixed steps on the render thread" << std::endl;
+    std::cout << "  --record FILE     Save a replay log of the session on exit" << std::endl;
+    std::cout << "  --replay FILE     Rerun a replay log without a window and check the result" << std::endl;
+    std::cout << "  --export OUTPUT   Render frames offscreen to a file, %d pattern, - or |command" << std::endl;
+    std::cout << "  --export-format F Exported frame format: raw, ppm or y4m (default y4m)" << std::endl;
+    std::cout << "  --export-size WxH Exported frame size (default 1280x720)" << std::endl;
+    std::cout << "  --export-fps N    Exported frames per second of animation (default 30)" << std::endl;
+    std::cout << "  --export-frames N Number of frames to export (default 300)" << std::endl;
+    std::cout << "  --profile         Show the frame-time graph and stage timings from the start" << std::endl;
+    std::cout << "  --trace FILE      Write a Chrome trace of the window or export session on exit" << std::endl;
+    std::cout << "  --threads N       Threads for walker updates (default 0 = all cores)" << std::endl;
+    std::cout << "  --chunk N         Walkers per work chunk (default 256)" << std::endl;
+    std::cout << "  --no-watch        Do not reload path files when they change" << std::endl;
+    std::cout << "  --quiet           Do not log every control point while loading" << std::endl;
+    std::cout << "  --save-binary FILE Write the loaded path as a binary path file and exit" << std::endl;
+    std::cout << "  --bake-clip FILE  Bake one loop of the walk into an animation clip and exit" << std::endl;
+    std::cout << "  --clip FILE       Play headless walkers back from a baked clip" << std::endl;
+    std::cout << "  --soa             Use the vectorized structure-of-arrays crowd update" << std::endl;
+    std::cout << "  --verify-soa      Compare the crowd update bit-for-bit with the scalar path" << std::endl;
+    std::cout << "  --verify-jobs N   Run N back-to-back parallel loops and check every item ran once" << std::endl;
+}
+
+bool parseCommandLine(int argc, char **argv, CommandLineOptions &options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (strcmp(arg, "--headless") == 0)
+            options.headless = true;
+        else if (strcmp(arg, "--walkers") == 0 && hasValue)
+            options.walkerCount = atoi(argv[++i]);
+        else if (strcmp(arg, "--steps") == 0 && hasValue)
+            options.stepCount = atoi(argv[++i]);
+        else if (strcmp(arg, "--step-dt") == 0 && hasValue)
+            options.stepDt = (float)atof(argv[++i]);
+        else if (strcmp(arg, "--crowd") == 0 && hasValue)
+            options.crowdSize = atoi(argv[++i]);
+        else if (strcmp(arg, "--path") == 0 && hasValue)
+            options.extraPaths.push_back(argv[++i]);
+        else if (strcmp(arg, "--stream") == 0 && hasValue)
+            options.streamSource = argv[++i];
+        else if (strcmp(arg, "--stream-window") == 0 && hasValue)
+            options.streamWindow = atoi(argv[++i]);
+        else if (strcmp(arg, "--lateral-spread") == 0 && hasValue)
+            options.lateralSpread = (float)atof(argv[++i]);
+        else if (strcmp(arg, "--speed-spread") == 0 && hasValue)
+            options.speedSpread = (float)atof(argv[++i]);
+        else if (strcmp(arg, "--path-tolerance") == 0 && hasValue)
+            options.pathTolerance = (float)atof(argv[++i]);
+        else if (strcmp(arg, "--tick-rate") == 0 && hasValue)
+            options.tickRate = atof(argv[++i]);
+        else if (strcmp(arg, "--max-substeps") == 0 && hasValue)
+            options.maxSubsteps = atoi(argv[++i]);
+        else if (strcmp(arg, "--no-sim-thread") == 0)
+            options.simulationThread = false;
+        else if (strcmp(arg, "--record") == 0 && hasValue)
+            options.recordFile = argv[++i];
+        else if (strcmp(arg, "--replay") == 0 && hasValue)
+            options.replayFile = argv[++i];
+        else if (strcmp(arg, "--export") == 0 && hasValue)
+            options.exportOutput = argv[++i];
+        else if (strcmp(arg, "--export-format") == 0 && hasValue)
+        {
+            if (!parseFrameFormat(argv[++i], options.exportFormat))
+            {
+                std::cerr << "Unknown export format: " << argv[i] << std::endl;
+                return false;
+            }
+        }
+        else if (strcmp(arg, "--export-size") == 0 && hasValue)
+        {
+            if (sscanf(argv[++i], "%dx%d", &options.exportWidth, &options.exportHeight) != 2)
+            {
+                std::cerr << "Export size must look like 1280x720" << std::endl;
+                return false;
+            }
+        }
+        else if (strcmp(arg, "--export-fps") == 0 && hasValue)
+            options.exportFps = atoi(argv[++i]);
+        else if (strcmp(arg, "--export-frames") == 0 && hasValue)
+            options.exportFrames = atoi(argv[++i]);
+        else if (strcmp(arg, "--profile") == 0)
+            options.profile = true;
+        else if (strcmp(arg, "--trace") == 0 && hasValue)
+            options.traceFile = argv[++i];
+        else if (strcmp(arg, "--threads") == 0 && hasValue)
+            options.threads = atoi(argv[++i]);
+        else if (strcmp(arg, "--chunk") == 0 && hasValue)
+            options.chunkSize = atoi(argv[++i]);
+        else if (strcmp(arg, "--save-binary") == 0 && hasValue)
+            options.saveBinary = argv[++i];
+        else if (strcmp(arg, "--bake-clip") == 0 && hasValue)
+            options.bakeClip = argv[++i];
+        else if (strcmp(arg, "--clip") == 0 && hasValue)
+            options.clipFile = argv[++i];
+        else if (strcmp(arg, "--quiet") == 0)
+            options.quiet = true;
+        else if (strcmp(arg, "--no-watch") == 0)
+            options.watch = false;
+        else if (strcmp(arg, "--no-instancing") == 0)
+            options.instancing = false;
+        else if (strcmp(arg, "--constant-speed") == 0)
+            options.constantSpeed = true;
+        else if (strcmp(arg, "--no-foot-ik") == 0)
+            options.footPlanting = false;
+        else if (strcmp(arg, "--no-separation") == 0)
+            options.separation = false;
+        else if (strcmp(arg, "--soa") == 0)
+            options.soa = true;
+        else if (strcmp(arg, "--verify-soa") == 0)
+            options.verifySoa = true;
+        else if (strcmp(arg, "--verify-jobs") == 0 && hasValue)
+            options.verifyJobs = atoi(argv[++i]);
+        else if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0)
+            return false;
+        else if (arg[0] == '-' && arg[1] == '-')
+        {
+            std::cerr << "Unknown or incomplete option: " << arg << std::endl;
+            return false;
+        }
+        else
+            options.filename = arg;
+    }
+
+    if (options.walkerCount < 1 || options.stepCount < 1 || options.stepDt <= 0.0f || options.crowdSize < 1)
+    {
+        std::cerr << "Walker count, crowd size, step count and step dt must be positive" << std::endl;
+        return false;
+    }
+    if (options.tickRate <= 0.0 || options.maxSubsteps < 1)
+    {
+        std::cerr << "Tick rate and max substeps must be positive" << std::endl;
+        return false;
+    }
+    if (options.exportWidth < 1 || options.exportHeight < 1 || options.exportFps < 1 || options.exportFrames < 1)
+    {
+        std::cerr << "Export size, frame rate and frame count must be positive" << std::endl;
+        return false;
+    }
+    if (options.threads < 0 || options.chunkSize < 1)
+    {
+        std::cerr << "Thread count must not be negative and chunk size must be positive" << std::endl;
+        return false;
+    }
+    if (options.clipFile && (options.soa || options.verifySoa))
+    {
+        std::cerr << "Clip playback and the crowd kernel are separate headless modes" << std::endl;
+        return false;
+    }
+    if (options.constantSpeed && (options.soa || options.verifySoa))
+    {
+        std::cerr << "The crowd kernel only supports parameter-based walking" << std::endl;
+        return false;
+    }
+    if (options.lateralSpread < 0.0f || options.speedSpread < 0.0f || options.speedSpread >= 1.0f)
+    {
+        std::cerr << "Lateral spread must not be negative and speed spread must be in [0, 1)" << std::endl;
+        return false;
+    }
+    bool varied = !options.extraPaths.empty() || options.lateralSpread > 0.0f || options.speedSpread > 0.0f;
+    if (varied && (options.soa || options.verifySoa))
+    {
+        std::cerr << "The crowd kernel only supports one path without speed or lateral spread" << std::endl;
+        return false;
+    }
+    if (!options.extraPaths.empty() && options.recordFile)
+    {
+        std::cerr << "Replay logs hold a single path; --record cannot be combined with --path" << std::endl;
+        return false;
+    }
+    if (options.streamWindow < 4)
+    {
+        std::cerr << "Stream window must be at least 4 segments" << std::endl;
+        return false;
+    }
+    bool needsWholePath = options.soa || options.verifySoa || options.clipFile || options.bakeClip ||
+                          options.recordFile || options.replayFile || options.saveBinary || options.constantSpeed;
+    if (options.streamSource && (varied || needsWholePath))
+    {
+        std::cerr << "A stream is walked by parameter along one path; --stream cannot be combined with"
+                  << " --path, spreads, --constant-speed, clips, the crowd kernel, replays or --save-binary" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// ============================================================================
+// WALKERS
+// ============================================================================
+
+void setAnimationSpeed(float speed)
+{
+    if (speed < 0.01f)
+        speed = 0.01f;
+    for (AnimationState &state : animStates)
+        state.animationSpeed = speed;
+}
+
+void setWalkSpeed(float speed)
+{
+    if (speed < 0.1f)
+        speed = 0.1f;
+    for (AnimationState &state : animStates)
+        state.walkSpeed = speed;
+}
+
+// Path, speed and lane of walker index. Walkers take turns between the
+// paths; speeds and lanes follow low-discrepancy sequences, so they cover
+// their range evenly and every run gets the same ones.
+WalkerPath walkerPathFor(size_t index)
+{
+    WalkerPath walker((PathHandle)(index % paths.size()));
+    walker.constantSpeed = constantSpeed;
+    double lane = std::fmod(index * 0.6180339887498949, 1.0);
+    double speed = std::fmod(index * 0.7548776662466927, 1.0);
+    walker.lateralOffset = lateralSpread * (float)(lane - 0.5);
+    walker.speedScale = 1.0f + speedSpread * (float)(2.0 * speed - 1.0);
+    return walker;
+}
+
+// Phase of walker index among the count walkers, spread evenly along its
+// path with the first walker of each path at the start
+float walkerPhase(size_t index, size_t count)
+{
+    size_t pathCount = paths.size();
+    size_t onPath = (count - index % pathCount + pathCount - 1) / pathCount;
+    return (float)(index / pathCount) / onPath;
+}
+
+// Line the walkers up behind the one in front, STREAM_WALKER_SPACING segments
+// apart or closer if they would not fit in half the window. At the start the
+// last walker stands at the start of the stream.
+void lineUpOnStream()
+{
+    size_t count = figures.size();
+    double spacing = std::min((double)STREAM_WALKER_SPACING, 0.5 * streamPath->windowSegments() / count);
+    double front = streamPath->first() + spacing * (count - 1);
+    if (!streamCursors.empty())
+        front = std::max(front, streamCursors[0].segment + (double)streamCursors[0].u);
+
+    if (streamPath->available() <= (uint64_t)front)
+        std::cout << "Waiting for the stream..." << std::endl;
+    streamPath->waitFor((uint64_t)front + 1);
+    uint64_t available = streamPath->available();
+
+    streamCursors.resize(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        // A stream shorter than the line-up puts the front walkers at its end
+        double position = std::min(front - spacing * i, (double)available);
+        StreamCursor &cursor = streamCursors[i];
+        cursor.segment = (uint64_t)position;
+        cursor.u = (float)(position - cursor.segment);
+        if (cursor.segment == available && available > 0)
+        {
+            cursor.segment--;
+            cursor.u = 1.0f;
+        }
+        placeOnPath(figures[i], animStates[i], *streamPath, cursor);
+    }
+}
+
+// Give up the segments every walker has passed and redraw what is left
+void advanceStream()
+{
+    uint64_t behind = streamCursors.empty() ? 0 : streamCursors[0].segment;
+    for (const StreamCursor &cursor : streamCursors)
+        behind = std::min(behind, cursor.segment);
+    streamPath->release(behind);
+    if (!drawingStream)
+        return;
+
+    // Only rebuilt when a segment came or went
+    uint64_t first = streamPath->first();
+    uint64_t end = streamPath->available();
+    if (first == drawnStreamFirst && end == drawnStreamEnd)
+        return;
+    drawnStreamFirst = first;
+    drawnStreamEnd = end;
+
+    std::vector<Vec3> polyline;
+    polyline.reserve((end - first) * STREAM_DRAW_SAMPLES + 1);
+    for (uint64_t segment = first; segment < end; segment++)
+    {
+        for (int k = 0; k < STREAM_DRAW_SAMPLES; k++)
+            polyline.push_back(streamPath->evaluate(segment, (float)k / STREAM_DRAW_SAMPLES));
+    }
+    if (end > first)
+        polyline.push_back(streamPath->evaluate(end - 1, 1.0f));
+
+    std::lock_guard<std::mutex> lock(streamPolylineMutex);
+    streamPolyline.swap(polyline);
+}
+
+// Spread the walkers evenly along their paths
+void resetWalkers()
+{
+    if (streamPath)
+    {
+        lineUpOnStream();
+        footPlants.assign(figures.size(), FootPlanting());
+        separation.reset(figures.size());
+        return;
+    }
+
+    walkerPaths.resize(figures.size());
+    for (size_t i = 0; i < figures.size(); i++)
+    {
+        walkerPaths[i] = walkerPathFor(i);
+        placeOnPath(figures[i], animStates[i], walkerPaths[i], paths, walkerPhase(i, figures.size()));
+    }
+    footPlants.assign(figures.size(), FootPlanting());
+    separation.reset(figures.size());
+}
+
+// Walkers are independent, so chunks of them update in parallel; parallelFor
+// returns only when all are done, before the frame is drawn. Separation sees
+// every walker, so it runs between the gait update and the final placement.
+void updateWalkers(float deltaTime)
+{
+    jobSystem->parallelFor(figures.size(), jobChunkSize, [&](size_t begin, size_t end)
+    {
+        PROFILE_SCOPE("gait");
+        for (size_t i = begin; i < end; i++)
+        {
+            // The gait runs on the path point, without last step's offset
+            figures[i].position = figures[i].position - separation.offset(i);
+            if (streamPath)
+                updateWalkingAnimation(figures[i], animStates[i], *streamPath, streamCursors[i], deltaTime);
+            else
+                updateWalkingAnimation(figures[i], animStates[i], walkerPaths[i], paths, deltaTime);
+        }
+    });
+    if (streamPath)
+        advanceStream();
+
+    pathPositions.resize(figures.size());
+    for (size_t i = 0; i < figures.size(); i++)
+        pathPositions[i] = figures[i].position;
+    if (separating)
+    {
+        PROFILE_SCOPE("separation");
+        separation.update(pathPositions, deltaTime, jobSystem, jobChunkSize);
+    }
+
+    jobSystem->parallelFor(figures.size(), jobChunkSize, [&](size_t begin, size_t end)
+    {
+        PROFILE_SCOPE("placement");
+        for (size_t i = begin; i < end; i++)
+        {
+            figures[i].position += separation.offset(i);
+            if (footPlanting)
+                applyFootPlanting(figures[i], animStates[i], footPlants[i]);
+        }
+    });
+}
+
+void setConstantSpeed(bool enabled)
+{
+    // A stream has no arc-length table to walk by distance
+    if (streamPath)
+        return;
+
+    constantSpeed = enabled;
+    // Continue from the current point on the path
+    for (size_t i = 0; i < animStates.size(); i++)
+    {
+        walkerPaths[i].constantSpeed = enabled;
+        animStates[i].distance = paths[walkerPaths[i].path].arcLength.distanceAtParameter(animStates[i].t);
+    }
+}
+
+// Point the walkers at a rebuilt path. They keep their parameter and take
+// the file's dt; constant-speed walkers re-measure their distance.
+void swapPath(PathHandle handle, const SharedPath &path)
+{
+    paths.replace(handle, path);
+    for (size_t i = 0; i < animStates.size(); i++)
+    {
+        if (walkerPaths[i].path != handle)
+            continue;
+        animStates[i].dt = path->dt;
+        animStates[i].distance = path->arcLength.distanceAtParameter(animStates[i].t);
+    }
+}
+
+// Watch every path that was loaded from a file
+void startPathReloads(bool primaryFromFile, float tolerance)
+{
+    pathReloaders.resize(paths.size());
+    for (PathHandle handle = primaryFromFile ? 0 : 1; handle < paths.size(); handle++)
+    {
+        pathReloaders[handle].reset(new PathReloader());
+        if (!pathReloaders[handle]->start(paths.share(handle), tolerance))
+            pathReloaders[handle].reset();
+    }
+}
+
+// Swap in paths rebuilt since the last frame. The renderer takes the new
+// polyline at once; the simulation takes the path before its next tick.
+void applyPathReloads()
+{
+    for (PathHandle handle = 0; handle < pathReloaders.size(); handle++)
+    {
+        PathReload reload;
+        if (!pathReloaders[handle] || !pathReloaders[handle]->take(reload))
+            continue;
+        if (!reload.path)
+        {
+            std::cerr << "Could not reload " << pathReloaders[handle]->filename() << ", keeping the previous path" << std::endl;
+            continue;
+        }
+
+        std::cout << "Reloaded " << reload.path->name << ": " << reload.edit.rebuilt() << " of "
+                  << reload.edit.newCount << " segments rebuilt in " << reload.seconds * 1000.0 << " ms" << std::endl;
+        drawnPaths[handle] = reload.path;
+        setPathTessellation((int)handle, reload.tessellation);
+
+        SharedPath path = reload.path;
+        std::function<void()> swap = [handle, path]()
+        {
+            swapPath(handle, path);
+        };
+        if (simulationThread.isRunning())
+            simulationThread.post(swap);
+        else
+            swap();
+    }
+}
+
+// Apply one input to the walkers and add it to the recording. Speeds are
+// recorded after clamping so a replay sets exactly the same value.
+void applyInput(ReplayEventType type, float value)
+{
+    switch (type)
+    {
+    case REPLAY_ANIMATION_SPEED:
+        setAnimationSpeed(value);
+        value = animStates[0].animationSpeed;
+        break;
+    case REPLAY_WALK_SPEED:
+        setWalkSpeed(value);
+        value = animStates[0].walkSpeed;
+        break;
+    case REPLAY_RESET:
+        resetWalkers();
+        break;
+    case REPLAY_CONSTANT_SPEED:
+        setConstantSpeed(value != 0.0f);
+        break;
+    }
+
+    if (recordingReplay)
+        replayLog.record(simulationTick, type, value);
+}
+
+// One fixed step of the whole simulation
+void stepSimulation(float stepSeconds)
+{
+    PROFILE_SCOPE("simulation step");
+    updateWalkers(stepSeconds);
+    simulationTick++;
+}
+
+// Walker state belongs to the simulation thread while it runs, so changes
+// from input are queued for it; otherwise they apply immediately
+void changeSimulation(const std::function<void()> &change)
+{
+    if (simulationThread.isRunning())
+        simulationThread.post(change);
+    else
+        change();
+}
+
 // ============================================================================
 // GLFW CALLBACKS
 // ============================================================================
@@ -61,30 +661,62 @@ void keyCallback(GLFWwindow *window, int key, int scancode, int action, int mods
             break;
         case GLFW_KEY_EQUAL: // '+' key
         case GLFW_KEY_KP_ADD:
-            animState.animationSpeed += 0.01f;
-            std::cout << "Animation speed: " << animState.animationSpeed << std::endl;
+            changeSimulation([]
+            {
+                applyInput(REPLAY_ANIMATION_SPEED, animStates[0].animationSpeed + 0.01f);
+                std::cout << "Animation speed: " << animStates[0].animationSpeed << std::endl;
+            });
             break;
         case GLFW_KEY_MINUS:
         case GLFW_KEY_KP_SUBTRACT:
-            animState.animationSpeed -= 0.01f;
-            if (animState.animationSpeed < 0.01f)
-                animState.animationSpeed = 0.01f;
-            std::cout << "Animation speed: " << animState.animationSpeed << std::endl;
+            changeSimulation([]
+            {
+                applyInput(REPLAY_ANIMATION_SPEED, animStates[0].animationSpeed - 0.01f);
+                std::cout << "Animation speed: " << animStates[0].animationSpeed << std::endl;
+            });
             break;
         case GLFW_KEY_W:
-            animState.walkSpeed += 0.1f;
-            std::cout << "Walk speed (leg movement): " << animState.walkSpeed << std::endl;
+            changeSimulation([]
+            {
+                applyInput(REPLAY_WALK_SPEED, animStates[0].walkSpeed + 0.1f);
+                std::cout << "Walk speed (leg movement): " << animStates[0].walkSpeed << std::endl;
+            });
             break;
         case GLFW_KEY_S:
-            animState.walkSpeed -= 0.1f;
-            if (animState.walkSpeed < 0.1f)
-                animState.walkSpeed = 0.1f;
-            std::cout << "Walk speed (leg movement): " << animState.walkSpeed << std::endl;
+            changeSimulation([]
+            {
+                applyInput(REPLAY_WALK_SPEED, animStates[0].walkSpeed - 0.1f);
+                std::cout << "Walk speed (leg movement): " << animStates[0].walkSpeed << std::endl;
+            });
+            break;
+        case GLFW_KEY_C:
+            changeSimulation([]
+            {
+                applyInput(REPLAY_CONSTANT_SPEED, constantSpeed ? 0.0f : 1.0f);
+                std::cout << "Constant speed: " << (constantSpeed ? "on" : "off") << std::endl;
+            });
+            break;
+        case GLFW_KEY_P:
+            if (!PROFILING_ENABLED)
+            {
+                std::cout << "Profiling was compiled out (ENABLE_PROFILING is off)" << std::endl;
+                break;
+            }
+            showProfile = !showProfile;
+            if (!showProfile)
+                glfwSetWindowTitle(window, "Hierarchical Walking Animation");
+            std::cout << "Profile overlay (p50/p99 ms in the title): " << (showProfile ? "on" : "off") << std::endl;
+            break;
+        case GLFW_KEY_I:
+            useInstancing = !useInstancing;
+            std::cout << "Instanced crowd rendering: " << (useInstancing ? "on" : "off") << std::endl;
             break;
         case GLFW_KEY_R:
-            animState.t = 0.0f;
-            animState.walkCycle = 0.0f;
-            std::cout << "Animation reset" << std::endl;
+            changeSimulation([]
+            {
+                applyInput(REPLAY_RESET, 0.0f);
+                std::cout << "Animation reset" << std::endl;
+            });
             break;
         }
     }
@@ -146,7 +778,7 @@ void scrollCallback(GLFWwindow *window, double xoffset, double yoffset)
 // RENDERING LOOP
 // ============================================================================
 
-void render()
+void render(const std::vector<ArticulatedFigure> &poses)
 {
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -158,14 +790,575 @@ void render()
     float camY = cameraDistance * sin(cameraAngleX * PI / 180.0f);
     float camZ = cameraDistance * cos(cameraAngleY * PI / 180.0f) * cos(cameraAngleX * PI / 180.0f);
 
-    gluLookAt(figure.position.x + camX, figure.position.y + camY + 2, figure.position.z + camZ,
-              figure.position.x, figure.position.y + 1, figure.position.z,
+    const Vec3 &target = poses[0].position;
+    gluLookAt(target.x + camX, target.y + camY + 2, target.z + camZ,
+              target.x, target.y + 1, target.z,
               0, 1, 0);
 
     // Draw scene
-    drawGround();
-    drawSpline(controlPoints, splineType);
-    drawFigure(figure);
+    {
+        PROFILE_SCOPE("draw ground");
+        PROFILE_GPU_SCOPE(gpuTimer, "draw ground [GPU]");
+        drawGround();
+    }
+    {
+        PROFILE_SCOPE("draw path");
+        PROFILE_GPU_SCOPE(gpuTimer, "draw path [GPU]");
+        if (streamPath)
+        {
+            std::lock_guard<std::mutex> lock(streamPolylineMutex);
+            drawPolyline(streamPolyline);
+        }
+        for (PathHandle handle = 0; handle < drawnPaths.size(); handle++)
+            drawSpline(drawnPaths[handle]->spline, (int)handle);
+    }
+    {
+        PROFILE_SCOPE("draw figures");
+        PROFILE_GPU_SCOPE(gpuTimer, "draw figures [GPU]");
+        if (poses.size() == 1)
+            drawFigure(poses[0]);
+        else
+            drawCrowd(poses, useInstancing);
+    }
+}
+
+// Frame-time graph over the scene, and p50/p99 timings in the title twice a second
+void drawProfile()
+{
+    const ProfileStat *frame = profiler().stat("frame");
+    if (!frame)
+        return;
+
+    std::vector<float> history;
+    frame->history(history);
+    drawFrameTimeGraph(history, frame->percentile(0.5f), frame->percentile(0.99f), windowWidth, windowHeight);
+
+    double now = glfwGetTime();
+    if (now - lastTitleUpdate < 0.5)
+        return;
+    lastTitleUpdate = now;
+
+    std::string title = "Hierarchical Walking Animation";
+    const char *stages[] = {"frame", "update", "simulation step", "draw figures", "draw figures [GPU]", "swap buffers"};
+    for (const char *stage : stages)
+    {
+        if (const ProfileStat *stat = profiler().stat(stage))
+        {
+            char text[96];
+            snprintf(text, sizeof(text), " | %s %.2f/%.2f ms", stage, stat->percentile(0.5f), stat->percentile(0.99f));
+            title += text;
+        }
+    }
+    glfwSetWindowTitle(window, title.c_str());
+}
+
+// ============================================================================
+// PATH SETUP
+// ============================================================================
+
+void createDefaultPath(std::vector<Vec3> &points)
+{
+    points.clear();
+
+    // Create default circular path
+    for (int i = 0; i < 8; i++)
+    {
+        float angle = i * 2 * PI / 8;
+        points.push_back(Vec3(3 * cos(angle), 0, 3 * sin(angle)));
+    }
+    // Duplicate first few points for proper spline evaluation
+    for (int i = 0; i < 3; i++)
+    {
+        points.push_back(points[i]);
+    }
+}
+
+// Load the main path, or the default one if it cannot be read, and the
+// extra paths, which must load
+bool loadPaths(const CommandLineOptions &options, bool &primaryFromFile)
+{
+    // Control points may be text or binary
+    primaryFromFile = paths.load(options.filename, options.quiet) != INVALID_PATH;
+    if (!primaryFromFile)
+    {
+        std::cerr << "Failed to load control points. Using default path." << std::endl;
+        std::vector<Vec3> controlPoints;
+        createDefaultPath(controlPoints);
+        paths.add("default", controlPoints, CATMULL_ROM, animStates[0].dt);
+    }
+    for (const char *filename : options.extraPaths)
+    {
+        if (paths.load(filename, options.quiet) == INVALID_PATH)
+        {
+            std::cerr << "Failed to load path " << filename << std::endl;
+            return false;
+        }
+    }
+
+    animStates[0].dt = paths[0].dt;
+    for (PathHandle handle = 0; handle < paths.size(); handle++)
+        drawnPaths.push_back(paths.share(handle));
+    return true;
+}
+
+// ============================================================================
+// PROFILING
+// ============================================================================
+
+// Print per-stage percentiles and write the trace, if one was asked for
+void finishProfile(const CommandLineOptions &options)
+{
+    if (!PROFILING_ENABLED)
+        return;
+
+    // Export status goes to stderr so stdout stays free for frames
+    profiler().printSummary(options.exportOutput ? std::cerr : std::cout);
+    if (options.traceFile && profiler().writeTrace(options.traceFile))
+        std::cerr << "Wrote trace " << options.traceFile << std::endl;
+}
+
+// ============================================================================
+// HEADLESS MODE
+// ============================================================================
+
+// Run the crowd kernel next to the scalar walkers and count differing walkers
+int verifyCrowdKernel(HeadlessSimulation &simulation, CrowdState &crowd, const CommandLineOptions &options)
+{
+    long mismatches = 0;
+    for (int step = 0; step < options.stepCount; step++)
+    {
+        simulation.step(options.stepDt);
+        updateCrowdAnimation(crowd, paths[0].spline, options.stepDt, *jobSystem, jobChunkSize);
+
+        const std::vector<Walker> &walkers = simulation.walkers();
+        for (size_t i = 0; i < walkers.size(); i++)
+        {
+            if (!crowdWalkerMatches(crowd, i, walkers[i].figure, walkers[i].state))
+                mismatches++;
+        }
+    }
+
+    std::cout << "Crowd kernel (" << crowdKernelName() << ") vs scalar: "
+              << mismatches << " mismatching walker-steps" << std::endl;
+    return mismatches == 0 ? 0 : 1;
+}
+
+// Many short parallel loops in a row, as the update loops issue them, with
+// one item per chunk so threads finish early and steal. Every item must run
+// exactly once per loop; a lost chunk would hang the barrier instead.
+int verifyJobSystem(const CommandLineOptions &options)
+{
+    const size_t ITEMS = 64;
+    std::vector<int> runs(ITEMS, 0);
+    long mismatches = 0;
+    for (int loop = 0; loop < options.verifyJobs; loop++)
+    {
+        jobSystem->parallelFor(ITEMS, 1, [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; i++)
+                runs[i]++;
+        });
+        for (size_t i = 0; i < ITEMS; i++)
+        {
+            if (runs[i] != loop + 1)
+            {
+                mismatches++;
+                runs[i] = loop + 1;
+            }
+        }
+    }
+
+    std::cout << "Job system (" << jobSystem->threadCount() << " threads): " << options.verifyJobs
+              << " loops, " << mismatches << " items not run exactly once" << std::endl;
+    return mismatches == 0 ? 0 : 1;
+}
+
+void printStepStats(const SimulationStats &stats)
+{
+    std::cout << "Total time: " << stats.totalSeconds * 1000.0 << " ms" << std::endl;
+    std::cout << "Per step: avg " << stats.totalSeconds / stats.stepCount * 1e6
+              << " us, min " << stats.minStepSeconds * 1e6
+              << " us, max " << stats.maxStepSeconds * 1e6 << " us" << std::endl;
+    std::cout << "Throughput: " << stats.stepsPerSecond() << " steps/s, "
+              << stats.walkerUpdatesPerSecond() << " walker updates/s" << std::endl;
+}
+
+// Sample every walker's pose from a baked clip, each offset along the loop by
+// its phase, instead of evaluating the path and gait
+SimulationStats playClip(const AnimationClip &clip, const CommandLineOptions &options)
+{
+    typedef std::chrono::steady_clock Clock;
+
+    std::vector<ArticulatedFigure, CacheAlignedAllocator<ArticulatedFigure> > poses(options.walkerCount);
+    size_t chunkSize = cacheAlignedChunkSize(jobChunkSize, sizeof(ArticulatedFigure));
+    SimulationStats stats;
+    stats.walkerCount = options.walkerCount;
+    double time = 0.0;
+    for (int step = 0; step < options.stepCount; step++)
+    {
+        Clock::time_point start = Clock::now();
+        time += options.stepDt;
+        jobSystem->parallelFor(poses.size(), chunkSize, [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; i++)
+                clip.sample(time + clip.duration() * i / poses.size(), poses[i]);
+        });
+        stats.recordStep(std::chrono::duration<double>(Clock::now() - start).count());
+    }
+    return stats;
+}
+
+int runHeadless(const CommandLineOptions &options)
+{
+    typedef std::chrono::steady_clock Clock;
+
+    std::cout << "=== Headless simulation ===" << std::endl;
+    std::cout << "Walkers: " << options.walkerCount
+              << ", steps: " << options.stepCount
+              << ", step dt: " << options.stepDt << " s" << std::endl;
+    std::cout << "Threads: " << jobSystem->threadCount() << ", chunk: " << jobChunkSize << " walkers" << std::endl;
+
+    if (options.clipFile)
+    {
+        AnimationClip clip;
+        if (!clip.load(options.clipFile))
+            return 1;
+        std::cout << "Playback: baked clip " << options.clipFile << " (" << clip.frames() << " frames, "
+                  << clip.memoryBytes() / 1024.0 << " KB)" << std::endl;
+        printStepStats(playClip(clip, options));
+        return 0;
+    }
+
+    // Spread walkers evenly along their paths so they do not overlap
+    HeadlessSimulation simulation(paths);
+    simulation.setJobSystem(jobSystem, jobChunkSize);
+    for (int i = 0; i < options.walkerCount; i++)
+        simulation.addWalker(walkerPathFor(i), walkerPhase(i, options.walkerCount));
+    std::cout << "Paths: " << paths.size() << " shared, " << paths.memoryBytes() / 1024.0
+              << " KB; " << sizeof(WalkerPath) << " bytes of path state per walker" << std::endl;
+
+    // The crowd kernel covers the gait only, so its reference walkers skip
+    // foot planting and separation
+    bool kernel = options.soa || options.verifySoa;
+    bool planting = options.footPlanting && !kernel;
+    bool separate = options.separation && !kernel;
+    simulation.setFootPlanting(planting);
+    simulation.setSeparation(separate);
+    std::cout << "Foot planting: " << (planting ? "on" : "off")
+              << ", separation: " << (separate ? "on" : "off") << std::endl;
+
+    CrowdState crowd;
+    if (options.soa || options.verifySoa)
+    {
+        for (const Walker &walker : simulation.walkers())
+            crowd.addWalker(walker.figure, walker.state);
+    }
+
+    if (options.verifySoa)
+        return verifyCrowdKernel(simulation, crowd, options);
+
+    SimulationStats stats;
+    if (options.soa)
+    {
+        std::cout << "Kernel: structure-of-arrays (" << crowdKernelName() << ")" << std::endl;
+        stats.walkerCount = (int)crowd.size();
+        for (int i = 0; i < options.stepCount; i++)
+        {
+            Clock::time_point start = Clock::now();
+            updateCrowdAnimation(crowd, paths[0].spline, options.stepDt, *jobSystem, jobChunkSize);
+            stats.recordStep(std::chrono::duration<double>(Clock::now() - start).count());
+        }
+    }
+    else
+    {
+        stats = simulation.run(options.stepCount, options.stepDt);
+    }
+
+    printStepStats(stats);
+    if (planting)
+        std::cout << "Foot slip: " << simulation.footSlip() / options.walkerCount
+                  << " per walker (planted feet dragged past the leg's reach)" << std::endl;
+    return 0;
+}
+
+// Walk the walkers along a streaming path until it ends or the steps run
+// out, and report how fast it went and how little of the path was held
+int runStream(const CommandLineOptions &options)
+{
+    typedef std::chrono::steady_clock Clock;
+
+    std::cout << "=== Streaming path ===" << std::endl;
+    std::cout << "Walkers: " << options.walkerCount
+              << ", steps: " << options.stepCount
+              << ", step dt: " << options.stepDt << " s" << std::endl;
+    std::cout << "Threads: " << jobSystem->threadCount() << ", chunk: " << jobChunkSize << " walkers" << std::endl;
+
+    figures.resize(options.walkerCount);
+    animStates.resize(options.walkerCount, animStates[0]);
+    resetWalkers();
+    if (streamPath->available() == 0)
+    {
+        std::cerr << "The stream ended before its first segment" << std::endl;
+        return 1;
+    }
+
+    // Steps where the last walker waits at the newest segment for more
+    SimulationStats stats;
+    stats.walkerCount = options.walkerCount;
+    int waitingSteps = 0;
+    for (int step = 0; step < options.stepCount; step++)
+    {
+        Clock::time_point start = Clock::now();
+        stepSimulation(options.stepDt);
+        stats.recordStep(std::chrono::duration<double>(Clock::now() - start).count());
+
+        const StreamCursor &last = streamCursors.back();
+        if (last.segment + 1 < streamPath->available() || last.u < 1.0f)
+            continue;
+        if (streamPath->finished())
+            break;
+        waitingSteps++;
+    }
+
+    printStepStats(stats);
+    std::cout << "Stream: " << streamPath->pointsRead() << " points read, leader on segment "
+              << streamCursors[0].segment << (streamPath->finished() ? " (source ended)" : "") << std::endl;
+    std::cout << "Window: " << streamPath->windowSegments() << " segments, "
+              << streamPath->memoryBytes() / 1024.0 << " KB held" << std::endl;
+    if (waitingSteps > 0)
+        std::cout << "Walkers waited for the source on " << waitingSteps << " steps" << std::endl;
+    return 0;
+}
+
+// Rerun a recorded session tick for tick and compare the final state
+int runReplay(const CommandLineOptions &options)
+{
+    typedef std::chrono::steady_clock Clock;
+
+    ReplayLog log;
+    if (!log.load(options.replayFile))
+        return 1;
+
+    std::cout << "=== Replay ===" << std::endl;
+    std::cout << "Walkers: " << log.walkerCount << ", ticks: " << log.tickCount
+              << ", step: " << log.stepSeconds << " s, inputs: " << log.events.size() << std::endl;
+
+    paths.clear();
+    if (paths.add("replay", log.controlPoints, log.splineType, log.pathDt) == INVALID_PATH)
+    {
+        std::cerr << "Error: " << options.replayFile << " has too few control points" << std::endl;
+        return 1;
+    }
+    lateralSpread = log.lateralSpread;
+    speedSpread = log.speedSpread;
+    constantSpeed = log.constantSpeed;
+    footPlanting = log.footPlanting;
+    separating = log.separation;
+
+    AnimationState initial;
+    initial.dt = log.pathDt;
+    initial.animationSpeed = log.animationSpeed;
+    initial.walkSpeed = log.walkSpeed;
+    figures.assign(log.walkerCount, ArticulatedFigure());
+    animStates.assign(log.walkerCount, initial);
+    resetWalkers();
+
+    Clock::time_point start = Clock::now();
+    size_t nextEvent = 0;
+    for (uint64_t tick = 0; tick < log.tickCount; tick++)
+    {
+        while (nextEvent < log.events.size() && log.events[nextEvent].tick <= tick)
+        {
+            applyInput(log.events[nextEvent].type, log.events[nextEvent].value);
+            nextEvent++;
+        }
+        stepSimulation(log.stepSeconds);
+    }
+    // Inputs that arrived after the last tick
+    for (; nextEvent < log.events.size(); nextEvent++)
+        applyInput(log.events[nextEvent].type, log.events[nextEvent].value);
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    uint64_t hash = hashWalkers(figures, animStates);
+    std::cout << "Time: " << seconds * 1000.0 << " ms, "
+              << (seconds > 0.0 ? log.tickCount / seconds : 0.0) << " ticks/s" << std::endl;
+    std::cout << "State hash: " << std::hex << hash << ", recorded: " << log.stateHash << std::dec << std::endl;
+    if (hash != log.stateHash)
+    {
+        std::cout << "Replay diverged from the recording" << std::endl;
+        return 1;
+    }
+    std::cout << "Replay matches the recording" << std::endl;
+    return 0;
+}
+
+// Bake one loop of the walk with the loaded path and settings at the window's tick rate
+int runBakeClip(const CommandLineOptions &options)
+{
+    typedef std::chrono::steady_clock Clock;
+
+    float stepSeconds = (float)(1.0 / options.tickRate);
+    Clock::time_point start = Clock::now();
+    AnimationClip clip;
+    const PathData &path = paths[0];
+    if (!clip.bake(path.spline, constantSpeed ? &path.arcLength : nullptr, animStates[0], stepSeconds, ClipTolerance()))
+    {
+        std::cerr << "Failed to bake the walk" << std::endl;
+        return 1;
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    size_t rawBytes = (size_t)clip.frames() * CLIP_TRACK_COUNT * sizeof(float);
+    std::cout << "Baked " << clip.duration() << " s loop: " << clip.frames() << " frames at "
+              << options.tickRate << " Hz in " << seconds * 1000.0 << " ms" << std::endl;
+    std::cout << "Key frames: " << clip.keyCount() << " of " << clip.frames()
+              << ", " << clip.memoryBytes() / 1024.0 << " KB (" << rawBytes / 1024.0 << " KB as floats)" << std::endl;
+    float positionError = std::max({clip.maxError(CLIP_POSITION_X), clip.maxError(CLIP_POSITION_Y), clip.maxError(CLIP_POSITION_Z)});
+    float forwardError = std::max({clip.maxError(CLIP_FORWARD_X), clip.maxError(CLIP_FORWARD_Y), clip.maxError(CLIP_FORWARD_Z)});
+    std::cout << "Max error: position " << positionError << ", forward " << forwardError
+              << ", tilt " << clip.maxError(CLIP_BODY_TILT) << " deg, gait phase "
+              << clip.maxError(CLIP_WALK_CYCLE) << " rad" << std::endl;
+
+    if (!clip.save(options.bakeClip))
+        return 1;
+    std::cout << "Wrote animation clip " << options.bakeClip << std::endl;
+    return 0;
+}
+
+// ============================================================================
+// OFFLINE EXPORT
+// ============================================================================
+
+// Prefer a hidden GLFW window; without a display, fall back to a context
+// that has no window at all. Either way frames go to an offscreen framebuffer.
+bool createExportContext(int width, int height, bool &windowless)
+{
+    windowless = false;
+    if (glfwInit())
+    {
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        window = glfwCreateWindow(width, height, "Hierarchical Walking Animation", nullptr, nullptr);
+        if (window)
+        {
+            glfwMakeContextCurrent(window);
+            return true;
+        }
+        glfwTerminate();
+    }
+
+    if (!createOffscreenContext())
+        return false;
+    windowless = true;
+    return true;
+}
+
+// Render a fixed number of frames at the export frame rate, as fast as the
+// GPU and the output allow
+int runExport(const CommandLineOptions &options)
+{
+    typedef std::chrono::steady_clock Clock;
+
+    bool windowless;
+    if (!createExportContext(options.exportWidth, options.exportHeight, windowless))
+    {
+        std::cerr << "Failed to create an OpenGL context for export" << std::endl;
+        return 1;
+    }
+
+    // GLEW also looks for a GLX display, which a windowless context lacks;
+    // the GL entry points are loaded before that check fails
+    GLenum err = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+    if (windowless && err == GLEW_ERROR_NO_GLX_DISPLAY)
+        err = GLEW_OK;
+#endif
+    int status = 1;
+    if (err != GLEW_OK)
+    {
+        std::cerr << "Failed to initialize GLEW: " << glewGetErrorString(err) << std::endl;
+    }
+    else
+    {
+        initGL(options.exportWidth, options.exportHeight);
+        setPathTolerance(options.pathTolerance);
+        initCrowdRenderer();
+        if (PROFILING_ENABLED)
+            gpuTimer.init();
+
+        FrameExporter exporter;
+        if (exporter.open(options.exportOutput, options.exportFormat, options.exportWidth, options.exportHeight, options.exportFps))
+        {
+            // Status goes to stderr, which stays free when frames go to stdout
+            std::cerr << "=== Offline export ===" << std::endl;
+            std::cerr << "Frames: " << options.exportFrames << " at " << options.exportWidth << "x" << options.exportHeight
+                      << ", " << options.exportFps << " fps" << (windowless ? " (windowless)" : "") << std::endl;
+
+            figures.resize(options.crowdSize);
+            animStates.resize(options.crowdSize, animStates[0]);
+            resetWalkers();
+
+            // Same fixed steps as the window, paced by the export clock; a
+            // frame may need more steps than the interactive cap allows
+            double frameSeconds = 1.0 / options.exportFps;
+            int stepsPerFrame = (int)std::ceil(options.tickRate * frameSeconds) + 1;
+            FixedTimestep timestep(1.0 / options.tickRate, std::max(options.maxSubsteps, stepsPerFrame));
+            std::vector<ArticulatedFigure> previousFigures = figures;
+            renderFigures = figures;
+
+            Clock::time_point start = Clock::now();
+            for (int frame = 0; frame < options.exportFrames; frame++)
+            {
+                int steps = frame == 0 ? 0 : timestep.advance(frameSeconds);
+                for (int i = 0; i < steps; i++)
+                {
+                    if (i == steps - 1)
+                        previousFigures = figures;
+                    stepSimulation(timestep.stepSeconds());
+                }
+                interpolateFigures(previousFigures, figures, timestep.alpha(), renderFigures);
+
+                {
+                    PROFILE_SCOPE("frame");
+                    if (PROFILING_ENABLED)
+                        gpuTimer.beginFrame();
+                    exporter.beginFrame();
+                    render(renderFigures);
+                    {
+                        PROFILE_SCOPE("readback");
+                        exporter.endFrame();
+                    }
+                }
+                if (PROFILING_ENABLED)
+                    profiler().collect();
+            }
+
+            bool written = exporter.close();
+            double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+            if (PROFILING_ENABLED)
+                profiler().collect();
+            finishProfile(options);
+            std::cerr << "Exported " << options.exportFrames << " frames in " << seconds * 1000.0 << " ms ("
+                      << (seconds > 0.0 ? options.exportFrames / seconds : 0.0) << " frames/s)" << std::endl;
+            if (written)
+                status = 0;
+            else
+                std::cerr << "Error: Some frames could not be written to " << options.exportOutput << std::endl;
+        }
+        gpuTimer.release();
+        releaseCrowdRenderer();
+        releaseMeshCache();
+    }
+
+    if (windowless)
+    {
+        destroyOffscreenContext();
+    }
+    else
+    {
+        glfwDestroyWindow(window);
+        glfwTerminate();
+    }
+    return status;
 }
 
 // ============================================================================
@@ -174,35 +1367,84 @@ void render()
 
 int main(int argc, char **argv)
 {
+    CommandLineOptions options;
+    if (!parseCommandLine(argc, argv, options))
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    PROFILE_THREAD_NAME("main");
+    if (options.traceFile)
+    {
+        if (PROFILING_ENABLED)
+            profiler().startTrace();
+        else
+            std::cerr << "Profiling was compiled out (ENABLE_PROFILING is off); no trace will be written" << std::endl;
+    }
+
+    JobSystem jobs(options.threads);
+    jobSystem = &jobs;
+    jobChunkSize = options.chunkSize;
+
+    if (options.verifyJobs > 0)
+        return verifyJobSystem(options);
+    if (options.replayFile)
+        return runReplay(options);
+
+    // A stream replaces the paths; it is read while the walkers follow it
+    StreamingPath stream(options.streamWindow);
+    bool primaryFromFile = false;
+    if (options.streamSource)
+    {
+        if (!stream.open(options.streamSource))
+            return 1;
+        streamPath = &stream;
+        drawingStream = !options.headless;
+        drawnStreamFirst = drawnStreamEnd = 0;
+        streamPolyline.clear();
+    }
+    else if (!loadPaths(options, primaryFromFile))
+    {
+        return 1;
+    }
+
+    if (options.saveBinary)
+    {
+        const PathData &path = paths[0];
+        if (!saveBinaryPath(options.saveBinary, path.spline.controlPoints(), path.spline.type(), path.dt))
+            return 1;
+        std::cout << "Wrote binary path " << options.saveBinary << std::endl;
+        return 0;
+    }
+
+    lateralSpread = options.lateralSpread;
+    speedSpread = options.speedSpread;
+    constantSpeed = options.constantSpeed;
+    footPlanting = options.footPlanting;
+    separating = options.separation;
+    useInstancing = options.instancing;
+
+    if (options.bakeClip)
+        return runBakeClip(options);
+    if (options.headless)
+        return streamPath ? runStream(options) : runHeadless(options);
+    if (options.exportOutput)
+        return runExport(options);
+
     std::cout << "=== CS6555 Hierarchical Walking Animation (GLFW) ===" << std::endl;
     std::cout << "Controls:" << std::endl;
     std::cout << "  Mouse drag: Rotate camera" << std::endl;
     std::cout << "  Mouse wheel: Zoom in/out" << std::endl;
     std::cout << "  +/- keys: Adjust overall animation speed" << std::endl;
     std::cout << "  W/S keys: Adjust leg movement speed" << std::endl;
+    std::cout << "  C key: Toggle constant-speed walking" << std::endl;
+    std::cout << "  I key: Toggle instanced crowd rendering" << std::endl;
+    std::cout << "  P key: Toggle the frame-time graph and stage timings" << std::endl;
     std::cout << "  R key: Reset animation" << std::endl;
     std::cout << "  ESC: Exit" << std::endl;
     std::cout << std::endl;
 
-    // Load control points
-    const char *filename = (argc > 1) ? argv[1] : "control_points.txt";
-    if (!loadControlPoints(filename, controlPoints, splineType, animState.dt))
-    {
-        std::cerr << "Failed to load control points. Using default path." << std::endl;
-
-        // Create default circular path
-        for (int i = 0; i < 8; i++)
-        {
-            float angle = i * 2 * PI / 8;
-            controlPoints.push_back(Vec3(3 * cos(angle), 0, 3 * sin(angle)));
-        }
-        // Duplicate first few points for proper spline evaluation
-        for (int i = 0; i < 3; i++)
-        {
-            controlPoints.push_back(controlPoints[i]);
-        }
-    }
-
     // Initialize GLFW
     if (!glfwInit())
     {
@@ -241,31 +1483,122 @@ int main(int argc, char **argv)
 
     // Initialize OpenGL
     initGL(windowWidth, windowHeight);
+    setPathTolerance(options.pathTolerance);
+    if (!initCrowdRenderer())
+        std::cout << "Instanced rendering unavailable, using per-figure draws" << std::endl;
+    if (PROFILING_ENABLED && !gpuTimer.init())
+        std::cout << "GPU timer queries unavailable, timing the CPU side only" << std::endl;
+    showProfile = options.profile && PROFILING_ENABLED;
+
+    // Create the walkers shown in the window
+    figures.resize(options.crowdSize);
+    animStates.resize(options.crowdSize, animStates[0]);
+    resetWalkers();
 
     std::cout << "OpenGL Version: " << glGetString(GL_VERSION) << std::endl;
 
+    // Starting conditions of the recording
+    FixedTimestep timestep(1.0 / options.tickRate, options.maxSubsteps);
+    if (options.recordFile)
+    {
+        recordingReplay = true;
+        replayLog.controlPoints = paths[0].spline.controlPoints();
+        replayLog.splineType = paths[0].spline.type();
+        replayLog.pathDt = paths[0].dt;
+        replayLog.stepSeconds = timestep.stepSeconds();
+        replayLog.walkerCount = (uint32_t)figures.size();
+        replayLog.constantSpeed = constantSpeed;
+        replayLog.footPlanting = footPlanting;
+        replayLog.separation = separating;
+        replayLog.animationSpeed = animStates[0].animationSpeed;
+        replayLog.walkSpeed = animStates[0].walkSpeed;
+        replayLog.lateralSpread = lateralSpread;
+        replayLog.speedSpread = speedSpread;
+    }
+
+    // A recording holds the paths it started with, so they stay fixed
+    if (options.watch && options.recordFile)
+        std::cout << "Path files are not reloaded while recording" << std::endl;
+    else if (options.watch)
+        startPathReloads(primaryFromFile, options.pathTolerance);
+
+    // From here on only the simulation thread touches figures, animStates and paths
+    renderFigures = figures;
+    std::vector<ArticulatedFigure> previousFigures = figures;
+    if (options.simulationThread)
+    {
+        simulationThread.start(options.tickRate, options.maxSubsteps, stepSimulation, [](std::vector<ArticulatedFigure> &poses)
+        {
+            poses = figures;
+        });
+    }
+
     lastFrameTime = glfwGetTime();
 
     // Main loop
     while (!glfwWindowShouldClose(window))
     {
-        // Calculate delta time
-        double currentTime = glfwGetTime();
-        double deltaTime = currentTime - lastFrameTime;
-        lastFrameTime = currentTime;
+        {
+            PROFILE_SCOPE("frame");
+            if (PROFILING_ENABLED)
+                gpuTimer.beginFrame();
+            applyPathReloads();
+            {
+                PROFILE_SCOPE("update");
+                if (simulationThread.isRunning())
+                {
+                    // Blend the two newest ticks; keeps the last poses until the first tick
+                    simulationThread.interpolatedPoses(renderFigures);
+                }
+                else
+                {
+                    // Whole fixed steps for the time since the last frame
+                    double currentTime = glfwGetTime();
+                    int steps = timestep.advance(currentTime - lastFrameTime);
+                    lastFrameTime = currentTime;
+
+                    for (int i = 0; i < steps; i++)
+                    {
+                        if (i == steps - 1)
+                            previousFigures = figures;
+                        stepSimulation(timestep.stepSeconds());
+                    }
 
-        // Update animation
-        updateWalkingAnimation(figure, animState, controlPoints, splineType, deltaTime);
+                    // Blend the last two steps by the time left in the accumulator
+                    interpolateFigures(previousFigures, figures, timestep.alpha(), renderFigures);
+                }
+            }
+            render(renderFigures);
+            if (showProfile)
+                drawProfile();
 
-        // Render
-        render();
+            // Swap buffers and poll events
+            {
+                PROFILE_SCOPE("swap buffers");
+                glfwSwapBuffers(window);
+            }
+            glfwPollEvents();
+        }
 
-        // Swap buffers and poll events
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        // Gather this frame's timings from every thread
+        if (PROFILING_ENABLED)
+            profiler().collect();
     }
 
     // Cleanup
+    pathReloaders.clear();
+    simulationThread.stop();
+    finishProfile(options);
+    if (recordingReplay)
+    {
+        replayLog.tickCount = simulationTick;
+        replayLog.stateHash = hashWalkers(figures, animStates);
+        if (replayLog.save(options.recordFile))
+            std::cout << "Wrote replay log " << options.recordFile << " (" << simulationTick << " ticks)" << std::endl;
+    }
+    gpuTimer.release();
+    releaseCrowdRenderer();
+    releaseMeshCache();
     glfwDestroyWindow(window);
     glfwTerminate();
 